@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2025 Dapeng Feng
+ * All rights reserved.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "rustcxx_channel.hpp"
+
+namespace {
+
+ENUM_VARIANT1(Connect, std::uint32_t, address);
+ENUM_VARIANT2(Send, std::uint32_t, id, std::uint32_t, size);
+ENUM_VARIANT0(Disconnect);
+
+typedef rust::Enum<Connect, Send, Disconnect> NetworkMessage;
+
+const int messages_per_run = 1 << 16;
+
+// What the actor pipeline uses today: one mutex around a deque
+class MutexQueue {
+ public:
+  void push(NetworkMessage&& message) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      queue_.push_back(std::move(message));
+    }
+    ready_.notify_one();
+  }
+
+  NetworkMessage pop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    ready_.wait(lock, [this] { return !queue_.empty(); });
+    NetworkMessage message = std::move(queue_.front());
+    queue_.pop_front();
+    return message;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable ready_;
+  std::deque<NetworkMessage> queue_;
+};
+
+NetworkMessage make_message(int i) {
+  switch (i % 3) {
+    case 0:
+      return Connect(static_cast<std::uint32_t>(i));
+    case 1:
+      return Send(static_cast<std::uint32_t>(i), 64);
+    default:
+      return Disconnect();
+  }
+}
+
+void BM_MutexDeque(benchmark::State& state) {
+  const int producers = static_cast<int>(state.range(0));
+  const int per_producer = messages_per_run / producers;
+  for (auto _ : state) {
+    MutexQueue queue;
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+      threads.emplace_back([&queue, per_producer] {
+        for (int i = 0; i < per_producer; ++i) {
+          queue.push(make_message(i));
+        }
+      });
+    }
+    std::size_t sends = 0;
+    for (int i = 0; i < per_producer * producers; ++i) {
+      sends += queue.pop().is<Send>();
+    }
+    for (std::size_t i = 0; i < threads.size(); ++i) {
+      threads[i].join();
+    }
+    benchmark::DoNotOptimize(sends);
+  }
+  state.SetItemsProcessed(state.iterations() * per_producer * producers);
+}
+
+void BM_Channel(benchmark::State& state) {
+  const int producers = static_cast<int>(state.range(0));
+  const int per_producer = messages_per_run / producers;
+  for (auto _ : state) {
+    auto ch = rust::mpsc::channel<NetworkMessage>(1024);
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+      rust::mpsc::Sender<NetworkMessage> tx = ch.first;
+      threads.emplace_back([tx, per_producer]() mutable {
+        for (int i = 0; i < per_producer; ++i) {
+          tx.send(make_message(i));
+        }
+      });
+    }
+    { rust::mpsc::Sender<NetworkMessage> last = std::move(ch.first); }
+    std::size_t sends = 0;
+    const auto count = [&sends](NetworkMessage&& m) { sends += m.is<Send>(); };
+    for (;;) {
+      if (ch.second.try_recv_many(count, 64) != 0) {
+        continue;
+      }
+      rust::Result<NetworkMessage, rust::mpsc::RecvError> m = ch.second.recv();
+      if (m.is_err()) {
+        break;
+      }
+      count(std::move(m).unwrap_unchecked());
+    }
+    for (std::size_t i = 0; i < threads.size(); ++i) {
+      threads[i].join();
+    }
+    benchmark::DoNotOptimize(sends);
+  }
+  state.SetItemsProcessed(state.iterations() * per_producer * producers);
+}
+
+}  // namespace
+
+BENCHMARK(BM_MutexDeque)->Arg(1)->Arg(4)->Arg(16)->UseRealTime();
+BENCHMARK(BM_Channel)->Arg(1)->Arg(4)->Arg(16)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,435 @@
+/*
+ * Copyright (c) 2025 Dapeng Feng
+ * All rights reserved.
+ */
+
+// Hot paths of the core types next to their std counterparts. Run with
+// --benchmark_format=json (or the rustcxx_bench_json target) to keep a
+// record across changes.
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <variant>
+#include <vector>
+#include <version>
+
+#if defined(__cpp_lib_expected)
+#include <expected>
+#endif
+
+#include "rustcxx.hpp"
+#include "rustcxx_algorithm.hpp"
+
+namespace {
+
+const int input_size = 4096;
+
+// Pseudo-random sequence shared by every input, so that branches on the
+// data cannot be predicted
+std::vector<unsigned> make_noise() {
+  std::vector<unsigned> noise(input_size);
+  unsigned state = 12345u;
+  for (unsigned& n : noise) {
+    state = state * 1103515245u + 12345u;
+    n = state >> 8;
+  }
+  return noise;
+}
+
+// Enum::match and std::visit over N alternatives
+
+template <int N>
+struct Alt {
+  int value;
+};
+
+template <typename Seq>
+struct alternatives;
+
+template <std::size_t... Is>
+struct alternatives<rust::detail::index_sequence<Is...> > {
+  typedef rust::Enum<Alt<static_cast<int>(Is)>...> enum_type;
+  typedef std::variant<Alt<static_cast<int>(Is)>...> variant_type;
+
+  template <typename T>
+  static std::vector<T> input() {
+    typedef T (*make_fn)(int);
+    static const make_fn make[] = {
+        [](int v) { return T(Alt<static_cast<int>(Is)>{v}); }...};
+    const std::vector<unsigned> noise = make_noise();
+    std::vector<T> out;
+    out.reserve(noise.size());
+    for (std::size_t i = 0; i < noise.size(); ++i) {
+      out.push_back(make[noise[i] % sizeof...(Is)](static_cast<int>(i)));
+    }
+    return out;
+  }
+};
+
+template <std::size_t N>
+using alternatives_of =
+    alternatives<typename rust::detail::make_index_sequence<N>::type>;
+
+// Distinct work per arm so that the arms cannot be merged
+struct Visitor {
+  template <int I>
+  int operator()(const Alt<I>& a) const {
+    return a.value * (I + 1) + I;
+  }
+};
+
+template <std::size_t N>
+void BM_EnumMatch(benchmark::State& state) {
+  typedef typename alternatives_of<N>::enum_type element;
+  const std::vector<element> input =
+      alternatives_of<N>::template input<element>();
+  for (auto _ : state) {
+    int sum = 0;
+    for (const element& e : input) {
+      sum += e.match(Visitor());
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * input.size());
+}
+
+template <std::size_t N>
+void BM_StdVisit(benchmark::State& state) {
+  typedef typename alternatives_of<N>::variant_type element;
+  const std::vector<element> input =
+      alternatives_of<N>::template input<element>();
+  for (auto _ : state) {
+    int sum = 0;
+    for (const element& e : input) {
+      sum += std::visit(Visitor(), e);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * input.size());
+}
+
+// get_if loops: count and sum one alternative of four
+
+typedef alternatives_of<4> four;
+
+void BM_EnumGetIf(benchmark::State& state) {
+  const std::vector<four::enum_type> input =
+      four::input<four::enum_type>();
+  for (auto _ : state) {
+    int sum = 0;
+    for (const four::enum_type& e : input) {
+      if (const Alt<2>* a = e.get_if<Alt<2> >()) {
+        sum += a->value;
+      }
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * input.size());
+}
+
+void BM_StdGetIf(benchmark::State& state) {
+  const std::vector<four::variant_type> input =
+      four::input<four::variant_type>();
+  for (auto _ : state) {
+    int sum = 0;
+    for (const four::variant_type& e : input) {
+      if (const Alt<2>* a = std::get_if<Alt<2> >(&e)) {
+        sum += a->value;
+      }
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * input.size());
+}
+
+// Result combinator chains; about 1 in 16 inputs is an Err. The heap
+// payload is a string too long for the small-string buffer.
+
+struct Small {
+  typedef std::int64_t type;
+  static type make(unsigned n) { return static_cast<type>(n); }
+  static type step(const type& v) { return v * 3 + 1; }
+  static std::size_t weight(const type& v) {
+    return static_cast<std::size_t>(v);
+  }
+};
+
+struct Heap {
+  typedef std::string type;
+  static type make(unsigned n) { return std::string(32 + n % 32, 'x'); }
+  static type step(type&& v) {
+    v.push_back('y');
+    return std::move(v);
+  }
+  static std::size_t weight(const type& v) { return v.size(); }
+};
+
+template <typename Payload>
+void BM_ResultChain(benchmark::State& state) {
+  typedef typename Payload::type value_type;
+  typedef rust::Result<value_type, int> result;
+  const std::vector<unsigned> noise = make_noise();
+  for (auto _ : state) {
+    std::size_t total = 0;
+    for (unsigned n : noise) {
+      result r = n % 16 == 0 ? result::Err(static_cast<int>(n))
+                             : result::Ok(Payload::make(n));
+      result out =
+          std::move(r)
+              .map([](value_type&& v) { return Payload::step(std::move(v)); })
+              .and_then([](value_type&& v) {
+                return Payload::weight(v) % 7 == 0 ? result::Err(7)
+                                                   : result::Ok(std::move(v));
+              })
+              .map_err([](int e) { return e + 1; });
+      total += out.is_ok() ? Payload::weight(out.unwrap_unchecked())
+                           : static_cast<std::size_t>(out.unwrap_err_unchecked());
+    }
+    benchmark::DoNotOptimize(total);
+  }
+  state.SetItemsProcessed(state.iterations() * noise.size());
+}
+
+#if defined(__cpp_lib_expected)
+template <typename Payload>
+void BM_StdExpectedChain(benchmark::State& state) {
+  typedef typename Payload::type value_type;
+  typedef std::expected<value_type, int> expected;
+  const std::vector<unsigned> noise = make_noise();
+  for (auto _ : state) {
+    std::size_t total = 0;
+    for (unsigned n : noise) {
+      expected r = n % 16 == 0
+                       ? expected(std::unexpect, static_cast<int>(n))
+                       : expected(Payload::make(n));
+      // The same chain spelled out, as monadic operations need C++23's
+      // second revision of <expected>
+      expected out = r ? expected(Payload::step(std::move(*r)))
+                       : expected(std::unexpect, r.error());
+      if (out && Payload::weight(*out) % 7 == 0) {
+        out = expected(std::unexpect, 7);
+      }
+      if (!out) {
+        out = expected(std::unexpect, out.error() + 1);
+      }
+      total += out ? Payload::weight(*out)
+                   : static_cast<std::size_t>(out.error());
+    }
+    benchmark::DoNotOptimize(total);
+  }
+  state.SetItemsProcessed(state.iterations() * noise.size());
+}
+#endif
+
+// Option::Some and unwrap_or against std::optional and value_or
+
+template <typename Payload>
+void BM_OptionUnwrapOr(benchmark::State& state) {
+  typedef typename Payload::type value_type;
+  typedef rust::Option<value_type> option;
+  const std::vector<unsigned> noise = make_noise();
+  const value_type fallback = Payload::make(0);
+  for (auto _ : state) {
+    std::size_t total = 0;
+    for (unsigned n : noise) {
+      option o = n % 4 == 0 ? option::None() : option::Some(Payload::make(n));
+      total += Payload::weight(std::move(o).unwrap_or(fallback));
+    }
+    benchmark::DoNotOptimize(total);
+  }
+  state.SetItemsProcessed(state.iterations() * noise.size());
+}
+
+template <typename Payload>
+void BM_StdOptionalValueOr(benchmark::State& state) {
+  typedef typename Payload::type value_type;
+  typedef std::optional<value_type> optional;
+  const std::vector<unsigned> noise = make_noise();
+  const value_type fallback = Payload::make(0);
+  for (auto _ : state) {
+    std::size_t total = 0;
+    for (unsigned n : noise) {
+      optional o =
+          n % 4 == 0 ? optional() : optional(Payload::make(n));
+      total += Payload::weight(std::move(o).value_or(fallback));
+    }
+    benchmark::DoNotOptimize(total);
+  }
+  state.SetItemsProcessed(state.iterations() * noise.size());
+}
+
+// unwrap(): the checked path on Ok values, unchecked access, and the cost
+// of the throw when every value is an Err
+
+typedef rust::Result<int, int> IntResult;
+
+std::vector<IntResult> make_results(bool ok) {
+  const std::vector<unsigned> noise = make_noise();
+  std::vector<IntResult> out;
+  out.reserve(noise.size());
+  for (unsigned n : noise) {
+    const int v = static_cast<int>(n % 1000);
+    out.push_back(ok ? IntResult::Ok(v) : IntResult::Err(v));
+  }
+  return out;
+}
+
+void BM_UnwrapOk(benchmark::State& state) {
+  const std::vector<IntResult> input = make_results(true);
+  for (auto _ : state) {
+    int sum = 0;
+    for (const IntResult& r : input) {
+      sum += r.unwrap();
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * input.size());
+}
+
+void BM_UnwrapUnchecked(benchmark::State& state) {
+  const std::vector<IntResult> input = make_results(true);
+  for (auto _ : state) {
+    int sum = 0;
+    for (const IntResult& r : input) {
+      sum += r.unwrap_unchecked();
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * input.size());
+}
+
+void BM_UnwrapErrChecked(benchmark::State& state) {
+  const std::vector<IntResult> input = make_results(false);
+  for (auto _ : state) {
+    int failures = 0;
+    for (const IntResult& r : input) {
+      failures += r.is_err() ? 1 : r.unwrap_unchecked();
+    }
+    benchmark::DoNotOptimize(failures);
+  }
+  state.SetItemsProcessed(state.iterations() * input.size());
+}
+
+void BM_UnwrapErrThrows(benchmark::State& state) {
+  const std::vector<IntResult> input = make_results(false);
+  for (auto _ : state) {
+    int failures = 0;
+    for (const IntResult& r : input) {
+      try {
+        failures += r.unwrap();
+      } catch (const std::runtime_error&) {
+        ++failures;
+      }
+    }
+    benchmark::DoNotOptimize(failures);
+  }
+  state.SetItemsProcessed(state.iterations() * input.size());
+}
+
+// Discriminant scans: count_of over one alternative of four against the
+// index() loop it replaces, on 1-byte tags and 8-byte elements
+
+template <int I>
+struct Tag {};
+
+typedef rust::Enum<Tag<0>, Tag<1>, Tag<2>, Tag<3> > TagOnly;
+
+std::vector<TagOnly> make_tags() {
+  typedef TagOnly (*make_fn)();
+  static const make_fn make[] = {[] { return TagOnly(Tag<0>()); },
+                                 [] { return TagOnly(Tag<1>()); },
+                                 [] { return TagOnly(Tag<2>()); },
+                                 [] { return TagOnly(Tag<3>()); }};
+  const std::vector<unsigned> noise = make_noise();
+  std::vector<TagOnly> out;
+  for (unsigned n : noise) {
+    out.push_back(make[n % 4]());
+  }
+  return out;
+}
+
+template <typename E>
+std::vector<E> scan_input();
+
+template <>
+std::vector<TagOnly> scan_input<TagOnly>() {
+  return make_tags();
+}
+
+template <>
+std::vector<four::enum_type> scan_input<four::enum_type>() {
+  return four::input<four::enum_type>();
+}
+
+// Alternative 2 of an Enum, the one both loops count
+template <typename E>
+struct counted;
+
+template <typename... Ts>
+struct counted<rust::Enum<Ts...> > : rust::detail::type_at<2, Ts...> {};
+
+template <typename E>
+void BM_IndexLoop(benchmark::State& state) {
+  const std::vector<E> input = scan_input<E>();
+  for (auto _ : state) {
+    std::size_t count = 0;
+    for (const E& e : input) {
+      count += e.index() == 2;
+    }
+    benchmark::DoNotOptimize(count);
+  }
+  state.SetItemsProcessed(state.iterations() * input.size());
+}
+
+template <typename E>
+void BM_CountOf(benchmark::State& state) {
+  const std::vector<E> input = scan_input<E>();
+  for (auto _ : state) {
+    std::size_t count = rust::count_of<typename counted<E>::type>(input);
+    benchmark::DoNotOptimize(count);
+  }
+  state.SetItemsProcessed(state.iterations() * input.size());
+}
+
+}  // namespace
+
+BENCHMARK_TEMPLATE(BM_EnumMatch, 2);
+BENCHMARK_TEMPLATE(BM_StdVisit, 2);
+BENCHMARK_TEMPLATE(BM_EnumMatch, 4);
+BENCHMARK_TEMPLATE(BM_StdVisit, 4);
+BENCHMARK_TEMPLATE(BM_EnumMatch, 8);
+BENCHMARK_TEMPLATE(BM_StdVisit, 8);
+BENCHMARK_TEMPLATE(BM_EnumMatch, 16);
+BENCHMARK_TEMPLATE(BM_StdVisit, 16);
+
+BENCHMARK(BM_EnumGetIf);
+BENCHMARK(BM_StdGetIf);
+
+BENCHMARK_TEMPLATE(BM_ResultChain, Small);
+BENCHMARK_TEMPLATE(BM_ResultChain, Heap);
+#if defined(__cpp_lib_expected)
+BENCHMARK_TEMPLATE(BM_StdExpectedChain, Small);
+BENCHMARK_TEMPLATE(BM_StdExpectedChain, Heap);
+#endif
+
+BENCHMARK_TEMPLATE(BM_OptionUnwrapOr, Small);
+BENCHMARK_TEMPLATE(BM_OptionUnwrapOr, Heap);
+BENCHMARK_TEMPLATE(BM_StdOptionalValueOr, Small);
+BENCHMARK_TEMPLATE(BM_StdOptionalValueOr, Heap);
+
+BENCHMARK(BM_UnwrapOk);
+BENCHMARK(BM_UnwrapUnchecked);
+BENCHMARK(BM_UnwrapErrChecked);
+BENCHMARK(BM_UnwrapErrThrows);
+
+BENCHMARK_TEMPLATE(BM_IndexLoop, TagOnly);
+BENCHMARK_TEMPLATE(BM_CountOf, TagOnly);
+BENCHMARK_TEMPLATE(BM_IndexLoop, four::enum_type);
+BENCHMARK_TEMPLATE(BM_CountOf, four::enum_type);
+
+BENCHMARK_MAIN();
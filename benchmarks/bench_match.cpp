@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) 2025 Dapeng Feng
+ * All rights reserved.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <vector>
+
+#include "rustcxx.hpp"
+#include "rustcxx_algorithm.hpp"
+
+#if defined(_MSC_VER)
+#define BENCH_NOINLINE __declspec(noinline)
+#else
+#define BENCH_NOINLINE __attribute__((noinline))
+#endif
+
+namespace {
+
+template <int N>
+struct Alt {
+  int value;
+};
+
+template <typename Seq>
+struct make_variant;
+
+template <std::size_t... Is>
+struct make_variant<rust::detail::index_sequence<Is...>> {
+  typedef nonstd::variant<Alt<static_cast<int>(Is)>...> type;
+};
+
+template <typename Seq>
+struct make_storage;
+
+template <std::size_t... Is>
+struct make_storage<rust::detail::index_sequence<Is...>> {
+  typedef rust::detail::variadic_variant<Alt<static_cast<int>(Is)>...> type;
+};
+
+template <typename Seq>
+struct make_enum;
+
+template <std::size_t... Is>
+struct make_enum<rust::detail::index_sequence<Is...>> {
+  typedef rust::Enum<Alt<static_cast<int>(Is)>...> type;
+};
+
+template <std::size_t N>
+using variant_of =
+    typename make_variant<typename rust::detail::make_index_sequence<N>::type>::type;
+
+// Storage behind rust::Enum
+template <std::size_t N>
+using storage_of =
+    typename make_storage<typename rust::detail::make_index_sequence<N>::type>::type;
+
+template <std::size_t N>
+using enum_of =
+    typename make_enum<typename rust::detail::make_index_sequence<N>::type>::type;
+
+// Every arm does a little distinct work so the arms cannot be merged
+struct Visitor {
+  template <int I>
+  int operator()(const Alt<I>& a) const {
+    return a.value * (I + 1) + I;
+  }
+};
+
+// Visitor that accumulates into its own state, for match_all. The arms
+// are out of line, like the handlers of an event loop.
+struct Summer {
+  int sum = 0;
+
+  template <int I>
+  BENCH_NOINLINE void operator()(const Alt<I>& a) {
+    sum += Visitor()(a);
+  }
+};
+
+template <typename Variant, std::size_t... Is>
+std::vector<Variant> make_input(rust::detail::index_sequence<Is...>) {
+  typedef void (*emplace_fn)(std::vector<Variant>&, int);
+  static const emplace_fn emplace[] = {[](std::vector<Variant>& out, int v) {
+    out.push_back(Alt<static_cast<int>(Is)>{v});
+  }...};
+  std::vector<Variant> input;
+  input.reserve(4096);
+  // Pseudo-random alternative order defeats the branch predictor
+  unsigned state = 12345u;
+  for (int i = 0; i < 4096; ++i) {
+    state = state * 1103515245u + 12345u;
+    emplace[(state >> 16) % sizeof...(Is)](input, i);
+  }
+  return input;
+}
+
+template <std::size_t N>
+void BM_MatchNonstdVisit(benchmark::State& state) {
+  typedef variant_of<N> variant;
+  const std::vector<variant> input = make_input<variant>(
+      typename rust::detail::make_index_sequence<N>::type());
+  for (auto _ : state) {
+    int sum = 0;
+    for (const auto& v : input) {
+      sum += nonstd::visit(Visitor(), v);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * input.size());
+}
+
+template <std::size_t N>
+void BM_MatchTableVisit(benchmark::State& state) {
+  typedef variant_of<N> variant;
+  const std::vector<variant> input = make_input<variant>(
+      typename rust::detail::make_index_sequence<N>::type());
+  for (auto _ : state) {
+    int sum = 0;
+    for (const auto& v : input) {
+      sum += rust::detail::visit(Visitor(), v);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * input.size());
+}
+
+template <std::size_t N>
+void BM_EnumSwitchVisit(benchmark::State& state) {
+  typedef storage_of<N> storage;
+  const std::vector<storage> input = make_input<storage>(
+      typename rust::detail::make_index_sequence<N>::type());
+  for (auto _ : state) {
+    int sum = 0;
+    for (const auto& v : input) {
+      sum += rust::detail::visit_switch(Visitor(), v);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * input.size());
+}
+
+template <std::size_t N>
+void BM_EnumTableVisit(benchmark::State& state) {
+  typedef storage_of<N> storage;
+  const std::vector<storage> input = make_input<storage>(
+      typename rust::detail::make_index_sequence<N>::type());
+  for (auto _ : state) {
+    int sum = 0;
+    for (const auto& v : input) {
+      sum += rust::detail::visit(Visitor(), v);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * input.size());
+}
+
+template <std::size_t N>
+void BM_EnumLoopMatch(benchmark::State& state) {
+  typedef enum_of<N> element;
+  const std::vector<element> input = make_input<element>(
+      typename rust::detail::make_index_sequence<N>::type());
+  for (auto _ : state) {
+    Summer summer;
+    for (const auto& e : input) {
+      e.match(summer);
+    }
+    benchmark::DoNotOptimize(summer.sum);
+  }
+  state.SetItemsProcessed(state.iterations() * input.size());
+}
+
+template <std::size_t N>
+void BM_EnumMatchAll(benchmark::State& state) {
+  typedef enum_of<N> element;
+  const std::vector<element> input = make_input<element>(
+      typename rust::detail::make_index_sequence<N>::type());
+  for (auto _ : state) {
+    Summer summer;
+    rust::match_all(input, summer);
+    benchmark::DoNotOptimize(summer.sum);
+  }
+  state.SetItemsProcessed(state.iterations() * input.size());
+}
+
+template <std::size_t N>
+void BM_EnumMatchAllOrdered(benchmark::State& state) {
+  typedef enum_of<N> element;
+  const std::vector<element> input = make_input<element>(
+      typename rust::detail::make_index_sequence<N>::type());
+  for (auto _ : state) {
+    Summer summer;
+    rust::match_all(rust::preserve_order, input, summer);
+    benchmark::DoNotOptimize(summer.sum);
+  }
+  state.SetItemsProcessed(state.iterations() * input.size());
+}
+
+BENCHMARK_TEMPLATE(BM_MatchNonstdVisit, 2);
+BENCHMARK_TEMPLATE(BM_MatchTableVisit, 2);
+BENCHMARK_TEMPLATE(BM_MatchNonstdVisit, 4);
+BENCHMARK_TEMPLATE(BM_MatchTableVisit, 4);
+BENCHMARK_TEMPLATE(BM_MatchNonstdVisit, 8);
+BENCHMARK_TEMPLATE(BM_MatchTableVisit, 8);
+BENCHMARK_TEMPLATE(BM_MatchNonstdVisit, 16);
+BENCHMARK_TEMPLATE(BM_MatchTableVisit, 16);
+
+BENCHMARK_TEMPLATE(BM_EnumSwitchVisit, 2);
+BENCHMARK_TEMPLATE(BM_EnumTableVisit, 2);
+BENCHMARK_TEMPLATE(BM_EnumSwitchVisit, 4);
+BENCHMARK_TEMPLATE(BM_EnumTableVisit, 4);
+BENCHMARK_TEMPLATE(BM_EnumSwitchVisit, 8);
+BENCHMARK_TEMPLATE(BM_EnumTableVisit, 8);
+BENCHMARK_TEMPLATE(BM_EnumSwitchVisit, 16);
+BENCHMARK_TEMPLATE(BM_EnumTableVisit, 16);
+BENCHMARK_TEMPLATE(BM_EnumSwitchVisit, 32);
+BENCHMARK_TEMPLATE(BM_EnumTableVisit, 32);
+
+BENCHMARK_TEMPLATE(BM_EnumLoopMatch, 4);
+BENCHMARK_TEMPLATE(BM_EnumMatchAll, 4);
+BENCHMARK_TEMPLATE(BM_EnumMatchAllOrdered, 4);
+BENCHMARK_TEMPLATE(BM_EnumLoopMatch, 8);
+BENCHMARK_TEMPLATE(BM_EnumMatchAll, 8);
+BENCHMARK_TEMPLATE(BM_EnumMatchAllOrdered, 8);
+BENCHMARK_TEMPLATE(BM_EnumLoopMatch, 16);
+BENCHMARK_TEMPLATE(BM_EnumMatchAll, 16);
+BENCHMARK_TEMPLATE(BM_EnumMatchAllOrdered, 16);
+
+}  // namespace
+
+BENCHMARK_MAIN();
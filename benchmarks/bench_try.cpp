@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2025 Dapeng Feng
+ * All rights reserved.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "rustcxx.hpp"
+
+namespace {
+
+// Three layers of fallible calls over inputs of which about 1 in 64 fails
+// in the innermost layer; every layer propagates the failure outwards
+
+enum class Errc : unsigned char { negative = 1, overflow };
+
+struct Failure {
+  Failure(Errc e) : code(e) {}  // NOLINT
+  Errc code;
+};
+
+typedef rust::Result<std::int32_t, Errc> Parsed;
+typedef rust::Result<std::int32_t, Failure> Checked;
+
+std::vector<std::int32_t> make_inputs() {
+  std::vector<std::int32_t> inputs(4096);
+  unsigned state = 12345u;
+  for (std::size_t i = 0; i < inputs.size(); ++i) {
+    state = state * 1103515245u + 12345u;
+    const std::int32_t value = static_cast<std::int32_t>((state >> 8) % 1000);
+    inputs[i] = (state >> 24) % 64 == 0 ? -value : value;
+  }
+  return inputs;
+}
+
+// Error codes with out-parameters: the baseline
+int code_parse(std::int32_t raw, std::int32_t* out) {
+  if (raw < 0) {
+    return static_cast<int>(Errc::negative);
+  }
+  *out = raw;
+  return 0;
+}
+
+int code_scale(std::int32_t raw, std::int32_t* out) {
+  std::int32_t value;
+  if (int status = code_parse(raw, &value)) {
+    return status;
+  }
+  if (value > 100000) {
+    return static_cast<int>(Errc::overflow);
+  }
+  *out = value * 3;
+  return 0;
+}
+
+int code_total(std::int32_t raw, std::int32_t* out) {
+  std::int32_t value;
+  if (int status = code_scale(raw, &value)) {
+    return status;
+  }
+  *out = value + 1;
+  return 0;
+}
+
+// Results propagated by hand, as written before RUSTCXX_TRY
+Parsed result_parse(std::int32_t raw) {
+  if (raw < 0) {
+    return Parsed::Err(Errc::negative);
+  }
+  return Parsed::Ok(raw);
+}
+
+Checked manual_scale(std::int32_t raw) {
+  Parsed r = result_parse(raw);
+  if (r.is_err()) {
+    return Checked::Err(r.unwrap_err());
+  }
+  const std::int32_t value = r.unwrap();
+  if (value > 100000) {
+    return Checked::Err(Errc::overflow);
+  }
+  return Checked::Ok(value * 3);
+}
+
+Checked manual_total(std::int32_t raw) {
+  Checked r = manual_scale(raw);
+  if (r.is_err()) {
+    return Checked::Err(r.unwrap_err());
+  }
+  return Checked::Ok(r.unwrap() + 1);
+}
+
+// The same with RUSTCXX_TRY
+Checked try_scale(std::int32_t raw) {
+  const std::int32_t value = RUSTCXX_TRY(result_parse(raw));
+  if (value > 100000) {
+    return Checked::Err(Errc::overflow);
+  }
+  return Checked::Ok(value * 3);
+}
+
+Checked try_total(std::int32_t raw) {
+  return Checked::Ok(RUSTCXX_TRY(try_scale(raw)) + 1);
+}
+
+void BM_ErrorCode(benchmark::State& state) {
+  const std::vector<std::int32_t> inputs = make_inputs();
+  for (auto _ : state) {
+    std::int64_t sum = 0;
+    int failures = 0;
+    for (std::int32_t raw : inputs) {
+      std::int32_t value;
+      if (code_total(raw, &value) == 0) {
+        sum += value;
+      } else {
+        ++failures;
+      }
+    }
+    benchmark::DoNotOptimize(sum);
+    benchmark::DoNotOptimize(failures);
+  }
+  state.SetItemsProcessed(state.iterations() * inputs.size());
+}
+
+template <Checked (*Total)(std::int32_t)>
+void BM_Result(benchmark::State& state) {
+  const std::vector<std::int32_t> inputs = make_inputs();
+  for (auto _ : state) {
+    std::int64_t sum = 0;
+    int failures = 0;
+    for (std::int32_t raw : inputs) {
+      Checked r = Total(raw);
+      if (r.is_ok()) {
+        sum += r.unwrap_unchecked();
+      } else {
+        ++failures;
+      }
+    }
+    benchmark::DoNotOptimize(sum);
+    benchmark::DoNotOptimize(failures);
+  }
+  state.SetItemsProcessed(state.iterations() * inputs.size());
+}
+
+}  // namespace
+
+BENCHMARK(BM_ErrorCode);
+BENCHMARK_TEMPLATE(BM_Result, manual_total)->Name("BM_ManualPropagation");
+BENCHMARK_TEMPLATE(BM_Result, try_total)->Name("BM_Try");
+
+BENCHMARK_MAIN();
@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2025 Dapeng Feng
+ * All rights reserved.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "rustcxx_wire.hpp"
+
+namespace {
+
+ENUM_VARIANT1(Connect, std::string, address);
+ENUM_VARIANT2(Send, std::uint32_t, id, std::string, data);
+ENUM_VARIANT0(Disconnect);
+
+using NetworkMessage = rust::Enum<Connect, Send, Disconnect>;
+
+std::vector<NetworkMessage> make_messages() {
+  std::vector<NetworkMessage> messages;
+  messages.reserve(4096);
+  unsigned state = 12345u;
+  for (int i = 0; i < 4096; ++i) {
+    state = state * 1103515245u + 12345u;
+    switch ((state >> 16) % 3) {
+      case 0:
+        messages.push_back(Connect{"10.0.0." + std::to_string(i % 256)});
+        break;
+      case 1:
+        messages.push_back(
+            Send(static_cast<std::uint32_t>(i),
+                 std::string(16 + (state >> 8) % 240, 'x')));
+        break;
+      default:
+        messages.push_back(Disconnect());
+    }
+  }
+  return messages;
+}
+
+// What each service writes today: a match per message appending to a
+// std::string, with the same layout as the wire format
+void append_u32(std::string& out, std::uint32_t v) {
+  char bytes[4];
+  std::memcpy(bytes, &v, 4);
+  out.append(bytes, 4);
+}
+
+void hand_encode(const NetworkMessage& message, std::string& out) {
+  out.push_back(static_cast<char>(message.index()));
+  message.match(
+      [&out](const Connect& c) {
+        append_u32(out, static_cast<std::uint32_t>(c.address.size()));
+        out.append(c.address);
+      },
+      [&out](const Send& s) {
+        append_u32(out, s.id);
+        append_u32(out, static_cast<std::uint32_t>(s.data.size()));
+        out.append(s.data);
+      },
+      [](const Disconnect&) {});
+}
+
+bool read_u32(const char*& cur, const char* end, std::uint32_t& v) {
+  if (end - cur < 4) {
+    return false;
+  }
+  std::memcpy(&v, cur, 4);
+  cur += 4;
+  return true;
+}
+
+bool read_string(const char*& cur, const char* end, std::string& s) {
+  std::uint32_t size;
+  if (!read_u32(cur, end, size) || static_cast<std::uint32_t>(end - cur) < size) {
+    return false;
+  }
+  s.assign(cur, size);
+  cur += size;
+  return true;
+}
+
+// Hand-written decoder building owning messages
+bool hand_decode(const char*& cur, const char* end, NetworkMessage& out) {
+  if (cur == end) {
+    return false;
+  }
+  switch (*cur++) {
+    case 0: {
+      Connect c;
+      if (!read_string(cur, end, c.address)) {
+        return false;
+      }
+      out = std::move(c);
+      return true;
+    }
+    case 1: {
+      Send s;
+      if (!read_u32(cur, end, s.id) || !read_string(cur, end, s.data)) {
+        return false;
+      }
+      out = std::move(s);
+      return true;
+    }
+    case 2:
+      out = Disconnect();
+      return true;
+  }
+  return false;
+}
+
+std::size_t total_size(const std::vector<NetworkMessage>& messages) {
+  std::size_t size = 0;
+  for (const auto& m : messages) {
+    size += rust::wire::encoded_size(m);
+  }
+  return size;
+}
+
+void BM_EncodeHandWritten(benchmark::State& state) {
+  const std::vector<NetworkMessage> messages = make_messages();
+  std::string buffer;
+  for (auto _ : state) {
+    buffer.clear();
+    for (const auto& m : messages) {
+      hand_encode(m, buffer);
+    }
+    benchmark::DoNotOptimize(buffer.data());
+  }
+  state.SetBytesProcessed(state.iterations() * total_size(messages));
+}
+
+void BM_EncodeWire(benchmark::State& state) {
+  const std::vector<NetworkMessage> messages = make_messages();
+  std::vector<char> buffer(total_size(messages));
+  for (auto _ : state) {
+    char* cur = buffer.data();
+    char* const end = cur + buffer.size();
+    for (const auto& m : messages) {
+      cur += rust::wire::encode(m, cur, static_cast<std::size_t>(end - cur))
+                 .unwrap_unchecked();
+    }
+    benchmark::DoNotOptimize(cur);
+  }
+  state.SetBytesProcessed(state.iterations() * total_size(messages));
+}
+
+void BM_DecodeHandWritten(benchmark::State& state) {
+  const std::vector<NetworkMessage> messages = make_messages();
+  std::string buffer;
+  for (const auto& m : messages) {
+    hand_encode(m, buffer);
+  }
+  for (auto _ : state) {
+    const char* cur = buffer.data();
+    const char* const end = cur + buffer.size();
+    NetworkMessage message;
+    std::size_t count = 0;
+    while (hand_decode(cur, end, message)) {
+      ++count;
+    }
+    benchmark::DoNotOptimize(count);
+  }
+  state.SetBytesProcessed(state.iterations() * buffer.size());
+}
+
+void BM_DecodeWireViews(benchmark::State& state) {
+  const std::vector<NetworkMessage> messages = make_messages();
+  std::string buffer;
+  for (const auto& m : messages) {
+    rust::wire::encode_append(m, buffer);
+  }
+  for (auto _ : state) {
+    std::string_view input(buffer);
+    std::size_t count = 0;
+    while (!input.empty()) {
+      auto message = rust::wire::decode_prefix<NetworkMessage>(input);
+      if (message.is_err()) {
+        break;
+      }
+      benchmark::DoNotOptimize(message);
+      ++count;
+    }
+    benchmark::DoNotOptimize(count);
+  }
+  state.SetBytesProcessed(state.iterations() * buffer.size());
+}
+
+}  // namespace
+
+BENCHMARK(BM_EncodeHandWritten);
+BENCHMARK(BM_EncodeWire);
+BENCHMARK(BM_DecodeHandWritten);
+BENCHMARK(BM_DecodeWireViews);
+
+BENCHMARK_MAIN();
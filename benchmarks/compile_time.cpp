@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2025 Dapeng Feng
+ * All rights reserved.
+ */
+
+// Translation unit for the rustcxx_compile_time target: a typical mix of
+// Result, Option and Enum uses, compiled with a per-phase time report in
+// the default mode, in slim mode and with the common types declared
+// extern (RUSTCXX_COMPILE_TIME_EXTERN). Only compiled, never linked.
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "rustcxx.hpp"
+
+namespace app {
+
+enum class IoError : unsigned char { closed, timeout };
+
+struct Config {
+  std::string name;
+  int workers;
+};
+
+ENUM_VARIANT0(Idle);
+ENUM_VARIANT(Running, int pid);
+ENUM_VARIANT2(Failed, int, code, int, attempts);
+ENUM_VARIANT0(Stopped);
+
+typedef rust::Enum<Idle, Running, Failed, Stopped> State;
+typedef rust::Enum<int, std::string, Config> Value;
+
+}  // namespace app
+
+#if defined(RUSTCXX_COMPILE_TIME_EXTERN)
+RUSTCXX_EXTERN_TEMPLATE(rust::Result<int, std::string>);
+RUSTCXX_EXTERN_TEMPLATE(rust::Result<std::string, app::IoError>);
+RUSTCXX_EXTERN_TEMPLATE(rust::Result<app::Config, std::string>);
+RUSTCXX_EXTERN_TEMPLATE(rust::Option<int>);
+RUSTCXX_EXTERN_TEMPLATE(rust::Option<std::string>);
+RUSTCXX_EXTERN_TEMPLATE(rust::Enum<app::Idle, app::Running, app::Failed,
+                                   app::Stopped>);
+#endif
+
+namespace app {
+
+rust::Result<std::string, IoError> read_file(const std::string& path) {
+  if (path.empty()) {
+    return rust::Result<std::string, IoError>::Err(IoError::closed);
+  }
+  return rust::Result<std::string, IoError>::Ok(path + ".conf");
+}
+
+rust::Result<int, std::string> parse_workers(const std::string& text) {
+  if (text.size() > 64) {
+    return rust::Result<int, std::string>::Err("too long");
+  }
+  return rust::Result<int, std::string>::Ok(static_cast<int>(text.size()));
+}
+
+rust::Result<Config, std::string> load(const std::string& path) {
+  RUSTCXX_TRY_ASSIGN(
+      std::string text,
+      read_file(path).map_err([](IoError) { return std::string("io"); }));
+  RUSTCXX_TRY_ASSIGN(const int workers, parse_workers(text));
+  return rust::Result<Config, std::string>::Ok(Config{text, workers});
+}
+
+rust::Option<int> first_even(const std::vector<int>& values) {
+  for (int v : values) {
+    if (v % 2 == 0) {
+      return rust::Option<int>::Some(v);
+    }
+  }
+  return rust::Option<int>::None();
+}
+
+rust::Option<std::string> label(const State& state) {
+  return state.match(
+      [](const Idle&) { return rust::Option<std::string>::None(); },
+      [](const Running& r) {
+        return rust::Option<std::string>::Some(std::to_string(r.pid));
+      },
+      [](const Failed& f) {
+        return rust::Option<std::string>::Some(std::to_string(f.code));
+      },
+      [](const Stopped&) { return rust::Option<std::string>::None(); });
+}
+
+std::size_t weight(const Value& value) {
+  return value.match([](int) { return std::size_t(1); },
+                     [](const std::string& s) { return s.size(); },
+                     [](const Config& c) { return c.name.size(); });
+}
+
+std::size_t summary(const std::vector<State>& states,
+                    const std::vector<Value>& values) {
+  std::size_t total = 0;
+  for (const State& state : states) {
+    total += label(state).map([](const std::string& s) { return s.size(); })
+                 .unwrap_or(0);
+    if (state == State(Stopped())) {
+      ++total;
+    }
+  }
+  for (const Value& value : values) {
+    total += weight(value);
+  }
+  total += static_cast<std::size_t>(first_even({1, 3, 4}).unwrap_or(0));
+  total += load("server")
+               .map([](const Config& c) { return c.workers; })
+               .unwrap_or(0);
+  return total;
+}
+
+}  // namespace app
@@ -6,7 +6,7 @@
 #include <iostream>
 #include <string>
 
-#include "rustcxx/rustcxx.hpp"
+#include "rustcxx.hpp"
 
 using namespace rust;  // NOLINT
 
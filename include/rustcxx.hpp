@@ -4,336 +4,2891 @@
  */
 
 #pragma once
-#include <functional>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
 #include <stdexcept>
 #include <string>
+#include <tuple>
 #include <type_traits>
 #include <utility>
+
+// Language standard, as variant-lite and optional-lite detect it (MSVC
+// reports it in _MSVC_LANG)
+#if defined(_MSVC_LANG) && !defined(__clang__)
+#define RUSTCXX_CPLUSPLUS (_MSC_VER == 1900 ? 201103L : _MSVC_LANG)
+#else
+#define RUSTCXX_CPLUSPLUS __cplusplus
+#endif
+
+#define RUSTCXX_CPP14_OR_GREATER (RUSTCXX_CPLUSPLUS >= 201402L)
+#define RUSTCXX_CPP17_OR_GREATER (RUSTCXX_CPLUSPLUS >= 201703L)
+#define RUSTCXX_CPP20_OR_GREATER (RUSTCXX_CPLUSPLUS >= 202002L)
+
+// Slim mode: with RUSTCXX_CONFIG_SLIM=1 and a standard library that has
+// <variant> and <optional>, the core builds on std::variant and
+// std::optional and does not include variant-lite or optional-lite. The
+// nonstd namespace is then not declared. RUSTCXX_SLIM tells whether it
+// took effect.
+
+#if !defined(RUSTCXX_CONFIG_SLIM)
+#define RUSTCXX_CONFIG_SLIM 0
+#endif
+
+#if RUSTCXX_CONFIG_SLIM && RUSTCXX_CPP17_OR_GREATER && defined(__has_include)
+#if __has_include(<variant>) && __has_include(<optional>)
+#define RUSTCXX_SLIM 1
+#endif
+#endif
+
+#if !defined(RUSTCXX_SLIM)
+#define RUSTCXX_SLIM 0
+#endif
+
+#if RUSTCXX_SLIM
+#include <optional>
+#include <variant>
+#define RUSTCXX_USES_STD_VARIANT 1
+#define RUSTCXX_IN_PLACE_T(T) std::in_place_t
+#define RUSTCXX_IN_PLACE(T) std::in_place
+#else
 #include <optional.hpp> // optional-lite
 #include <variant.hpp>  // variant-lite
+#define RUSTCXX_USES_STD_VARIANT variant_USES_STD_VARIANT
+#define RUSTCXX_IN_PLACE_T(T) nonstd_lite_in_place_t(T)
+#define RUSTCXX_IN_PLACE(T) nonstd_lite_in_place(T)
+#endif
+
+namespace rust {
+namespace detail {
+
+// The namespace holding the variant and optional the core builds on
+#if RUSTCXX_SLIM
+namespace backend = ::std;
+#else
+namespace backend = ::nonstd;
+#endif
+
+}  // namespace detail
+}  // namespace rust
+
+// Visit engine behind rust::match and Enum::match:
+// - RUSTCXX_VISIT_NONSTD: nonstd::visit (std::visit when std::variant is used)
+// - RUSTCXX_VISIT_TABLE: array of function pointers indexed by index()
+
+#define RUSTCXX_VISIT_NONSTD 0
+#define RUSTCXX_VISIT_TABLE 1
+
+#if !defined(RUSTCXX_CONFIG_SELECT_VISIT)
+#define RUSTCXX_CONFIG_SELECT_VISIT RUSTCXX_VISIT_NONSTD
+#endif
+
+// Compact layout: an Enum whose alternatives are all empty, trivial tags
+// is stored as its discriminant alone (one byte for up to 254 tags)
+
+#if !defined(RUSTCXX_CONFIG_COMPACT_LAYOUT)
+#define RUSTCXX_CONFIG_COMPACT_LAYOUT 1
+#endif
+
+// Exceptions: failed unwrap()/get() calls throw std::runtime_error, or with
+// RUSTCXX_CONFIG_NO_EXCEPTIONS call the panic handler (see set_panic_handler).
+// Detected from the compiler flags like variant-lite and optional-lite.
+
+// Statistics: with RUSTCXX_CONFIG_STATS=1 every Result, Option and Enum
+// type counts its Ok/Err constructions, failed unwrap()/get() calls and
+// match() dispatch per alternative in relaxed atomics, read back with
+// rust::stats::snapshot(). Compiled out by default.
+
+#if !defined(RUSTCXX_CONFIG_STATS)
+#define RUSTCXX_CONFIG_STATS 0
+#endif
+
+#if RUSTCXX_CONFIG_STATS
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#endif
+
+#if !defined(RUSTCXX_CONFIG_NO_EXCEPTIONS)
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS) || defined(_CPPUNWIND)
+#define RUSTCXX_CONFIG_NO_EXCEPTIONS 0
+#else
+#define RUSTCXX_CONFIG_NO_EXCEPTIONS 1
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define RUSTCXX_LIKELY(x) __builtin_expect(!!(x), 1)
+#define RUSTCXX_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#define RUSTCXX_COLD __attribute__((cold, noinline))
+#elif defined(_MSC_VER)
+#define RUSTCXX_LIKELY(x) (x)
+#define RUSTCXX_UNLIKELY(x) (x)
+#define RUSTCXX_COLD __declspec(noinline)
+#else
+#define RUSTCXX_LIKELY(x) (x)
+#define RUSTCXX_UNLIKELY(x) (x)
+#define RUSTCXX_COLD
+#endif
+
+// constexpr for functions that C++11 does not allow to be constexpr (more
+// than a return statement, or non-const members)
+#if RUSTCXX_CPP14_OR_GREATER
+#define RUSTCXX_CONSTEXPR14 constexpr
+#else
+#define RUSTCXX_CONSTEXPR14
+#endif
+
+// Return type of the match() functions: deduced from C++14 on, so that
+// choosing between the ref-qualified overloads never instantiates a
+// visitor for the wrong qualifier; spelled out on C++11
+#if RUSTCXX_CPP14_OR_GREATER
+#define RUSTCXX_RETURN_TYPE(...) decltype(auto)
+#else
+#define RUSTCXX_RETURN_TYPE(...) __VA_ARGS__
+#endif
+
+// 1 when matching an Enum of empty tags is a constant expression: needs
+// C++14, the compact layout and the compare ladder (the jump table is a
+// function-local static), and no statistics
+#if RUSTCXX_CPP14_OR_GREATER && RUSTCXX_CONFIG_COMPACT_LAYOUT && \
+    RUSTCXX_CONFIG_SELECT_VISIT == RUSTCXX_VISIT_NONSTD && \
+    !RUSTCXX_CONFIG_STATS
+#define RUSTCXX_HAS_CONSTEXPR_MATCH 1
+#else
+#define RUSTCXX_HAS_CONSTEXPR_MATCH 0
+#endif
+
+// 1 when ENUM_VARIANT(name, decls...) gets a defaulted memberwise
+// operator==; before C++20 it compares the bytes of trivially copyable
+// structs instead
+#if RUSTCXX_CPP20_OR_GREATER && defined(__cpp_impl_three_way_comparison)
+#define RUSTCXX_HAS_DEFAULTED_EQUALITY 1
+#else
+#define RUSTCXX_HAS_DEFAULTED_EQUALITY 0
+#endif
+
+// Error propagation like Rust's `?`. RUSTCXX_TRY(expr) evaluates to the Ok
+// (or Some) value of expr, or returns its Err from the enclosing function,
+// converted by rust::From, with one branch on the discriminant:
+//
+//   rust::Result<Config, AppError> load(const char* path) {
+//     std::string text = RUSTCXX_TRY(read_file(path));  // Result<_, IoError>
+//     return parse_config(text);
+//   }
+//
+// It is a GNU statement expression (GCC, Clang). RUSTCXX_TRY_ASSIGN(decl,
+// expr) is the portable statement form: RUSTCXX_TRY_ASSIGN(auto text, ...);
+// The value is moved out of an rvalue expr and copied out of an lvalue.
+
+#define RUSTCXX_TRY_CONCAT_(a, b) a##b
+#define RUSTCXX_TRY_CONCAT(a, b) RUSTCXX_TRY_CONCAT_(a, b)
+
+#define RUSTCXX_TRY_TRAITS(value) \
+  ::rust::try_<typename std::decay<decltype(value)>::type>
+
+#define RUSTCXX_TRY_FORWARD(value) static_cast<decltype(value)&&>(value)
+
+// Binds expr to value and returns its residual when it stops
+#define RUSTCXX_TRY_BIND_(value, ...)                                \
+  auto&& value = (__VA_ARGS__);                                      \
+  if (RUSTCXX_UNLIKELY(RUSTCXX_TRY_TRAITS(value)::is_break(value))) { \
+    return RUSTCXX_TRY_TRAITS(value)::residual(                      \
+        RUSTCXX_TRY_FORWARD(value));                                 \
+  }
+
+#define RUSTCXX_TRY_OUTPUT_(value) \
+  RUSTCXX_TRY_TRAITS(value)::output(RUSTCXX_TRY_FORWARD(value))
+
+#define RUSTCXX_TRY_ASSIGN_(value, decl, ...) \
+  RUSTCXX_TRY_BIND_(value, __VA_ARGS__)       \
+  decl = RUSTCXX_TRY_OUTPUT_(value)
+
+#define RUSTCXX_TRY_ASSIGN(decl, ...)                                     \
+  RUSTCXX_TRY_ASSIGN_(RUSTCXX_TRY_CONCAT(rustcxx_try_, __LINE__), decl, \
+                      __VA_ARGS__)
+
+#if defined(__GNUC__) || defined(__clang__)
+#define RUSTCXX_HAS_TRY_EXPRESSION 1
+#define RUSTCXX_TRY(...)                                \
+  __extension__({                                       \
+    RUSTCXX_TRY_BIND_(rustcxx_try_value, __VA_ARGS__)   \
+    RUSTCXX_TRY_OUTPUT_(rustcxx_try_value);             \
+  })
+#else
+#define RUSTCXX_HAS_TRY_EXPRESSION 0
+#endif
+
+// Explicit instantiation of Result, Option and Enum types used across many
+// translation units, so that their non-template members are compiled once:
+//
+//   // config.hpp
+//   RUSTCXX_EXTERN_TEMPLATE(rust::Result<Config, std::string>);
+//   // config.cpp
+//   RUSTCXX_INSTANTIATE_TEMPLATE(rust::Result<Config, std::string>);
+//
+// Every member gets instantiated, so the types must support all of them
+// (copy, comparison, hashing); template members stay implicit.
+#define RUSTCXX_EXTERN_TEMPLATE(...) extern template class __VA_ARGS__
+#define RUSTCXX_INSTANTIATE_TEMPLATE(...) template class __VA_ARGS__
 
 namespace rust {
 
-// Helper struct for creating overloaded visitors (C++17 compatible)
-template <class... Ts>
-struct overloads : Ts... {
-  using Ts::operator()...;
+template <typename... Types>
+class Enum;
+
+// Receives the message of a failed unwrap()/get() in builds without
+// exceptions. It must not return; if it does, the process aborts.
+typedef void (*panic_handler)(const char* message);
+
+namespace detail {
+
+inline void default_panic_handler(const char* message) {
+  std::fprintf(stderr, "rustcxx panic: %s\n", message);
+  std::abort();
+}
+
+inline panic_handler& current_panic_handler() noexcept {
+  static panic_handler handler = &default_panic_handler;
+  return handler;
+}
+
+}  // namespace detail
+
+// Installs a panic handler (NULL restores the default, which prints the
+// message to stderr and aborts) and returns the previous one
+inline panic_handler set_panic_handler(panic_handler handler) noexcept {
+  panic_handler previous = detail::current_panic_handler();
+  detail::current_panic_handler() =
+      handler ? handler : &detail::default_panic_handler;
+  return previous;
+}
+
+// Reports a broken unwrap()/get() precondition: throws std::runtime_error,
+// or calls the panic handler when built without exceptions
+[[noreturn]] RUSTCXX_COLD inline void panic(const char* message) {
+#if RUSTCXX_CONFIG_NO_EXCEPTIONS
+  detail::current_panic_handler()(message);
+  std::abort();
+#else
+  throw std::runtime_error(message);
+#endif
+}
+
+namespace detail {
+
+// Number of alternatives whose match() hits a type counts
+template <typename T>
+struct stats_alternatives : std::integral_constant<std::size_t, 0> {};
+
+template <typename... Types>
+struct stats_alternatives<Enum<Types...> >
+    : std::integral_constant<std::size_t, sizeof...(Types)> {};
+
+// Names of those alternatives; specialized for Enum below variant_traits
+template <typename T>
+struct stats_names {
+  static const char* at(std::size_t) noexcept { return ""; }
+};
+
+}  // namespace detail
+
+#if RUSTCXX_CONFIG_STATS
+
+namespace detail {
+
+// Counters of one type; records form a list that is only ever pushed to
+struct stats_record {
+  const char* signature;
+  const char* (*alternative_name)(std::size_t);
+  std::size_t alternatives;
+  std::atomic<std::uint64_t>* matches;
+  std::atomic<std::uint64_t> ok;
+  std::atomic<std::uint64_t> err;
+  std::atomic<std::uint64_t> panics;
+  stats_record* next;
+};
+
+inline std::atomic<stats_record*>& stats_head() noexcept {
+  static std::atomic<stats_record*> head(NULL);
+  return head;
+}
+
+// Function signature that spells out T, trimmed by stats_type_name
+template <typename T>
+inline const char* stats_signature() noexcept {
+#if defined(_MSC_VER) && !defined(__clang__)
+  return __FUNCSIG__;
+#else
+  return __PRETTY_FUNCTION__;
+#endif
+}
+
+inline std::string stats_type_name(const char* signature) {
+  const std::string text(signature);
+#if defined(_MSC_VER) && !defined(__clang__)
+  const std::string open = "stats_signature<", close = ">(void)";
+  const std::size_t end = text.rfind(close);
+#else
+  const std::string open = "T = ";
+  const std::size_t end = text.rfind(']');
+#endif
+  const std::size_t begin = text.find(open);
+  if (begin == std::string::npos || end == std::string::npos ||
+      end < begin + open.size()) {
+    return text;
+  }
+  return text.substr(begin + open.size(), end - begin - open.size());
+}
+
+// The record of T, registered on first use
+template <typename T>
+class stats_of {
+ public:
+  static stats_record& record() noexcept {
+    static slot instance;
+    return instance.record;
+  }
+
+ private:
+  static const std::size_t alternatives = stats_alternatives<T>::value;
+
+  struct slot {
+    std::atomic<std::uint64_t> matches[alternatives ? alternatives : 1];
+    stats_record record;
+
+    slot() noexcept {
+      for (std::size_t i = 0; i < alternatives; ++i) {
+        matches[i].store(0, std::memory_order_relaxed);
+      }
+      record.signature = stats_signature<T>();
+      record.alternative_name = &stats_names<T>::at;
+      record.alternatives = alternatives;
+      record.matches = matches;
+      record.ok.store(0, std::memory_order_relaxed);
+      record.err.store(0, std::memory_order_relaxed);
+      record.panics.store(0, std::memory_order_relaxed);
+      record.next = stats_head().load(std::memory_order_relaxed);
+      while (!stats_head().compare_exchange_weak(record.next, &record,
+                                                 std::memory_order_release,
+                                                 std::memory_order_relaxed)) {
+      }
+    }
+  };
+};
+
+template <typename T>
+const std::size_t stats_of<T>::alternatives;
+
+// Counts a match() on alternative index of T; valueless Enums count nothing
+template <typename T>
+inline void stats_match(std::size_t index) noexcept {
+  stats_record& record = stats_of<T>::record();
+  if (index < record.alternatives) {
+    record.matches[index].fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+}  // namespace detail
+
+// Increment a counter of Type; expressions of type void
+#define RUSTCXX_STATS_COUNT(Type, counter)                         \
+  (::rust::detail::stats_of<Type>::record().counter.fetch_add(     \
+       1, std::memory_order_relaxed),                              \
+   void())
+#define RUSTCXX_STATS_MATCH(Type, index) \
+  ::rust::detail::stats_match<Type>(index)
+
+namespace stats {
+
+// Counters of one Result, Option or Enum type
+struct TypeStats {
+  std::string type;
+  std::uint64_t ok;      // Result::Ok constructions
+  std::uint64_t err;     // Result::Err constructions
+  std::uint64_t panics;  // failed unwrap(), unwrap_err() and get() calls
+  // Enum::match and rust::match hits per alternative, with the names the
+  // ENUM_VARIANT macros recorded (empty otherwise)
+  std::vector<std::uint64_t> matches;
+  std::vector<std::string> alternatives;
+
+  // Share of constructions that were Err
+  double err_rate() const noexcept {
+    return ok + err == 0 ? 0.0
+                         : static_cast<double>(err) /
+                               static_cast<double>(ok + err);
+  }
+};
+
+}  // namespace stats
+
+namespace detail {
+
+inline stats::TypeStats stats_entry(const stats_record& record) {
+  stats::TypeStats entry;
+  entry.type = stats_type_name(record.signature);
+  entry.ok = record.ok.load(std::memory_order_relaxed);
+  entry.err = record.err.load(std::memory_order_relaxed);
+  entry.panics = record.panics.load(std::memory_order_relaxed);
+  for (std::size_t i = 0; i < record.alternatives; ++i) {
+    entry.matches.push_back(record.matches[i].load(std::memory_order_relaxed));
+    entry.alternatives.push_back(record.alternative_name(i));
+  }
+  return entry;
+}
+
+}  // namespace detail
+
+namespace stats {
+
+// Counters of every type used so far, most recently first used first.
+// Counts from other threads may be in flight. The spelling of a type name
+// can differ between translation units.
+inline std::vector<TypeStats> snapshot() {
+  std::vector<TypeStats> out;
+  for (const detail::stats_record* r =
+           detail::stats_head().load(std::memory_order_acquire);
+       r != NULL; r = r->next) {
+    out.push_back(detail::stats_entry(*r));
+  }
+  return out;
+}
+
+// Counters of T alone
+template <typename T>
+inline TypeStats of() {
+  return detail::stats_entry(detail::stats_of<T>::record());
+}
+
+// Zeroes every counter
+inline void reset() noexcept {
+  for (detail::stats_record* r =
+           detail::stats_head().load(std::memory_order_acquire);
+       r != NULL; r = r->next) {
+    r->ok.store(0, std::memory_order_relaxed);
+    r->err.store(0, std::memory_order_relaxed);
+    r->panics.store(0, std::memory_order_relaxed);
+    for (std::size_t i = 0; i < r->alternatives; ++i) {
+      r->matches[i].store(0, std::memory_order_relaxed);
+    }
+  }
+}
+
+}  // namespace stats
+
+#else
+
+#define RUSTCXX_STATS_COUNT(Type, counter) void()
+#define RUSTCXX_STATS_MATCH(Type, index) void()
+
+#endif
+
+namespace detail {
+
+// C++11 stand-in for std::index_sequence
+template <std::size_t... Is>
+struct index_sequence {};
+
+template <std::size_t N, std::size_t... Is>
+struct make_index_sequence : make_index_sequence<N - 1, N - 1, Is...> {};
+
+template <std::size_t... Is>
+struct make_index_sequence<0, Is...> {
+  typedef index_sequence<Is...> type;
+};
+
+template <typename... Ts>
+struct type_list {};
+
+// void when T is well-formed, for SFINAE-friendly traits
+template <typename T>
+struct void_type {
+  typedef void type;
+};
+
+// Type of the I-th entry of Ts...
+template <std::size_t I, typename... Ts>
+struct type_at;
+
+template <typename T, typename... Ts>
+struct type_at<0, T, Ts...> {
+  typedef T type;
+};
+
+template <std::size_t I, typename T, typename... Ts>
+struct type_at<I, T, Ts...> : type_at<I - 1, Ts...> {};
+
+// Index of the first T in Ts..., sizeof...(Ts) if absent
+template <typename T, typename... Ts>
+struct index_of : std::integral_constant<std::size_t, 0> {};
+
+template <typename T, typename U, typename... Ts>
+struct index_of<T, U, Ts...>
+    : std::integral_constant<std::size_t,
+                             std::is_same<T, U>::value
+                                 ? 0
+                                 : 1 + index_of<T, Ts...>::value> {};
+
+template <bool... Bs>
+struct bool_pack {};
+
+template <bool... Bs>
+struct all_of
+    : std::is_same<bool_pack<true, Bs...>, bool_pack<Bs..., true> > {};
+
+template <std::size_t... Ns>
+struct static_max;
+
+template <std::size_t N>
+struct static_max<N> : std::integral_constant<std::size_t, N> {};
+
+template <std::size_t N, std::size_t M, std::size_t... Ns>
+struct static_max<N, M, Ns...>
+    : static_max<(N > M ? N : M), Ns...> {};
+
+// Narrowest unsigned type that holds N alternatives plus the valueless state
+template <std::size_t N>
+struct index_type {
+  typedef typename std::conditional<
+      (N < 255), unsigned char,
+      typename std::conditional<(N < 65535), unsigned short,
+                                unsigned int>::type>::type type;
+};
+
+template <std::size_t I>
+struct alternative_tag {};
+
+// Overload set T0(i = 0), T1(i = 1), ... used to pick the alternative a
+// converting constructor targets, the same way std::variant does
+template <std::size_t I, typename... Ts>
+struct alternative_selector {
+  static void select();
+};
+
+template <std::size_t I, typename T, typename... Ts>
+struct alternative_selector<I, T, Ts...> : alternative_selector<I + 1, Ts...> {
+  using alternative_selector<I + 1, Ts...>::select;
+  static std::integral_constant<std::size_t, I> select(T);
+};
+
+template <typename U, typename... Ts>
+using selected_alternative =
+    decltype(alternative_selector<0, Ts...>::select(std::declval<U>()));
+
+// Types whose equality is the equality of their bytes: integers, enums,
+// pointers, and ENUM_VARIANTn structs of such fields without padding
+template <typename T, typename = void>
+struct is_bitwise_comparable
+    : std::integral_constant<bool, std::is_integral<T>::value ||
+                                       std::is_enum<T>::value ||
+                                       std::is_pointer<T>::value> {};
+
+template <typename T>
+struct is_bitwise_comparable<
+    T, typename void_type<decltype(T::rustcxx_bitwise_comparable())>::type>
+    : std::integral_constant<bool, T::rustcxx_bitwise_comparable()> {};
+
+template <typename T>
+inline bool equal_values(const T& lhs, const T& rhs, std::true_type) noexcept {
+  return std::memcmp(&lhs, &rhs, sizeof(T)) == 0;
+}
+
+template <typename T>
+inline bool equal_values(const T& lhs, const T& rhs, std::false_type) {
+  return lhs == rhs;
+}
+
+template <typename T>
+inline bool equal_values(const T& lhs, const T& rhs) {
+  return equal_values(lhs, rhs, is_bitwise_comparable<T>());
+}
+
+// Type-erased special members of one alternative
+template <typename T>
+struct alternative_ops {
+  static void destroy(void* p) { static_cast<T*>(p)->~T(); }
+
+  static void copy_construct(void* dst, const void* src) {
+    ::new (dst) T(*static_cast<const T*>(src));
+  }
+
+  static void move_construct(void* dst, void* src) {
+    ::new (dst) T(std::move(*static_cast<T*>(src)));
+  }
+
+  static void copy_assign(void* dst, const void* src) {
+    copy_assign(dst, src, std::is_copy_assignable<T>());
+  }
+
+  static void move_assign(void* dst, void* src) {
+    move_assign(dst, src, std::is_move_assignable<T>());
+  }
+
+  static bool equal(const void* lhs, const void* rhs) {
+    return equal_values(*static_cast<const T*>(lhs),
+                        *static_cast<const T*>(rhs));
+  }
+
+ private:
+  static void copy_assign(void* dst, const void* src, std::true_type) {
+    *static_cast<T*>(dst) = *static_cast<const T*>(src);
+  }
+
+  static void copy_assign(void* dst, const void* src, std::false_type) {
+    destroy(dst);
+    copy_construct(dst, src);
+  }
+
+  static void move_assign(void* dst, void* src, std::true_type) {
+    *static_cast<T*>(dst) = std::move(*static_cast<T*>(src));
+  }
+
+  static void move_assign(void* dst, void* src, std::false_type) {
+    destroy(dst);
+    move_construct(dst, src);
+  }
+};
+
+// Selects the niche constructor of a variadic_variant
+struct niche_tag {};
+
+// Storage shared by every variadic_variant. The alternatives live in a
+// byte buffer sized and aligned for the largest of them; the
+// per-operation tables are indexed by the active index.
+template <typename... Ts>
+class variant_storage {
+ public:
+  static_assert(sizeof...(Ts) > 0, "an Enum needs at least one alternative");
+
+  typedef typename index_type<sizeof...(Ts)>::type index_t;
+
+  static constexpr index_t npos = static_cast<index_t>(-1);
+
+  // One past the last alternative: unused by the Enum itself, it encodes
+  // None when the Enum sits inside an Option (see niche_traits)
+  static constexpr index_t niche = static_cast<index_t>(sizeof...(Ts));
+
+  variant_storage() : index_(npos) {}
+
+  template <std::size_t I, typename... Args>
+  explicit variant_storage(alternative_tag<I>, Args&&... args)
+      : index_(npos) {
+    construct<I>(std::forward<Args>(args)...);
+  }
+
+  explicit variant_storage(niche_tag) noexcept : index_(niche) {}
+
+  std::size_t index() const noexcept {
+    return index_ == npos ? static_cast<std::size_t>(-1)
+                          : static_cast<std::size_t>(index_);
+  }
+
+  bool valueless_by_exception() const noexcept { return index_ == npos; }
+
+  bool is_niche() const noexcept { return index_ == niche; }
+
+  // Unchecked access: the caller guarantees index() == I
+  template <std::size_t I>
+  typename type_at<I, Ts...>::type& get() & noexcept {
+    return *static_cast<typename type_at<I, Ts...>::type*>(data());
+  }
+
+  template <std::size_t I>
+  const typename type_at<I, Ts...>::type& get() const& noexcept {
+    return *static_cast<const typename type_at<I, Ts...>::type*>(data());
+  }
+
+  template <std::size_t I>
+  typename type_at<I, Ts...>::type&& get() && noexcept {
+    return std::move(*static_cast<typename type_at<I, Ts...>::type*>(data()));
+  }
+
+  template <std::size_t I>
+  const typename type_at<I, Ts...>::type&& get() const&& noexcept {
+    return std::move(
+        *static_cast<const typename type_at<I, Ts...>::type*>(data()));
+  }
+
+  // Replace the active alternative; valueless if the constructor throws
+  template <std::size_t I, typename... Args>
+  typename type_at<I, Ts...>::type& emplace(Args&&... args) {
+    destroy();
+    construct<I>(std::forward<Args>(args)...);
+    return get<I>();
+  }
+
+  bool operator==(const variant_storage& other) const {
+    if (index_ != other.index_) {
+      return false;
+    }
+    if (!engaged()) {
+      return true;
+    }
+    static bool (*const table[])(const void*, const void*) = {
+        &alternative_ops<Ts>::equal...};
+    return table[index_](data(), other.data());
+  }
+
+  bool operator!=(const variant_storage& other) const {
+    return !(*this == other);
+  }
+
+ protected:
+  template <std::size_t I, typename... Args>
+  void construct(Args&&... args) {
+    typedef typename type_at<I, Ts...>::type type;
+    ::new (data()) type(std::forward<Args>(args)...);
+    index_ = static_cast<index_t>(I);
+  }
+
+  void destroy() noexcept {
+    if (!all_of<std::is_trivially_destructible<Ts>::value...>::value &&
+        engaged()) {
+      static void (*const table[])(void*) = {&alternative_ops<Ts>::destroy...};
+      table[index_](data());
+    }
+    index_ = npos;
+  }
+
+  // Holds an alternative (neither valueless nor the niche)
+  bool engaged() const noexcept { return index_ < sizeof...(Ts); }
+
+  void* data() noexcept { return data_; }
+  const void* data() const noexcept { return data_; }
+
+  alignas(Ts...) unsigned char data_[static_max<sizeof(Ts)...>::value];
+  index_t index_;
+};
+
+// Trivially copyable alternatives: the buffer is copied bytewise and
+// nothing needs destroying, so every special member stays trivial
+template <typename... Ts>
+class trivial_variant_base : public variant_storage<Ts...> {
+ public:
+  using variant_storage<Ts...>::variant_storage;
+
+  trivial_variant_base() = default;
+};
+
+// Copies, moves and destroys the active alternative through the
+// per-operation tables
+template <typename... Ts>
+class variant_base : public variant_storage<Ts...> {
+  typedef variant_storage<Ts...> base;
+
+ public:
+  using base::base;
+
+  variant_base() = default;
+
+  variant_base(const variant_base& other) : base() {
+    if (other.engaged()) {
+      static void (*const table[])(void*, const void*) = {
+          &alternative_ops<Ts>::copy_construct...};
+      table[other.index_](this->data(), other.data());
+    }
+    this->index_ = other.index_;
+  }
+
+  variant_base(variant_base&& other) noexcept(
+      all_of<std::is_nothrow_move_constructible<Ts>::value...>::value)
+      : base() {
+    if (other.engaged()) {
+      static void (*const table[])(void*, void*) = {
+          &alternative_ops<Ts>::move_construct...};
+      table[other.index_](this->data(), other.data());
+    }
+    this->index_ = other.index_;
+  }
+
+  variant_base& operator=(const variant_base& other) {
+    if (this == &other) {
+      return *this;
+    }
+    if (this->index_ == other.index_ && this->engaged()) {
+      static void (*const table[])(void*, const void*) = {
+          &alternative_ops<Ts>::copy_assign...};
+      table[this->index_](this->data(), other.data());
+    } else {
+      this->destroy();
+      if (other.engaged()) {
+        static void (*const table[])(void*, const void*) = {
+            &alternative_ops<Ts>::copy_construct...};
+        table[other.index_](this->data(), other.data());
+      }
+      this->index_ = other.index_;
+    }
+    return *this;
+  }
+
+  variant_base& operator=(variant_base&& other) noexcept(
+      all_of<std::is_nothrow_move_constructible<Ts>::value...>::value &&
+      all_of<std::is_nothrow_move_assignable<Ts>::value...>::value) {
+    if (this == &other) {
+      return *this;
+    }
+    if (this->index_ == other.index_ && this->engaged()) {
+      static void (*const table[])(void*, void*) = {
+          &alternative_ops<Ts>::move_assign...};
+      table[this->index_](this->data(), other.data());
+    } else {
+      this->destroy();
+      if (other.engaged()) {
+        static void (*const table[])(void*, void*) = {
+            &alternative_ops<Ts>::move_construct...};
+        table[other.index_](this->data(), other.data());
+      }
+      this->index_ = other.index_;
+    }
+    return *this;
+  }
+
+  ~variant_base() { this->destroy(); }
+};
+
+#if RUSTCXX_CPP14_OR_GREATER
+template <typename T>
+struct is_final : std::is_final<T> {};
+#else
+template <typename T>
+struct is_final : std::integral_constant<bool, __is_final(T)> {};
+#endif
+
+// Alternatives that carry no state and need no construction, copy or
+// destruction can share the discriminant's storage
+template <typename T>
+struct is_stateless_alternative
+    : std::integral_constant<
+          bool, std::is_empty<T>::value &&
+                    std::is_trivially_default_constructible<T>::value &&
+                    std::is_trivially_copyable<T>::value &&
+                    !is_final<T>::value> {};
+
+template <std::size_t I, typename T>
+struct stateless_leaf : T {
+  stateless_leaf() = default;
+};
+
+template <typename Seq, typename... Ts>
+class tag_variant_base_impl;
+
+// Storage for Enums whose alternatives are all stateless: the
+// alternatives are empty bases, so the object is just the discriminant.
+template <std::size_t... Is, typename... Ts>
+class tag_variant_base_impl<index_sequence<Is...>, Ts...>
+    : private stateless_leaf<Is, Ts>... {
+ public:
+  typedef typename index_type<sizeof...(Ts)>::type index_t;
+
+  template <std::size_t I, typename... Args>
+  constexpr explicit tag_variant_base_impl(alternative_tag<I>, Args&&... args)
+      : index_((static_cast<void>(typename type_at<I, Ts...>::type(
+                    std::forward<Args>(args)...)),
+                static_cast<index_t>(I))) {}
+
+  constexpr explicit tag_variant_base_impl(niche_tag) noexcept
+      : index_(static_cast<index_t>(sizeof...(Ts))) {}
+
+  constexpr std::size_t index() const noexcept { return index_; }
+
+  constexpr bool valueless_by_exception() const noexcept { return false; }
+
+  constexpr bool is_niche() const noexcept { return index_ == sizeof...(Ts); }
+
+  template <std::size_t I>
+  RUSTCXX_CONSTEXPR14 typename type_at<I, Ts...>::type& get() & noexcept {
+    return static_cast<stateless_leaf<I, typename type_at<I, Ts...>::type>&>(
+        *this);
+  }
+
+  template <std::size_t I>
+  constexpr const typename type_at<I, Ts...>::type& get() const& noexcept {
+    return static_cast<
+        const stateless_leaf<I, typename type_at<I, Ts...>::type>&>(*this);
+  }
+
+  template <std::size_t I>
+  RUSTCXX_CONSTEXPR14 typename type_at<I, Ts...>::type&& get() && noexcept {
+    return std::move(
+        static_cast<stateless_leaf<I, typename type_at<I, Ts...>::type>&>(
+            *this));
+  }
+
+  template <std::size_t I>
+  const typename type_at<I, Ts...>::type&& get() const&& noexcept {
+    return std::move(
+        static_cast<const stateless_leaf<I, typename type_at<I, Ts...>::type>&>(
+            *this));
+  }
+
+  template <std::size_t I, typename... Args>
+  typename type_at<I, Ts...>::type& emplace(Args&&... args) {
+    static_cast<void>(
+        typename type_at<I, Ts...>::type(std::forward<Args>(args)...));
+    index_ = static_cast<index_t>(I);
+    return get<I>();
+  }
+
+  bool operator==(const tag_variant_base_impl& other) const {
+    if (index_ != other.index_) {
+      return false;
+    }
+    if (is_niche()) {
+      return true;
+    }
+    static bool (*const table[])(const tag_variant_base_impl&,
+                                 const tag_variant_base_impl&) = {
+        &equal<Is>...};
+    return table[index_](*this, other);
+  }
+
+  bool operator!=(const tag_variant_base_impl& other) const {
+    return !(*this == other);
+  }
+
+ private:
+  template <std::size_t I>
+  static bool equal(const tag_variant_base_impl& lhs,
+                    const tag_variant_base_impl& rhs) {
+    return lhs.get<I>() == rhs.get<I>();
+  }
+
+  index_t index_;
+};
+
+template <typename... Ts>
+using tag_variant_base =
+    tag_variant_base_impl<typename make_index_sequence<sizeof...(Ts)>::type,
+                          Ts...>;
+
+template <typename... Ts>
+struct use_tag_storage
+    : std::integral_constant<
+          bool, RUSTCXX_CONFIG_COMPACT_LAYOUT &&
+                    all_of<is_stateless_alternative<Ts>::value...>::value> {};
+
+template <typename... Ts>
+using storage_base = typename std::conditional<
+    use_tag_storage<Ts...>::value, tag_variant_base<Ts...>,
+    typename std::conditional<
+        all_of<std::is_trivially_copyable<Ts>::value...>::value,
+        trivial_variant_base<Ts...>, variant_base<Ts...> >::type>::type;
+
+// Deletes the copy/move members of variadic_variant that an alternative
+// does not support; the defaulted members below inherit the deletion.
+template <bool Copy, bool Move>
+struct enable_copy_move {};
+
+template <>
+struct enable_copy_move<false, true> {
+  enable_copy_move() = default;
+  enable_copy_move(const enable_copy_move&) = delete;
+  enable_copy_move(enable_copy_move&&) = default;
+  enable_copy_move& operator=(const enable_copy_move&) = delete;
+  enable_copy_move& operator=(enable_copy_move&&) = default;
+};
+
+template <>
+struct enable_copy_move<false, false> {
+  enable_copy_move() = default;
+  enable_copy_move(const enable_copy_move&) = delete;
+  enable_copy_move(enable_copy_move&&) = delete;
+  enable_copy_move& operator=(const enable_copy_move&) = delete;
+  enable_copy_move& operator=(enable_copy_move&&) = delete;
+};
+
+template <>
+struct enable_copy_move<true, false> {
+  enable_copy_move() = default;
+  enable_copy_move(const enable_copy_move&) = default;
+  enable_copy_move(enable_copy_move&&) = delete;
+  enable_copy_move& operator=(const enable_copy_move&) = default;
+  enable_copy_move& operator=(enable_copy_move&&) = delete;
+};
+
+// Variadic tagged union backing Enum and Result. Unlike variant-lite it
+// has no upper bound on the number of alternatives, and it allows the
+// same type to appear more than once (alternatives are addressed by
+// index).
+template <typename... Ts>
+class variadic_variant
+    : public storage_base<Ts...>,
+      private enable_copy_move<
+          all_of<std::is_copy_constructible<Ts>::value...>::value,
+          all_of<std::is_move_constructible<Ts>::value...>::value> {
+  typedef storage_base<Ts...> base;
+
+ public:
+  static constexpr std::size_t size = sizeof...(Ts);
+
+  typedef typename base::index_t index_t;
+
+  // Value-initializes the first alternative
+  constexpr variadic_variant() : base(alternative_tag<0>()) {}
+
+  template <std::size_t I, typename... Args>
+  constexpr explicit variadic_variant(alternative_tag<I> tag, Args&&... args)
+      : base(tag, std::forward<Args>(args)...) {}
+
+  explicit variadic_variant(niche_tag tag) noexcept : base(tag) {}
+
+  // Converting constructor: picks the alternative like std::variant
+  template <typename U,
+            typename D = typename std::decay<U>::type,
+            typename = typename std::enable_if<
+                !std::is_same<D, variadic_variant>::value>::type,
+            std::size_t I = selected_alternative<U, Ts...>::value>
+  constexpr variadic_variant(U&& u)  // NOLINT(runtime/explicit)
+      : base(alternative_tag<I>(), std::forward<U>(u)) {}
+
+  variadic_variant(const variadic_variant&) = default;
+  variadic_variant(variadic_variant&&) = default;
+  variadic_variant& operator=(const variadic_variant&) = default;
+  variadic_variant& operator=(variadic_variant&&) = default;
+
+  // Converting assignment: assigns in place when the alternative matches
+  template <typename U,
+            typename D = typename std::decay<U>::type,
+            typename = typename std::enable_if<
+                !std::is_same<D, variadic_variant>::value>::type,
+            std::size_t I = selected_alternative<U, Ts...>::value>
+  variadic_variant& operator=(U&& u) {
+    if (this->index() == I) {
+      this->template get<I>() = std::forward<U>(u);
+    } else {
+      this->template emplace<I>(std::forward<U>(u));
+    }
+    return *this;
+  }
+};
+
+template <typename T>
+struct is_variadic_variant : std::false_type {};
+
+template <typename... Ts>
+struct is_variadic_variant<variadic_variant<Ts...> > : std::true_type {};
+
+// Types the engines here visit directly through index() and
+// get_alternative<I>() rather than handing them to nonstd::visit
+template <typename T>
+struct is_indexed_variant : is_variadic_variant<T> {};
+
+template <typename Variant>
+struct variant_size_impl : backend::variant_size<Variant> {};
+
+template <typename... Ts>
+struct variant_size_impl<variadic_variant<Ts...> >
+    : std::integral_constant<std::size_t, sizeof...(Ts)> {};
+
+template <typename Variant>
+struct variant_size
+    : variant_size_impl<typename std::decay<Variant>::type> {};
+
+// Access to alternative I with the value category of the variant. The
+// caller guarantees index() == I; for nonstd/std variants dereferencing
+// get_if lets the compiler drop the redundant index check.
+template <std::size_t I, typename Variant>
+inline auto get_alternative(Variant&& variant)
+    -> decltype(backend::get<I>(std::forward<Variant>(variant))) {
+  typedef decltype(backend::get<I>(std::forward<Variant>(variant))) value_type;
+  return static_cast<value_type>(*backend::get_if<I>(&variant));
+}
+
+template <std::size_t I, typename... Ts>
+constexpr typename type_at<I, Ts...>::type& get_alternative(
+    variadic_variant<Ts...>& variant) {
+  return variant.template get<I>();
+}
+
+template <std::size_t I, typename... Ts>
+constexpr const typename type_at<I, Ts...>::type& get_alternative(
+    const variadic_variant<Ts...>& variant) {
+  return variant.template get<I>();
+}
+
+template <std::size_t I, typename... Ts>
+constexpr typename type_at<I, Ts...>::type&& get_alternative(
+    variadic_variant<Ts...>&& variant) {
+  return std::move(variant).template get<I>();
+}
+
+template <std::size_t I, typename... Ts>
+constexpr const typename type_at<I, Ts...>::type&& get_alternative(
+    const variadic_variant<Ts...>&& variant) {
+  return std::move(variant).template get<I>();
+}
+
+// Result type of applying the visitor to the first alternative; empty when
+// the visitor does not accept it
+template <typename Visitor, typename Variant, typename Enable = void>
+struct visit_result {};
+
+template <typename Visitor, typename Variant>
+struct visit_result<
+    Visitor, Variant,
+    typename void_type<decltype(std::declval<Visitor&>()(
+        get_alternative<0>(std::declval<Variant>())))>::type> {
+  typedef decltype(std::declval<Visitor&>()(
+      get_alternative<0>(std::declval<Variant>()))) type;
+};
+
+template <typename R, typename Visitor, typename Variant, std::size_t I>
+constexpr R visit_alternative(Visitor& visitor,
+                    typename std::remove_reference<Variant>::type& variant) {
+  return visitor(get_alternative<I>(static_cast<Variant&&>(variant)));
+}
+
+// Visiting a valueless variant
+[[noreturn]] RUSTCXX_COLD inline void bad_variant_access() {
+#if RUSTCXX_CONFIG_NO_EXCEPTIONS
+  panic("bad variant access");
+#else
+  throw backend::bad_variant_access();
+#endif
+}
+
+template <typename R, typename Visitor, typename Variant>
+R visit_valueless(Visitor&,
+                  typename std::remove_reference<Variant>::type&) {
+  bad_variant_access();
+}
+
+// Single alternative: no index load, no indirect call
+template <typename R, typename Visitor, typename Variant>
+inline R visit_table(Visitor& visitor, Variant&& variant, index_sequence<0>) {
+  if (variant.valueless_by_exception()) {
+    return visit_valueless<R, Visitor, Variant>(visitor, variant);
+  }
+  return visit_alternative<R, Visitor, Variant, 0>(visitor, variant);
+}
+
+// Two alternatives: a single compare the optimizer can turn into a select
+template <typename R, typename Visitor, typename Variant>
+inline R visit_table(Visitor& visitor, Variant&& variant,
+                     index_sequence<0, 1>) {
+  switch (variant.index()) {
+    case 0:
+      return visit_alternative<R, Visitor, Variant, 0>(visitor, variant);
+    case 1:
+      return visit_alternative<R, Visitor, Variant, 1>(visitor, variant);
+    default:
+      return visit_valueless<R, Visitor, Variant>(visitor, variant);
+  }
+}
+
+// Slot 0 handles the valueless state so that index() + 1 (variant_npos
+// wraps to 0) selects the entry without a separate range check.
+template <typename R, typename Visitor, typename Variant, std::size_t... Is>
+inline R visit_table(Visitor& visitor, Variant&& variant,
+                     index_sequence<Is...>) {
+  typedef R (*entry_type)(Visitor&,
+                          typename std::remove_reference<Variant>::type&);
+  static constexpr entry_type table[] = {
+      &visit_valueless<R, Visitor, Variant>,
+      &visit_alternative<R, Visitor, Variant, Is>...};
+  return table[variant.index() + 1](visitor, variant);
+}
+
+// Jump-table counterpart of nonstd::visit for a single variant
+template <typename Visitor, typename Variant>
+inline typename visit_result<Visitor, Variant>::type visit(Visitor&& visitor,
+                                                          Variant&& variant) {
+  typedef typename visit_result<Visitor, Variant>::type result_type;
+  typedef typename make_index_sequence<variant_size<Variant>::value>::type
+      indices;
+  return visit_table<result_type>(visitor, std::forward<Variant>(variant),
+                                  indices());
+}
+
+// Compare ladder over the alternatives, lowered by the optimizer like the
+// switch in nonstd::visit but with the arms inlined
+template <typename R, typename Visitor, typename Variant>
+constexpr R visit_ladder(Visitor& visitor,
+                      typename std::remove_reference<Variant>::type& variant,
+                      std::size_t, index_sequence<>) {
+  return visit_valueless<R, Visitor, Variant>(visitor, variant);
+}
+
+template <typename R, typename Visitor, typename Variant, std::size_t I,
+          std::size_t... Is>
+RUSTCXX_CONSTEXPR14 R visit_ladder(Visitor& visitor,
+                      typename std::remove_reference<Variant>::type& variant,
+                      std::size_t index, index_sequence<I, Is...>) {
+  if (index == I) {
+    return visit_alternative<R, Visitor, Variant, I>(visitor, variant);
+  }
+  return visit_ladder<R, Visitor, Variant>(visitor, variant, index,
+                                           index_sequence<Is...>());
+}
+
+template <typename Visitor, typename Variant>
+RUSTCXX_CONSTEXPR14 typename visit_result<Visitor, Variant>::type visit_switch(
+    Visitor&& visitor, Variant&& variant) {
+  typedef typename visit_result<Visitor, Variant>::type result_type;
+  typedef typename make_index_sequence<variant_size<Variant>::value>::type
+      indices;
+  return visit_ladder<result_type, Visitor, Variant>(
+      visitor, variant, variant.index(), indices());
+}
+
+// Engine selection for match(): indexed variants have no nonstd::visit, so
+// RUSTCXX_VISIT_NONSTD maps to the compare ladder for them
+template <typename Visitor, typename Variant>
+RUSTCXX_CONSTEXPR14 typename visit_result<Visitor, Variant>::type match_visit(
+    Visitor&& visitor, Variant&& variant, std::true_type) {
+#if RUSTCXX_CONFIG_SELECT_VISIT == RUSTCXX_VISIT_TABLE
+  return visit(visitor, std::forward<Variant>(variant));
+#else
+  return visit_switch(visitor, std::forward<Variant>(variant));
+#endif
+}
+
+}  // namespace detail
+
+// Helper struct for creating overloaded visitors. C++17 spells it as an
+// aggregate with a pack using-declaration; earlier standards inherit the
+// call operators one base at a time and construct through make_overloads.
+#if defined(__cpp_variadic_using) || RUSTCXX_CPP17_OR_GREATER
+template <class... Ts>
+struct overloads : Ts... {
+  using Ts::operator()...;
+};
+
+template <class... Ts>
+overloads(Ts...) -> overloads<Ts...>;
+#else
+template <class... Ts>
+struct overloads;
+
+template <class T>
+struct overloads<T> : T {
+  template <class U, typename = typename std::enable_if<!std::is_same<
+                         typename std::decay<U>::type, overloads>::value>::type>
+  constexpr overloads(U&& u) : T(std::forward<U>(u)) {}  // NOLINT
+
+  using T::operator();
+};
+
+template <class T, class... Ts>
+struct overloads<T, Ts...> : T, overloads<Ts...> {
+  template <class U, class... Us,
+            typename = typename std::enable_if<sizeof...(Us) ==
+                                               sizeof...(Ts)>::type>
+  constexpr overloads(U&& u, Us&&... us)
+      : T(std::forward<U>(u)), overloads<Ts...>(std::forward<Us>(us)...) {}
+
+  using T::operator();
+  using overloads<Ts...>::operator();
+};
+#endif
+
+// Builds an overloads visitor on any standard (no deduction guide needed)
+//
+//   auto visitor = rust::make_overloads([](int) {}, [](const Text&) {});
+template <class... Fs>
+constexpr overloads<typename std::decay<Fs>::type...> make_overloads(
+    Fs&&... fs) {
+  return overloads<typename std::decay<Fs>::type...>{std::forward<Fs>(fs)...};
+}
+
+namespace detail {
+
+template <typename Visitor, typename Variant>
+inline auto match_visit(Visitor&& visitor, Variant&& variant, std::false_type)
+    -> typename visit_result<Visitor, Variant>::type {
+#if RUSTCXX_CONFIG_SELECT_VISIT == RUSTCXX_VISIT_TABLE
+  return visit(visitor, std::forward<Variant>(variant));
+#elif RUSTCXX_USES_STD_VARIANT
+  return backend::visit(std::forward<Visitor>(visitor),
+                       std::forward<Variant>(variant));
+#else
+  // variant-lite's visit passes every alternative as const&
+  return visit_switch(visitor, std::forward<Variant>(variant));
+#endif
+}
+
+// Visitor with the alternative of an outer variant bound as its first
+// argument, for visiting several variants one at a time
+template <typename Visitor, typename A>
+struct bound_visitor {
+  Visitor& visitor;
+  A&& alternative;
+
+  template <typename... Bs>
+  auto operator()(Bs&&... bs)
+      -> decltype(std::declval<Visitor&>()(std::declval<A>(),
+                                           std::declval<Bs>()...)) {
+    return visitor(std::forward<A>(alternative), std::forward<Bs>(bs)...);
+  }
+};
+
+template <typename Visitor, typename Seq, typename... Rest>
+struct visit_rest;
+
+// Visits the remaining variants once the first alternative is known
+template <typename Visitor, std::size_t... Is, typename... Rest>
+struct visit_rest<Visitor, index_sequence<Is...>, Rest...> {
+  Visitor& visitor;
+  std::tuple<Rest&&...> rest;
+
+  template <typename A>
+  auto operator()(A&& alternative)
+      -> decltype(visit_many(std::declval<bound_visitor<Visitor, A>&>(),
+                             std::declval<Rest>()...)) {
+    bound_visitor<Visitor, A> bound = {visitor, std::forward<A>(alternative)};
+    return visit_many(bound, std::forward<Rest>(std::get<Is>(rest))...);
+  }
+};
+
+template <typename Visitor, typename Variant>
+constexpr auto visit_many(Visitor&& visitor, Variant&& variant)
+    -> decltype(match_visit(
+        visitor, std::forward<Variant>(variant),
+        is_indexed_variant<typename std::decay<Variant>::type>())) {
+  return match_visit(visitor, std::forward<Variant>(variant),
+                     is_indexed_variant<typename std::decay<Variant>::type>());
+}
+
+template <typename Visitor, typename Variant, typename Next, typename... Rest>
+inline auto visit_many(Visitor&& visitor, Variant&& variant, Next&& next,
+                       Rest&&... rest)
+    -> decltype(match_visit(
+        std::declval<visit_rest<
+            typename std::remove_reference<Visitor>::type,
+            typename make_index_sequence<sizeof...(Rest) + 1>::type, Next,
+            Rest...>&>(),
+        std::forward<Variant>(variant),
+        is_indexed_variant<typename std::decay<Variant>::type>())) {
+  typedef visit_rest<typename std::remove_reference<Visitor>::type,
+                     typename make_index_sequence<sizeof...(Rest) + 1>::type,
+                     Next, Rest...>
+      rest_visitor;
+  rest_visitor outer = {
+      visitor, std::tuple<Next&&, Rest&&...>(std::forward<Next>(next),
+                                             std::forward<Rest>(rest)...)};
+  return match_visit(outer, std::forward<Variant>(variant),
+                     is_indexed_variant<typename std::decay<Variant>::type>());
+}
+
+// Visitor for match(): a single visitor is used in place, so stateful
+// visitors see their own updates; several are merged into overloads
+template <typename F>
+constexpr F&& make_visitor(F&& f) {
+  return std::forward<F>(f);
+}
+
+template <typename F, typename G, typename... Fs>
+constexpr overloads<typename std::decay<F>::type, typename std::decay<G>::type,
+                 typename std::decay<Fs>::type...>
+make_visitor(F&& f, G&& g, Fs&&... fs) {
+  return overloads<typename std::decay<F>::type, typename std::decay<G>::type,
+                   typename std::decay<Fs>::type...>{
+      std::forward<F>(f), std::forward<G>(g), std::forward<Fs>(fs)...};
+}
+
+// Arguments rust::match() visits rather than calls
+template <typename T>
+struct is_visitable : is_indexed_variant<T> {};
+
+template <typename... Ts>
+struct is_visitable<backend::variant<Ts...> > : std::true_type {};
+
+template <typename... Ts>
+struct is_visitable<Enum<Ts...> > : std::true_type {};
+
+template <typename... Args>
+struct leading_variants : std::integral_constant<std::size_t, 0> {};
+
+template <typename A, typename... Args>
+struct leading_variants<A, Args...>
+    : std::integral_constant<
+          std::size_t, is_visitable<typename std::decay<A>::type>::value
+                           ? 1 + leading_variants<Args...>::value
+                           : 0> {};
+
+template <std::size_t Offset, typename Seq>
+struct offset_sequence;
+
+template <std::size_t Offset, std::size_t... Is>
+struct offset_sequence<Offset, index_sequence<Is...> > {
+  typedef index_sequence<(Offset + Is)...> type;
+};
+
+struct enum_access;
+
+// Enums are visited through their storage
+template <typename V>
+constexpr V&& visit_operand(V&& v) {
+  return std::forward<V>(v);
+}
+
+template <typename... Ts>
+constexpr variadic_variant<Ts...>& visit_operand(Enum<Ts...>& e);
+
+template <typename... Ts>
+constexpr const variadic_variant<Ts...>& visit_operand(const Enum<Ts...>& e);
+
+template <typename... Ts>
+constexpr variadic_variant<Ts...>&& visit_operand(Enum<Ts...>&& e);
+
+template <typename Tuple, std::size_t... Vs, std::size_t... Fs>
+RUSTCXX_CONSTEXPR14 auto match_args(Tuple& args, index_sequence<Vs...>,
+                       index_sequence<Fs...>)
+    -> decltype(visit_many(
+        make_visitor(std::forward<typename std::tuple_element<Fs, Tuple>::type>(
+            std::get<Fs>(args))...),
+        visit_operand(
+            std::forward<typename std::tuple_element<Vs, Tuple>::type>(
+                std::get<Vs>(args)))...)) {
+  return visit_many(
+      make_visitor(std::forward<typename std::tuple_element<Fs, Tuple>::type>(
+          std::get<Fs>(args))...),
+      visit_operand(std::forward<typename std::tuple_element<Vs, Tuple>::type>(
+          std::get<Vs>(args)))...);
+}
+
+// Splits match() arguments into variants and visitors
+template <typename... Args>
+struct match_indices {
+  typedef leading_variants<Args...> variants;
+  static_assert(variants::value > 0 && variants::value < sizeof...(Args),
+                "match() takes one or more variants followed by visitors");
+
+  typedef typename make_index_sequence<variants::value>::type variant_indices;
+  typedef typename offset_sequence<
+      variants::value, typename make_index_sequence<
+                           sizeof...(Args) - variants::value>::type>::type
+      visitor_indices;
+};
+
+template <typename Enable, typename... Args>
+struct match_result_impl {};
+
+template <typename... Args>
+struct match_result_impl<
+    typename void_type<decltype(match_args(
+        std::declval<std::tuple<Args&&...>&>(),
+        typename match_indices<Args...>::variant_indices(),
+        typename match_indices<Args...>::visitor_indices()))>::type,
+    Args...> {
+  typedef decltype(match_args(
+      std::declval<std::tuple<Args&&...>&>(),
+      typename match_indices<Args...>::variant_indices(),
+      typename match_indices<Args...>::visitor_indices())) type;
+};
+
+// Result of match(args...); empty when the visitors do not accept the
+// alternatives, so ref-qualified overloads drop out instead of failing
+template <typename... Args>
+struct match_result : match_result_impl<void, Args...> {};
+
+}  // namespace detail
+
+// Pattern matching similar to Rust's match. The leading arguments are the
+// variants (Enums, nonstd variants or tagged-union storage); the rest
+// are visitors. Alternatives reach the visitor with the value category
+// of their variant, so visitors can mutate them (&) or move out (&&):
+//
+//   rust::match(shape, [](Circle& c) { c.r *= 2; }, [](Square&) {});
+//   rust::match(lhs, rhs, [](const auto& a, const auto& b) { ... });
+template <typename... Args>
+RUSTCXX_CONSTEXPR14 RUSTCXX_RETURN_TYPE(
+    typename detail::match_result<Args...>::type) match(Args&&... args) {
+  typedef detail::match_indices<Args...> indices;
+  std::tuple<Args&&...> bound(std::forward<Args>(args)...);
+  return detail::match_args(bound, typename indices::variant_indices(),
+                            typename indices::visitor_indices());
+}
+
+template <typename T, typename Enable = void>
+struct niche_traits;
+
+// Enum-like wrapper around a variadic tagged union for better ergonomics
+template <typename... Types>
+class Enum {
+  typedef detail::variadic_variant<Types...> storage_type;
+
+ public:
+  // Default constructor
+  constexpr Enum() {}
+
+  // Constructor from any of the variant types
+  template <typename T, typename = typename std::enable_if<!std::is_same<
+                            typename std::decay<T>::type, Enum>::value>::type>
+  constexpr Enum(T&& t)  // NOLINT(runtime/explicit)
+      : value_(std::forward<T>(t)) {}
+
+  // Assignment
+  template <typename T, typename = typename std::enable_if<!std::is_same<
+                            typename std::decay<T>::type, Enum>::value>::type>
+  Enum& operator=(T&& t) {
+    value_ = std::forward<T>(t);
+    return *this;
+  }
+
+  // Get the index of the currently held type
+  inline std::size_t index() const { return value_.index(); }
+
+  // Check if the enum holds a specific type
+  template <typename T>
+  inline bool is() const {
+    return value_.index() == index_of<T>();
+  }
+
+  // Get the value if it's of type T, panics if not
+  template <typename T>
+  inline T& get() {
+    if (RUSTCXX_UNLIKELY(!is<T>())) {
+      RUSTCXX_STATS_COUNT(Enum, panics);
+      panic("bad variant access");
+    }
+    return value_.template get<index_of<T>()>();
+  }
+
+  template <typename T>
+  inline const T& get() const {
+    if (RUSTCXX_UNLIKELY(!is<T>())) {
+      RUSTCXX_STATS_COUNT(Enum, panics);
+      panic("bad variant access");
+    }
+    return value_.template get<index_of<T>()>();
+  }
+
+  // Get the value if it's of type T, returns nullptr if not
+  template <typename T>
+  inline T* get_if() {
+    if (!is<T>()) {
+      return NULL;
+    }
+    return &value_.template get<index_of<T>()>();
+  }
+
+  template <typename T>
+  inline const T* get_if() const {
+    if (!is<T>()) {
+      return NULL;
+    }
+    return &value_.template get<index_of<T>()>();
+  }
+
+  // Get the I-th alternative, panics if it is not the active one
+  template <std::size_t I>
+  inline typename detail::type_at<I, Types...>::type& get() {
+    if (RUSTCXX_UNLIKELY(value_.index() != I)) {
+      RUSTCXX_STATS_COUNT(Enum, panics);
+      panic("bad variant access");
+    }
+    return value_.template get<I>();
+  }
+
+  template <std::size_t I>
+  inline const typename detail::type_at<I, Types...>::type& get() const {
+    if (RUSTCXX_UNLIKELY(value_.index() != I)) {
+      RUSTCXX_STATS_COUNT(Enum, panics);
+      panic("bad variant access");
+    }
+    return value_.template get<I>();
+  }
+
+  // Unchecked access; the caller guarantees that T (or the I-th
+  // alternative) is the active one
+  template <typename T>
+  inline T& get_unchecked() noexcept {
+    return value_.template get<index_of<T>()>();
+  }
+
+  template <typename T>
+  inline const T& get_unchecked() const noexcept {
+    return value_.template get<index_of<T>()>();
+  }
+
+  template <std::size_t I>
+  inline typename detail::type_at<I, Types...>::type& get_unchecked() noexcept {
+    return value_.template get<I>();
+  }
+
+  template <std::size_t I>
+  inline const typename detail::type_at<I, Types...>::type& get_unchecked()
+      const noexcept {
+    return value_.template get<I>();
+  }
+
+  // Match function for pattern matching
+  template <typename... Ts>
+  RUSTCXX_CONSTEXPR14 RUSTCXX_RETURN_TYPE(
+      typename detail::match_result<storage_type&, Ts...>::type)
+      match(Ts&&... ts) & {
+    return RUSTCXX_STATS_MATCH(Enum, index()),
+           rust::match(value_, std::forward<Ts>(ts)...);
+  }
+
+  template <typename... Ts>
+  constexpr RUSTCXX_RETURN_TYPE(
+      typename detail::match_result<const storage_type&, Ts...>::type)
+      match(Ts&&... ts) const& {
+    return RUSTCXX_STATS_MATCH(Enum, index()),
+           rust::match(value_, std::forward<Ts>(ts)...);
+  }
+
+  template <typename... Ts>
+  RUSTCXX_CONSTEXPR14 RUSTCXX_RETURN_TYPE(
+      typename detail::match_result<storage_type, Ts...>::type)
+      match(Ts&&... ts) && {
+    return RUSTCXX_STATS_MATCH(Enum, index()),
+           rust::match(std::move(value_), std::forward<Ts>(ts)...);
+  }
+
+  // Equality comparison
+  inline bool operator==(const Enum& other) const {
+    return value_ == other.value_;
+  }
+
+  inline bool operator!=(const Enum& other) const {
+    return value_ != other.value_;
+  }
+
+ private:
+  template <typename T>
+  static constexpr std::size_t index_of() {
+    static_assert(detail::index_of<T, Types...>::value < sizeof...(Types),
+                  "T is not an alternative of this Enum");
+    return detail::index_of<T, Types...>::value;
+  }
+
+  template <typename, typename>
+  friend struct niche_traits;
+  friend struct detail::enum_access;
+
+  explicit Enum(detail::niche_tag tag) noexcept : value_(tag) {}
+
+  storage_type value_;
+};
+
+namespace detail {
+
+struct enum_access {
+  template <typename... Ts>
+  static constexpr variadic_variant<Ts...>& storage(Enum<Ts...>& e) noexcept {
+    return e.value_;
+  }
+
+  template <typename... Ts>
+  static constexpr const variadic_variant<Ts...>& storage(
+      const Enum<Ts...>& e) noexcept {
+    return e.value_;
+  }
+};
+
+template <typename... Ts>
+constexpr variadic_variant<Ts...>& visit_operand(Enum<Ts...>& e) {
+  return RUSTCXX_STATS_MATCH(Enum<Ts...>, e.index()), enum_access::storage(e);
+}
+
+template <typename... Ts>
+constexpr const variadic_variant<Ts...>& visit_operand(const Enum<Ts...>& e) {
+  return RUSTCXX_STATS_MATCH(Enum<Ts...>, e.index()), enum_access::storage(e);
+}
+
+template <typename... Ts>
+constexpr variadic_variant<Ts...>&& visit_operand(Enum<Ts...>&& e) {
+  return RUSTCXX_STATS_MATCH(Enum<Ts...>, e.index()),
+         std::move(enum_access::storage(e));
+}
+
+// Wraps an error in a ContextError, or appends to one; rustcxx_error.hpp
+template <typename E>
+struct context_traits;
+
+}  // namespace detail
+
+// Rust-style Result type
+template <typename T, typename E = std::string>
+class Result {
+ public:
+  typedef T ok_type;
+  typedef E err_type;
+
+  // Construct Ok result, forwarding the value into the variant storage
+  template <typename U = T>
+  static Result Ok(U&& value) {
+    return Result(ok_tag(), std::forward<U>(value));
+  }
+
+  // Construct Err result, forwarding the error into the variant storage
+  template <typename U = E>
+  static Result Err(U&& error) {
+    return Result(err_tag(), std::forward<U>(error));
+  }
+
+  // Construct Ok result in place from constructor arguments of T
+  template <typename... Args>
+  static Result emplace_ok(Args&&... args) {
+    return Result(ok_tag(), std::forward<Args>(args)...);
+  }
+
+  // Construct Err result in place from constructor arguments of E
+  template <typename... Args>
+  static Result emplace_err(Args&&... args) {
+    return Result(err_tag(), std::forward<Args>(args)...);
+  }
+
+  // Check if result is Ok
+  bool is_ok() const {
+    return value_.index() == 0;
+  }
+
+  // Check if result is Err
+  bool is_err() const {
+    return value_.index() == 1;
+  }
+
+  // Get the Ok value (panics if Err)
+  T& unwrap() & {
+    if (RUSTCXX_UNLIKELY(is_err())) {
+      RUSTCXX_STATS_COUNT(Result, panics);
+      panic("Called unwrap() on an Err Result");
+    }
+    return value_.template get<0>();
+  }
+
+  const T& unwrap() const& {
+    if (RUSTCXX_UNLIKELY(is_err())) {
+      RUSTCXX_STATS_COUNT(Result, panics);
+      panic("Called unwrap() on an Err Result");
+    }
+    return value_.template get<0>();
+  }
+
+  // Move the Ok value out of a temporary Result (panics if Err)
+  T unwrap() && {
+    if (RUSTCXX_UNLIKELY(is_err())) {
+      RUSTCXX_STATS_COUNT(Result, panics);
+      panic("Called unwrap() on an Err Result");
+    }
+    return std::move(value_).template get<0>();
+  }
+
+  // Get the Ok value without checking; the caller guarantees is_ok()
+  T& unwrap_unchecked() & noexcept { return value_.template get<0>(); }
+
+  const T& unwrap_unchecked() const& noexcept {
+    return value_.template get<0>();
+  }
+
+  T unwrap_unchecked() && { return std::move(value_).template get<0>(); }
+
+  // Get the Ok value or a default
+  template <typename U>
+  T unwrap_or(U&& default_value) const& {
+    if (is_ok()) {
+      return value_.template get<0>();
+    }
+    return T(std::forward<U>(default_value));
+  }
+
+  template <typename U>
+  T unwrap_or(U&& default_value) && {
+    if (is_ok()) {
+      return std::move(value_).template get<0>();
+    }
+    return T(std::forward<U>(default_value));
+  }
+
+  // Get the error value (panics if Ok)
+  E& unwrap_err() & {
+    if (RUSTCXX_UNLIKELY(is_ok())) {
+      RUSTCXX_STATS_COUNT(Result, panics);
+      panic("Called unwrap_err() on an Ok Result");
+    }
+    return value_.template get<1>();
+  }
+
+  const E& unwrap_err() const& {
+    if (RUSTCXX_UNLIKELY(is_ok())) {
+      RUSTCXX_STATS_COUNT(Result, panics);
+      panic("Called unwrap_err() on an Ok Result");
+    }
+    return value_.template get<1>();
+  }
+
+  // Move the error value out of a temporary Result (panics if Ok)
+  E unwrap_err() && {
+    if (RUSTCXX_UNLIKELY(is_ok())) {
+      RUSTCXX_STATS_COUNT(Result, panics);
+      panic("Called unwrap_err() on an Ok Result");
+    }
+    return std::move(value_).template get<1>();
+  }
+
+  // Get the error value without checking; the caller guarantees is_err()
+  E& unwrap_err_unchecked() & noexcept { return value_.template get<1>(); }
+
+  const E& unwrap_err_unchecked() const& noexcept {
+    return value_.template get<1>();
+  }
+
+  E unwrap_err_unchecked() && { return std::move(value_).template get<1>(); }
+
+  // Map function - transform Ok value, leave Err unchanged
+  template <typename F>
+  auto map(F&& f) & -> Result<decltype(f(std::declval<T&>())), E> {
+    typedef Result<decltype(f(std::declval<T&>())), E> result;
+    if (is_ok()) {
+      return result::Ok(f(value_.template get<0>()));
+    } else {
+      return result::Err(value_.template get<1>());
+    }
+  }
+
+  template <typename F>
+  auto map(F&& f) const& -> Result<decltype(f(std::declval<const T&>())), E> {
+    typedef Result<decltype(f(std::declval<const T&>())), E> result;
+    if (is_ok()) {
+      return result::Ok(f(value_.template get<0>()));
+    } else {
+      return result::Err(value_.template get<1>());
+    }
+  }
+
+  template <typename F>
+  auto map(F&& f) && -> Result<decltype(f(std::declval<T&&>())), E> {
+    typedef Result<decltype(f(std::declval<T&&>())), E> result;
+    if (is_ok()) {
+      return result::Ok(f(std::move(value_).template get<0>()));
+    } else {
+      return result::Err(std::move(value_).template get<1>());
+    }
+  }
+
+  // Map error function - transform Err value, leave Ok unchanged
+  template <typename F>
+  auto map_err(F&& f) & -> Result<T, decltype(f(std::declval<E&>()))> {
+    typedef Result<T, decltype(f(std::declval<E&>()))> result;
+    if (is_err()) {
+      return result::Err(f(value_.template get<1>()));
+    } else {
+      return result::Ok(value_.template get<0>());
+    }
+  }
+
+  template <typename F>
+  auto map_err(F&& f) const&
+      -> Result<T, decltype(f(std::declval<const E&>()))> {
+    typedef Result<T, decltype(f(std::declval<const E&>()))> result;
+    if (is_err()) {
+      return result::Err(f(value_.template get<1>()));
+    } else {
+      return result::Ok(value_.template get<0>());
+    }
+  }
+
+  template <typename F>
+  auto map_err(F&& f) && -> Result<T, decltype(f(std::declval<E&&>()))> {
+    typedef Result<T, decltype(f(std::declval<E&&>()))> result;
+    if (is_err()) {
+      return result::Err(f(std::move(value_).template get<1>()));
+    } else {
+      return result::Ok(std::move(value_).template get<0>());
+    }
+  }
+
+  // And then - chain Results
+  template <typename F>
+  auto and_then(F&& f) & -> decltype(f(std::declval<T&>())) {
+    if (is_ok()) {
+      return f(value_.template get<0>());
+    } else {
+      typedef decltype(f(std::declval<T&>())) result;
+      return result::Err(value_.template get<1>());
+    }
+  }
+
+  template <typename F>
+  auto and_then(F&& f) const& -> decltype(f(std::declval<const T&>())) {
+    if (is_ok()) {
+      return f(value_.template get<0>());
+    } else {
+      typedef decltype(f(std::declval<const T&>())) result;
+      return result::Err(value_.template get<1>());
+    }
+  }
+
+  template <typename F>
+  auto and_then(F&& f) && -> decltype(f(std::declval<T&&>())) {
+    if (is_ok()) {
+      return f(std::move(value_).template get<0>());
+    } else {
+      typedef decltype(f(std::declval<T&&>())) result;
+      return result::Err(std::move(value_).template get<1>());
+    }
+  }
+
+  // Attach context to an Err without formatting it: fmt (static storage)
+  // and the args are stored in a ContextError frame and rendered only when
+  // the message is read. Strings are copied into the frame, other pointers
+  // must outlive the error. Requires rustcxx_error.hpp.
+  template <typename U = E, typename... Args>
+  auto context(const char* fmt, const Args&... args) const& -> Result<
+      T, typename detail::context_traits<U>::type> {
+    typedef Result<T, typename detail::context_traits<U>::type> result;
+    if (is_ok()) {
+      return result::Ok(value_.template get<0>());
+    }
+    return result::Err(detail::context_traits<U>::push(
+        value_.template get<1>(), fmt, args...));
+  }
+
+  template <typename U = E, typename... Args>
+  auto context(const char* fmt, const Args&... args) && -> Result<
+      T, typename detail::context_traits<U>::type> {
+    typedef Result<T, typename detail::context_traits<U>::type> result;
+    if (is_ok()) {
+      return result::Ok(std::move(value_).template get<0>());
+    }
+    return result::Err(detail::context_traits<U>::push(
+        std::move(value_).template get<1>(), fmt, args...));
+  }
+
+  // Attach context computed by f() when the message is read. f must be
+  // trivially copyable, so capture by value: it runs after the caller's
+  // frame is gone, and anything it points at must outlive the error.
+  template <typename F, typename U = E>
+  auto with_context(F f) const& -> Result<
+      T, typename detail::context_traits<U>::type> {
+    typedef Result<T, typename detail::context_traits<U>::type> result;
+    if (is_ok()) {
+      return result::Ok(value_.template get<0>());
+    }
+    return result::Err(
+        detail::context_traits<U>::push_with(value_.template get<1>(), f));
+  }
+
+  template <typename F, typename U = E>
+  auto with_context(F f) && -> Result<
+      T, typename detail::context_traits<U>::type> {
+    typedef Result<T, typename detail::context_traits<U>::type> result;
+    if (is_ok()) {
+      return result::Ok(std::move(value_).template get<0>());
+    }
+    return result::Err(detail::context_traits<U>::push_with(
+        std::move(value_).template get<1>(), f));
+  }
+
+  // Pattern matching
+  template <typename... Ts>
+  RUSTCXX_RETURN_TYPE(typename detail::match_result<
+                      detail::variadic_variant<T, E>&, Ts...>::type)
+  match(Ts&&... ts) & {
+    return rust::match(value_, std::forward<Ts>(ts)...);
+  }
+
+  template <typename... Ts>
+  RUSTCXX_RETURN_TYPE(typename detail::match_result<
+                      const detail::variadic_variant<T, E>&, Ts...>::type)
+  match(Ts&&... ts) const& {
+    return rust::match(value_, std::forward<Ts>(ts)...);
+  }
+
+  template <typename... Ts>
+  RUSTCXX_RETURN_TYPE(typename detail::match_result<
+                      detail::variadic_variant<T, E>, Ts...>::type)
+  match(Ts&&... ts) && {
+    return rust::match(std::move(value_), std::forward<Ts>(ts)...);
+  }
+
+  // Equal when both are Ok or both Err, with equal payloads
+  bool operator==(const Result& other) const { return value_ == other.value_; }
+
+  bool operator!=(const Result& other) const { return value_ != other.value_; }
+
+ private:
+  struct ok_tag {};
+  struct err_tag {};
+
+  template <typename... Args>
+  explicit Result(ok_tag, Args&&... args)
+      : value_(detail::alternative_tag<0>(), std::forward<Args>(args)...) {
+    RUSTCXX_STATS_COUNT(Result, ok);
+  }
+
+  template <typename... Args>
+  explicit Result(err_tag, Args&&... args)
+      : value_(detail::alternative_tag<1>(), std::forward<Args>(args)...) {
+    RUSTCXX_STATS_COUNT(Result, err);
+  }
+
+  detail::variadic_variant<T, E> value_;
+};
+
+// Describes a bit pattern of T that a valid T never holds, so Option<T>
+// can store None there instead of in a separate flag. Specialize it for
+// handle types with a sentinel:
+//
+//   template <>
+//   struct rust::niche_traits<NodeHandle> {
+//     static constexpr bool available = true;
+//     static NodeHandle none() { return NodeHandle(~0u); }
+//     static bool is_none(const NodeHandle& h) { return h.id == ~0u; }
+//   };
+template <typename T, typename Enable>
+struct niche_traits {
+  static constexpr bool available = false;
+};
+
+template <typename T, typename Enable>
+constexpr bool niche_traits<T, Enable>::available;
+
+// Null pointers: Option<T*>::Some(nullptr) is None
+template <typename T>
+struct niche_traits<T*> {
+  static constexpr bool available = true;
+  static T* none() noexcept { return nullptr; }
+  static bool is_none(T* const& value) noexcept { return value == nullptr; }
+};
+
+template <typename T>
+constexpr bool niche_traits<T*>::available;
+
+template <typename T, typename D>
+struct niche_traits<std::unique_ptr<T, D> > {
+  static constexpr bool available = true;
+  static std::unique_ptr<T, D> none() noexcept {
+    return std::unique_ptr<T, D>();
+  }
+  static bool is_none(const std::unique_ptr<T, D>& value) noexcept {
+    return !value;
+  }
+};
+
+template <typename T, typename D>
+constexpr bool niche_traits<std::unique_ptr<T, D> >::available;
+
+// Enums: the discriminant value one past the last alternative
+template <typename... Types>
+struct niche_traits<Enum<Types...> > {
+  static constexpr bool available = true;
+  static Enum<Types...> none() noexcept {
+    return Enum<Types...>(detail::niche_tag());
+  }
+  static bool is_none(const Enum<Types...>& value) noexcept {
+    return value.value_.is_niche();
+  }
+};
+
+template <typename... Types>
+constexpr bool niche_traits<Enum<Types...> >::available;
+
+namespace detail {
+
+// Option storage: a separate engaged flag unless T has a niche
+template <typename T, bool Niche = niche_traits<T>::available>
+class option_storage {
+ public:
+  option_storage() : value_() {}
+
+  template <typename... Args>
+  explicit option_storage(RUSTCXX_IN_PLACE_T(T), Args&&... args)
+      : value_(RUSTCXX_IN_PLACE(T), std::forward<Args>(args)...) {}
+
+  bool has_value() const noexcept { return value_.has_value(); }
+
+  T& operator*() & noexcept { return *value_; }
+  const T& operator*() const& noexcept { return *value_; }
+  T&& operator*() && noexcept { return std::move(*value_); }
+
+ private:
+  backend::optional<T> value_;
+};
+
+template <typename T>
+class option_storage<T, true> {
+ public:
+  option_storage() : value_(niche_traits<T>::none()) {}
+
+  template <typename... Args>
+  explicit option_storage(RUSTCXX_IN_PLACE_T(T), Args&&... args)
+      : value_(std::forward<Args>(args)...) {}
+
+  bool has_value() const noexcept { return !niche_traits<T>::is_none(value_); }
+
+  T& operator*() & noexcept { return value_; }
+  const T& operator*() const& noexcept { return value_; }
+  T&& operator*() && noexcept { return std::move(value_); }
+
+ private:
+  T value_;
+};
+
+// Option<T&> stores a pointer; the null pointer is None
+template <typename T>
+class option_storage<T&, false> {
+ public:
+  option_storage() : value_(nullptr) {}
+
+  explicit option_storage(RUSTCXX_IN_PLACE_T(T&), T& value)
+      : value_(&value) {}
+
+  bool has_value() const noexcept { return value_ != nullptr; }
+
+  T& operator*() const noexcept { return *value_; }
+
+ private:
+  T* value_;
+};
+
+}  // namespace detail
+
+// Rust-style Option type
+template <typename T>
+class Option {
+ public:
+  typedef T value_type;
+
+  // Construct Some option, forwarding the value into the optional storage
+  template <typename U = T>
+  static Option Some(U&& value) {
+    return Option(RUSTCXX_IN_PLACE(T), std::forward<U>(value));
+  }
+
+  // Construct Some option in place from constructor arguments of T
+  template <typename... Args>
+  static Option emplace_some(Args&&... args) {
+    return Option(RUSTCXX_IN_PLACE(T), std::forward<Args>(args)...);
+  }
+
+  // Construct None option
+  static Option None() {
+    return Option();
+  }
+
+  // Default constructor creates None
+  Option() : value_() {}
+
+  // Check if option is Some
+  bool is_some() const { return value_.has_value(); }
+
+  // Check if option is None
+  bool is_none() const { return !value_.has_value(); }
+
+  // Get the Some value (panics if None)
+  T& unwrap() & {
+    if (RUSTCXX_UNLIKELY(is_none())) {
+      RUSTCXX_STATS_COUNT(Option, panics);
+      panic("Called unwrap() on a None Option");
+    }
+    return *value_;
+  }
+
+  const T& unwrap() const& {
+    if (RUSTCXX_UNLIKELY(is_none())) {
+      RUSTCXX_STATS_COUNT(Option, panics);
+      panic("Called unwrap() on a None Option");
+    }
+    return *value_;
+  }
+
+  // Move the Some value out of a temporary Option (panics if None)
+  T unwrap() && {
+    if (RUSTCXX_UNLIKELY(is_none())) {
+      RUSTCXX_STATS_COUNT(Option, panics);
+      panic("Called unwrap() on a None Option");
+    }
+    return *std::move(value_);
+  }
+
+  // Get the Some value without checking; the caller guarantees is_some()
+  T& unwrap_unchecked() & noexcept { return *value_; }
+
+  const T& unwrap_unchecked() const& noexcept { return *value_; }
+
+  T unwrap_unchecked() && { return *std::move(value_); }
+
+  // Get the Some value or a default
+  template <typename U>
+  T unwrap_or(U&& default_value) const& {
+    if (is_some()) {
+      return *value_;
+    }
+    return T(std::forward<U>(default_value));
+  }
+
+  template <typename U>
+  T unwrap_or(U&& default_value) && {
+    if (is_some()) {
+      return *std::move(value_);
+    }
+    return T(std::forward<U>(default_value));
+  }
+
+  // Map function - transform Some value, leave None unchanged
+  template <typename F>
+  auto map(F&& f) & -> Option<decltype(f(std::declval<T&>()))> {
+    typedef Option<decltype(f(std::declval<T&>()))> option;
+    if (is_some()) {
+      return option::Some(f(*value_));
+    } else {
+      return option::None();
+    }
+  }
+
+  template <typename F>
+  auto map(F&& f) const& -> Option<decltype(f(std::declval<const T&>()))> {
+    typedef Option<decltype(f(std::declval<const T&>()))> option;
+    if (is_some()) {
+      return option::Some(f(*value_));
+    } else {
+      return option::None();
+    }
+  }
+
+  template <typename F>
+  auto map(F&& f) && -> Option<decltype(f(std::declval<T&&>()))> {
+    typedef Option<decltype(f(std::declval<T&&>()))> option;
+    if (is_some()) {
+      return option::Some(f(*std::move(value_)));
+    } else {
+      return option::None();
+    }
+  }
+
+  // And then - chain Options
+  template <typename F>
+  auto and_then(F&& f) & -> decltype(f(std::declval<T&>())) {
+    if (is_some()) {
+      return f(*value_);
+    } else {
+      typedef decltype(f(std::declval<T&>())) option;
+      return option::None();
+    }
+  }
+
+  template <typename F>
+  auto and_then(F&& f) const& -> decltype(f(std::declval<const T&>())) {
+    if (is_some()) {
+      return f(*value_);
+    } else {
+      typedef decltype(f(std::declval<const T&>())) option;
+      return option::None();
+    }
+  }
+
+  template <typename F>
+  auto and_then(F&& f) && -> decltype(f(std::declval<T&&>())) {
+    if (is_some()) {
+      return f(*std::move(value_));
+    } else {
+      typedef decltype(f(std::declval<T&&>())) option;
+      return option::None();
+    }
+  }
+
+  // Pattern matching using variant-like interface
+  template <typename SomeFunc, typename NoneFunc>
+  RUSTCXX_RETURN_TYPE(decltype(std::declval<SomeFunc&>()(std::declval<T&>())))
+  match(SomeFunc&& some_func, NoneFunc&& none_func) & {
+    if (is_some()) {
+      return some_func(*value_);
+    } else {
+      return none_func();
+    }
+  }
+
+  template <typename SomeFunc, typename NoneFunc>
+  RUSTCXX_RETURN_TYPE(decltype(std::declval<SomeFunc&>()(std::declval<const T&>())))
+  match(SomeFunc&& some_func, NoneFunc&& none_func) const& {
+    if (is_some()) {
+      return some_func(*value_);
+    } else {
+      return none_func();
+    }
+  }
+
+  template <typename SomeFunc, typename NoneFunc>
+  RUSTCXX_RETURN_TYPE(decltype(std::declval<SomeFunc&>()(std::declval<T&&>())))
+  match(SomeFunc&& some_func, NoneFunc&& none_func) && {
+    if (is_some()) {
+      return some_func(*std::move(value_));
+    } else {
+      return none_func();
+    }
+  }
+
+  // Equal when both are None, or both Some with equal values
+  bool operator==(const Option& other) const {
+    if (is_some() != other.is_some()) {
+      return false;
+    }
+    return is_none() ||
+           detail::equal_values(unwrap_unchecked(), other.unwrap_unchecked());
+  }
+
+  bool operator!=(const Option& other) const { return !(*this == other); }
+
+ private:
+  template <typename... Args>
+  explicit Option(RUSTCXX_IN_PLACE_T(T), Args&&... args)
+      : value_(RUSTCXX_IN_PLACE(T), std::forward<Args>(args)...) {}
+
+  detail::option_storage<T> value_;
+};
+
+namespace detail {
+
+template <typename Object, typename... Ts>
+struct layout_info {
+  typedef typename variadic_variant<Ts...>::index_t discriminant_type;
+
+  static constexpr bool tag_only = use_tag_storage<Ts...>::value;
+  static constexpr std::size_t size = sizeof(Object);
+  static constexpr std::size_t alignment = alignof(Object);
+  static constexpr std::size_t discriminant_size = sizeof(discriminant_type);
+  static constexpr std::size_t payload_size =
+      tag_only ? 0 : static_max<sizeof(Ts)...>::value;
+  // Byte offset of the discriminant, which follows the payload
+  static constexpr std::size_t discriminant_offset =
+      (payload_size + discriminant_size - 1) / discriminant_size *
+      discriminant_size;
 };
 
-// Helper for pattern matching - similar to Rust's match
-template <typename Variant, class... Ts>
-inline constexpr decltype(auto) match(Variant&& variant, Ts&&... ts) noexcept {
-  return nonstd::visit(overloads<Ts...>{std::forward<Ts>(ts)...}, std::forward<Variant>(variant));
-}
+template <typename Object, typename... Ts>
+constexpr bool layout_info<Object, Ts...>::tag_only;
+template <typename Object, typename... Ts>
+constexpr std::size_t layout_info<Object, Ts...>::size;
+template <typename Object, typename... Ts>
+constexpr std::size_t layout_info<Object, Ts...>::alignment;
+template <typename Object, typename... Ts>
+constexpr std::size_t layout_info<Object, Ts...>::discriminant_size;
+template <typename Object, typename... Ts>
+constexpr std::size_t layout_info<Object, Ts...>::payload_size;
+template <typename Object, typename... Ts>
+constexpr std::size_t layout_info<Object, Ts...>::discriminant_offset;
+
+}  // namespace detail
+
+// Storage layout of an Enum or Result, for static_assert-ing size budgets:
+//   static_assert(rust::layout_of<Color>::size == 1, "");
+template <typename T>
+struct layout_of;
 
-// Enum-like wrapper around std::variant for better ergonomics
 template <typename... Types>
-class Enum {
- public:
-  // Default constructor
-  Enum() {}
+struct layout_of<Enum<Types...> >
+    : detail::layout_info<Enum<Types...>, Types...> {};
 
-  // Constructor from any of the variant types
-  template <typename T>
-  Enum(T&& t) : value_(std::forward<T>(t)) {}
+template <typename T, typename E>
+struct layout_of<Result<T, E> > : detail::layout_info<Result<T, E>, T, E> {};
 
-  // Assignment
-  template <typename T>
-  Enum& operator=(T&& t) {
-    value_ = std::forward<T>(t);
-    return *this;
-  }
+namespace detail {
 
-  ~Enum() {}
+constexpr std::size_t size_sum() noexcept { return 0; }
 
-  // Get the index of the currently held type
-  inline std::size_t index() const { return value_.index(); }
+template <typename... Sizes>
+constexpr std::size_t size_sum(std::size_t first, Sizes... rest) noexcept {
+  return first + size_sum(rest...);
+}
 
-  // Check if the enum holds a specific type
-  template <typename T>
-  inline bool is() const {
-    return nonstd::holds_alternative<T>(value_);
-  }
+// Whether a struct of Size bytes holding Fields compares as its bytes:
+// every field does, and there is no padding in between
+template <std::size_t Size, typename... Fields>
+struct bitwise_fields
+    : std::integral_constant<
+          bool, all_of<is_bitwise_comparable<Fields>::value...>::value &&
+                    Size == size_sum(sizeof(Fields)...)> {};
+
+// Structs whose bytes determine their value, so that comparing or hashing
+// the bytes is sound: no padding and no floating point. Before C++17 this
+// uses the compiler builtin behind std::has_unique_object_representations;
+// without it padding cannot be seen, so no struct qualifies.
+#if defined(__has_builtin) && !RUSTCXX_CPP17_OR_GREATER
+#if __has_builtin(__has_unique_object_representations)
+#define RUSTCXX_HAS_UNIQUE_BYTES_BUILTIN 1
+#endif
+#endif
+#if !defined(RUSTCXX_HAS_UNIQUE_BYTES_BUILTIN)
+#if !RUSTCXX_CPP17_OR_GREATER &&                                   \
+    ((defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 7) || \
+     (defined(_MSC_VER) && _MSC_VER >= 1911))
+#define RUSTCXX_HAS_UNIQUE_BYTES_BUILTIN 1
+#else
+#define RUSTCXX_HAS_UNIQUE_BYTES_BUILTIN 0
+#endif
+#endif
 
-  // Get the value if it's of type T, throws if not
-  template <typename T>
-  inline T& get() {
-    if (!is<T>()) {
-      throw std::runtime_error("bad variant access");
-    }
-    return nonstd::get<T>(value_);
-  }
+template <typename T>
+struct has_unique_bytes
+#if RUSTCXX_CPP17_OR_GREATER
+    : std::has_unique_object_representations<T> {
+#elif RUSTCXX_HAS_UNIQUE_BYTES_BUILTIN
+    : std::integral_constant<bool, __has_unique_object_representations(T)> {
+#else
+    : std::false_type {
+#endif
+};
 
-  template <typename T>
-  inline const T& get() const {
-    if (!is<T>()) {
-      throw std::runtime_error("bad variant access");
-    }
-    return nonstd::get<T>(value_);
-  }
+template <typename T>
+inline bool bytes_equal(const T& lhs, const T& rhs) noexcept {
+  static_assert(has_unique_bytes<T>::value,
+                "ENUM_VARIANT(name, decls...) compares fields as bytes before "
+                "C++20; use ENUM_VARIANTn for fields with padding, floating "
+                "point or non-trivial types, or where the compiler cannot "
+                "check for padding");
+  return std::memcmp(&lhs, &rhs, sizeof(T)) == 0;
+}
 
-  // Get the value if it's of type T, returns nullptr if not
-  template <typename T>
-  inline T* get_if() {
-    if (!is<T>()) {
-      return NULL;
-    }
-    return nonstd::get_if<T>(&value_);
-  }
+inline std::size_t hash_combine(std::size_t seed, std::size_t hash) noexcept {
+  return seed ^ (hash + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+}
 
-  template <typename T>
-  inline const T* get_if() const {
-    if (!is<T>()) {
-      return NULL;
-    }
-    return nonstd::get_if<T>(&value_);
+// FNV-1a over size bytes
+inline std::size_t fnv1a(const void* data, std::size_t size) noexcept {
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  std::size_t hash = static_cast<std::size_t>(2166136261u);
+  for (std::size_t i = 0; i < size; ++i) {
+    hash = (hash ^ bytes[i]) * static_cast<std::size_t>(16777619u);
   }
+  return hash;
+}
 
-  // Match function for pattern matching
-  template <typename... Ts>
-  inline constexpr decltype(auto) match(Ts&&... ts) & noexcept {
-    return rust::match(value_, std::forward<Ts>(ts)...);
-  }
+// FNV-1a over the bytes of a value
+template <typename T>
+inline std::size_t bytes_hash(const T& value) noexcept {
+  static_assert(has_unique_bytes<T>::value,
+                "ENUM_VARIANT(name, decls...) hashes fields as bytes; use "
+                "ENUM_VARIANTn for fields with padding, floating point or "
+                "non-trivial types, or where the compiler cannot check for "
+                "padding");
+  return fnv1a(&value, sizeof(T));
+}
 
-  template <typename... Ts>
-  inline constexpr decltype(auto) match(Ts&&... ts) const& noexcept {
-    return rust::match(value_, std::forward<Ts>(ts)...);
-  }
+// Scalars hash here rather than through std::hash, which would need
+// <functional>: integers, enums and pointers by value, floating point by
+// its bytes with -0.0 folded into 0.0
+template <typename T>
+inline typename std::enable_if<
+    std::is_integral<T>::value || std::is_enum<T>::value, std::size_t>::type
+scalar_hash(const T& value) noexcept {
+  return static_cast<std::size_t>(value);
+}
 
-  template <typename... Ts>
-  inline constexpr decltype(auto) match(Ts&&... ts) && noexcept {
-    return rust::match(std::move(value_), std::forward<Ts>(ts)...);
-  }
+template <typename T>
+inline typename std::enable_if<std::is_floating_point<T>::value,
+                               std::size_t>::type
+scalar_hash(const T& value) noexcept {
+  return value == T(0) ? 0 : fnv1a(&value, sizeof(T));
+}
 
-  // Equality comparison
-  inline bool operator==(const Enum& other) const {
-    return value_ == other.value_;
-  }
+template <typename T>
+inline std::size_t scalar_hash(T* value) noexcept {
+  return reinterpret_cast<std::size_t>(value);
+}
 
-  inline bool operator!=(const Enum& other) const {
-    return value_ != other.value_;
-  }
+// Hash of one value: the rustcxx_hash() the variant macros emit, a scalar
+// hash, or std::hash (declared by <string> and <memory>)
+template <typename T>
+inline auto hash_value_impl(const T& value, int)
+    -> decltype(value.rustcxx_hash()) {
+  return value.rustcxx_hash();
+}
 
- private:
-  nonstd::variant<Types...> value_;
+template <typename T>
+inline auto hash_value_impl(const T& value, long)
+    -> decltype(scalar_hash(value)) {
+  return scalar_hash(value);
+}
+
+template <typename T>
+inline auto hash_value_impl(const T& value, ...)
+    -> decltype(std::hash<T>()(value)) {
+  return std::hash<T>()(value);
+}
+
+template <typename T>
+inline std::size_t hash_value(const T& value) {
+  return hash_value_impl(value, 0);
+}
+
+// Whether hash_value accepts a T. std::hash of an Enum, Option or Result is
+// disabled unless every payload type is hashable.
+template <typename T>
+auto hashable_impl(int)
+    -> decltype(hash_value_impl(std::declval<const T&>(), 0),
+                std::true_type());
+
+template <typename T>
+std::false_type hashable_impl(long);
+
+template <typename T>
+struct is_hashable : decltype(hashable_impl<T>(0)) {};
+
+// Base of a disabled std::hash specialization: not constructible, no
+// operator()
+struct disabled_hash {
+  disabled_hash() = delete;
+  disabled_hash(const disabled_hash&) = delete;
+  disabled_hash& operator=(const disabled_hash&) = delete;
 };
 
-// Rust-style Result type
-template <typename T, typename E = std::string>
-class Result {
- public:
-  // Construct Ok result
-  static Result Ok(T value) {
-    return Result(value);
-  }
+inline std::size_t hash_fields() noexcept { return 0; }
+
+template <typename T, typename... Ts>
+inline std::size_t hash_fields(const T& first, const Ts&... rest) {
+  return hash_combine(hash_value(first), hash_fields(rest...));
+}
 
-  // Construct Err result
-  static Result Err(E error) {
-    return Result(error);
+// Visitor hashing the active alternative of an Enum
+struct alternative_hasher {
+  template <typename T>
+  std::size_t operator()(const T& value) const {
+    return hash_value(value);
   }
+};
 
-  ~Result() {}
+// Field name i of a reflected variant, NULL past the last field
+constexpr const char* name_at(std::size_t) noexcept { return nullptr; }
 
-  // Check if result is Ok
-  bool is_ok() const {
-    return nonstd::holds_alternative<T>(value_);
-  }
+template <typename... Names>
+constexpr const char* name_at(std::size_t i, const char* first,
+                              Names... rest) noexcept {
+  return i == 0 ? first : name_at(i - 1, rest...);
+}
 
-  // Check if result is Err
-  bool is_err() const {
-    return nonstd::holds_alternative<E>(value_);
-  }
+// Metadata emitted by the ENUM_VARIANT macros, or defaults without it
+template <typename T>
+constexpr auto reflected_name(int) noexcept -> decltype(T::rustcxx_name()) {
+  return T::rustcxx_name();
+}
 
-  // Get the Ok value (throws if Err)
-  T& unwrap() {
-    if (is_err()) {
-      throw std::runtime_error("Called unwrap() on an Err Result");
-    }
-    return nonstd::get<T>(value_);
-  }
+template <typename T>
+constexpr const char* reflected_name(long) noexcept {
+  return "";
+}
 
-  const T& unwrap() const {
-    if (is_err()) {
-      throw std::runtime_error("Called unwrap() on an Err Result");
-    }
-    return nonstd::get<T>(value_);
-  }
+template <typename T>
+constexpr auto reflected_field_count(int) noexcept
+    -> decltype(T::rustcxx_field_count()) {
+  return T::rustcxx_field_count();
+}
 
-  // Get the Ok value or a default
-  template <typename U>
-  T unwrap_or(U&& default_value) const {
-    return is_ok() ? nonstd::get<T>(value_) : T(std::forward<U>(default_value));
-  }
+template <typename T>
+constexpr std::size_t reflected_field_count(long) noexcept {
+  return 0;
+}
 
-  // Get the error value (throws if Ok)
-  E& unwrap_err() {
-    if (is_ok()) {
-      throw std::runtime_error("Called unwrap_err() on an Ok Result");
-    }
-    return nonstd::get<E>(value_);
-  }
+template <typename T>
+constexpr auto reflected_field_name(int, std::size_t i) noexcept
+    -> decltype(T::rustcxx_field_name(i)) {
+  return T::rustcxx_field_name(i);
+}
 
-  const E& unwrap_err() const {
-    if (is_ok()) {
-      throw std::runtime_error("Called unwrap_err() on an Ok Result");
-    }
-    return nonstd::get<E>(value_);
-  }
+template <typename T>
+constexpr const char* reflected_field_name(long, std::size_t) noexcept {
+  return nullptr;
+}
 
-  // Map function - transform Ok value, leave Err unchanged
-  template <typename F>
-  auto map(F&& f) -> Result<decltype(f(std::declval<T>())), E> {
-    typedef Result<decltype(f(std::declval<T>())), E> result;
-    if (is_ok()) {
-      return result::Ok(f(nonstd::get<T>(value_)));
-    } else {
-      return result::Err(nonstd::get<E>(value_));
-    }
-  }
+}  // namespace detail
 
-  // Map error function - transform Err value, leave Ok unchanged
-  template <typename F>
-  auto map_err(F&& f) -> Result<T, decltype(f(std::declval<E>()))> {
-    typedef Result<T, decltype(f(std::declval<E>()))> result;
-    if (is_err()) {
-      return result::Err(f(nonstd::get<E>(value_)));
-    } else {
-      return result::Ok(nonstd::get<T>(value_));
-    }
+// Compile-time description of a variant type. ENUM_VARIANT0..7 provide the
+// name and field names; ENUM_VARIANT(name, decls...) the name only. Other
+// types report an empty name unless this is specialized for them.
+//
+//   ENUM_VARIANT2(Move, int, dx, int, dy);
+//   static_assert(rust::variant_traits<Move>::field_count() == 2, "");
+template <typename T>
+struct variant_traits {
+  static constexpr const char* name() noexcept {
+    return detail::reflected_name<T>(0);
   }
 
-  // And then - chain Results
-  template <typename F>
-  auto and_then(F&& f) -> decltype(f(std::declval<T>())) {
-    if (is_ok()) {
-      return f(nonstd::get<T>(value_));
-    } else {
-      typedef decltype(f(std::declval<T>())) result;
-      return result::Err(nonstd::get<E>(value_));
-    }
+  static constexpr std::size_t field_count() noexcept {
+    return detail::reflected_field_count<T>(0);
   }
 
-  // Pattern matching
-  template <typename... Ts>
-  auto match(Ts&&... ts) {
-    return rust::match(value_, std::forward<Ts>(ts)...);
+  // NULL when i >= field_count()
+  static constexpr const char* field_name(std::size_t i) noexcept {
+    return detail::reflected_field_name<T>(0, i);
   }
+};
 
-  template <typename... Ts>
-  auto match(Ts&&... ts) const {
-    return rust::match(value_, std::forward<Ts>(ts)...);
+// Index of alternative T in an Enum, as a constant
+//
+//   static_assert(rust::index_of<Blue, Color>::value == 2, "");
+template <typename T, typename E>
+struct index_of;
+
+template <typename T, typename... Types>
+struct index_of<T, Enum<Types...> >
+    : std::integral_constant<std::size_t,
+                             detail::index_of<T, Types...>::value> {
+  static_assert(detail::index_of<T, Types...>::value < sizeof...(Types),
+                "T is not an alternative of this Enum");
+};
+
+// Number of alternatives of an Enum
+template <typename E>
+struct variant_count;
+
+template <typename... Types>
+struct variant_count<Enum<Types...> >
+    : std::integral_constant<std::size_t, sizeof...(Types)> {};
+
+// Name of the alternative an Enum holds: one lookup in a constant table
+// indexed by index(); empty for valueless Enums
+template <typename... Types>
+inline const char* variant_name(const Enum<Types...>& e) noexcept {
+  static constexpr const char* names[] = {variant_traits<Types>::name()...};
+  const std::size_t index = e.index();
+  return index < sizeof...(Types) ? names[index] : "";
+}
+
+namespace detail {
+
+template <typename... Types>
+struct stats_names<Enum<Types...> > {
+  static const char* at(std::size_t index) noexcept {
+    static constexpr const char* names[] = {variant_traits<Types>::name()...};
+    return index < sizeof...(Types) ? names[index] : "";
   }
+};
 
- private:
-  template <typename U>
-  explicit Result(U&& u) : value_(std::forward<U>(u)) {}
+}  // namespace detail
+
+// Conversion of an error propagated by RUSTCXX_TRY, like Rust's From.
+// Constructs To from the error by default; specialize it for conversions
+// no constructor expresses:
+//
+//   template <>
+//   struct rust::From<AppError, IoError> {
+//     static AppError from(IoError e) { return AppError::io(e); }
+//   };
+template <typename To, typename Source>
+struct From {
+  template <typename Error>
+  static To from(Error&& error) {
+    return To(std::forward<Error>(error));
+  }
+};
 
-  nonstd::variant<T, E> value_;
+namespace detail {
+
+// E with the value category and constness of Owner: E& or const E& when
+// Owner is an lvalue reference, E otherwise
+template <typename Owner, typename E>
+struct forward_like {
+  typedef typename std::conditional<
+      std::is_const<typename std::remove_reference<Owner>::type>::value,
+      const E, E>::type qualified;
+  typedef typename std::conditional<std::is_lvalue_reference<Owner>::value,
+                                    qualified&, E>::type type;
 };
 
-// Rust-style Option type
-template <typename T>
-class Option {
+// What RUSTCXX_TRY returns for an Err: converts to whichever Result the
+// enclosing function returns, moving the error once through From
+template <typename Error>
+class err_residual {
  public:
-  // Construct Some option
-  static Option Some(T value) {
-    return Option(value);
+  explicit err_residual(Error&& error) noexcept
+      : error_(std::forward<Error>(error)) {}
+
+  template <typename U, typename F>
+  operator Result<U, F>() && {
+    typedef typename std::decay<Error>::type source;
+    return Result<U, F>::Err(From<F, source>::from(std::forward<Error>(error_)));
   }
 
-  // Construct None option
-  static Option None() {
-    return Option();
+ private:
+  Error&& error_;
+};
+
+// What RUSTCXX_TRY returns for a None
+struct none_residual {
+  template <typename U>
+  operator Option<U>() const {
+    return Option<U>::None();
   }
+};
 
-  // Default constructor creates None
-  Option() : value_() {}
+}  // namespace detail
 
-  ~Option() {}
+// How RUSTCXX_TRY takes a value apart, like Rust's Try trait: whether to
+// stop, the value to continue with, and what to return when stopping.
+// Provided for Result and Option; specialize it for other result types.
+template <typename R>
+struct try_;
 
-  // Check if option is Some
-  bool is_some() const { return value_.has_value(); }
+template <typename T, typename E>
+struct try_<Result<T, E> > {
+  static bool is_break(const Result<T, E>& r) noexcept { return r.is_err(); }
 
-  // Check if option is None
-  bool is_none() const { return !value_.has_value(); }
+  template <typename R>
+  static auto output(R&& r) -> decltype(std::forward<R>(r).unwrap_unchecked()) {
+    return std::forward<R>(r).unwrap_unchecked();
+  }
 
-  // Get the Some value (throws if None)
-  T& unwrap() {
-    if (is_none()) {
-      throw std::runtime_error("Called unwrap() on a None Option");
-    }
-    return *value_;
+  // Refers to the error in place; it is moved out of an rvalue Result, or
+  // copied out of an lvalue, when the residual converts
+  template <typename R>
+  static detail::err_residual<typename detail::forward_like<R, E>::type>
+  residual(R&& r) noexcept {
+    typedef typename detail::forward_like<R, E>::type error;
+    return detail::err_residual<error>(
+        static_cast<error&&>(r.unwrap_err_unchecked()));
   }
+};
 
-  const T& unwrap() const {
-    if (is_none()) {
-      throw std::runtime_error("Called unwrap() on a None Option");
-    }
-    return *value_;
+template <typename T>
+struct try_<Option<T> > {
+  static bool is_break(const Option<T>& o) noexcept { return o.is_none(); }
+
+  template <typename R>
+  static auto output(R&& o) noexcept
+      -> decltype(std::forward<R>(o).unwrap_unchecked()) {
+    return std::forward<R>(o).unwrap_unchecked();
   }
 
-  // Get the Some value or a default
-  template <typename U>
-  T unwrap_or(U&& default_value) const {
-    return is_some() ? *value_ : T(std::forward<U>(default_value));
+  template <typename R>
+  static detail::none_residual residual(R&&) noexcept {
+    return detail::none_residual();
   }
+};
 
-  // Map function - transform Some value, leave None unchanged
-  template <typename F>
-  auto map(F&& f) -> Option<decltype(f(std::declval<T>()))> {
-    typedef Option<decltype(f(std::declval<T>()))> option;
-    if (is_some()) {
-      return option::Some(f(*value_));
-    } else {
-      return option::None();
+namespace detail {
+
+// Hashes mix in the discriminant, so that equal payloads held by different
+// alternatives (or by Ok and Err) hash apart
+template <typename... Types>
+struct enum_hash {
+  std::size_t operator()(const Enum<Types...>& e) const {
+    const std::size_t index = e.index();
+    if (index >= sizeof...(Types)) {
+      return index;
     }
+    // Through the storage, so that hashing is not counted as a match
+    return hash_combine(
+        index, match(enum_access::storage(e), alternative_hasher()));
   }
+};
 
-  // And then - chain Options
-  template <typename F>
-  auto and_then(F&& f) -> decltype(f(std::declval<T>())) {
-    if (is_some()) {
-      return f(*value_);
-    } else {
-      typedef decltype(f(std::declval<T>())) option;
-      return option::None();
+template <typename T>
+struct option_hash {
+  std::size_t operator()(const Option<T>& o) const {
+    if (o.is_none()) {
+      return 0;
     }
+    return hash_combine(1, hash_value(o.unwrap_unchecked()));
   }
+};
 
-  // Pattern matching using variant-like interface
-  template <typename SomeFunc, typename NoneFunc>
-  auto match(SomeFunc&& some_func, NoneFunc&& none_func) {
-    if (is_some()) {
-      return some_func(*value_);
-    } else {
-      return none_func();
+template <typename T, typename E>
+struct result_hash {
+  std::size_t operator()(const Result<T, E>& r) const {
+    if (r.is_ok()) {
+      return hash_combine(0, hash_value(r.unwrap_unchecked()));
     }
+    return hash_combine(1, hash_value(r.unwrap_err_unchecked()));
   }
-
- private:
-  explicit Option(T value) : value_(value) {}
-
-  nonstd::optional<T> value_;
 };
 
+}  // namespace detail
+
 }  // namespace rust
 
+// Enabled when every payload type of the Enum, Option or Result is hashable
+namespace std {
+
+template <typename... Types>
+struct hash<rust::Enum<Types...> >
+    : std::conditional<rust::detail::all_of<rust::detail::is_hashable<
+                           Types>::value...>::value,
+                       rust::detail::enum_hash<Types...>,
+                       rust::detail::disabled_hash>::type {};
+
+template <typename T>
+struct hash<rust::Option<T> >
+    : std::conditional<rust::detail::is_hashable<T>::value,
+                       rust::detail::option_hash<T>,
+                       rust::detail::disabled_hash>::type {};
+
+template <typename T, typename E>
+struct hash<rust::Result<T, E> >
+    : std::conditional<rust::detail::is_hashable<T>::value &&
+                           rust::detail::is_hashable<E>::value,
+                       rust::detail::result_hash<T, E>,
+                       rust::detail::disabled_hash>::type {};
+
+}  // namespace std
+
+
+// Reflection metadata emitted into every variant struct, read through
+// rust::variant_traits
+#define RUSTCXX_VARIANT_NAME(name)                          \
+  static constexpr const char* rustcxx_name() noexcept {    \
+    return #name;                                           \
+  }
+
+#define RUSTCXX_VARIANT_FIELDS(count, ...)                              \
+  static constexpr std::size_t rustcxx_field_count() noexcept {         \
+    return count;                                                       \
+  }                                                                     \
+  static constexpr const char* rustcxx_field_name(std::size_t i) noexcept { \
+    return ::rust::detail::name_at(i, __VA_ARGS__);                     \
+  }
+
+// References to the fields in declaration order, for field-wise
+// serialization. Must follow the field declarations.
+#define RUSTCXX_VARIANT_TIE(...)                                          \
+  auto rustcxx_fields() const -> decltype(std::tie(__VA_ARGS__)) {        \
+    return std::tie(__VA_ARGS__);                                         \
+  }                                                                       \
+  auto rustcxx_fields() -> decltype(std::tie(__VA_ARGS__)) {              \
+    return std::tie(__VA_ARGS__);                                         \
+  }
+
+// Equality of ENUM_VARIANT(name, decls...), whose declarations cannot be
+// split into fields: defaulted from C++20, bytewise before. The template
+// defers the bytewise check to the first comparison.
+#if RUSTCXX_HAS_DEFAULTED_EQUALITY
+#define RUSTCXX_VARIANT_DECLARED_EQUALITY(name) \
+  bool operator==(const name&) const = default;
+#else
+#define RUSTCXX_VARIANT_DECLARED_EQUALITY(name)                              \
+  template <typename Self, typename = typename std::enable_if<               \
+                               std::is_same<Self, name>::value>::type>       \
+  bool operator==(const Self& other) const {                                 \
+    return ::rust::detail::bytes_equal<Self>(*this, other);                  \
+  }                                                                          \
+  template <typename Self, typename = typename std::enable_if<               \
+                               std::is_same<Self, name>::value>::type>       \
+  bool operator!=(const Self& other) const {                                 \
+    return !::rust::detail::bytes_equal<Self>(*this, other);                 \
+  }
+#endif
 
 // ENUM_VARIANT: original macro supporting both no-field and field variants (for compatibility)
+// A variant with fields hashes its bytes, so it is only hashable when the
+// bytes determine its value
 #define INTERNAL_ENUM_VARIANT_WITH_FIELDS(name, ...)                         \
   struct name {                                                              \
     __VA_ARGS__;                                                             \
-    bool operator==(const name& other) const { return true; }                \
-    bool operator!=(const name& other) const { return false; }               \
+    RUSTCXX_VARIANT_NAME(name)                                               \
+    RUSTCXX_VARIANT_DECLARED_EQUALITY(name)                                  \
+    template <typename Self = name,                                          \
+              typename = typename std::enable_if<                            \
+                  ::rust::detail::has_unique_bytes<Self>::value>::type>      \
+    std::size_t rustcxx_hash() const {                                       \
+      return ::rust::detail::bytes_hash<Self>(*this);                        \
+    }                                                                        \
   }
 
 #define INTERNAL_ENUM_VARIANT_NO_FIELDS(name)                      \
   struct name {                                                    \
+    RUSTCXX_VARIANT_NAME(name)                                     \
     inline constexpr bool operator==(const name&) const noexcept { \
       return true;                                                 \
     }                                                              \
     inline constexpr bool operator!=(const name&) const noexcept { \
       return false;                                                \
     }                                                              \
+    std::size_t rustcxx_hash() const noexcept { return 0; }        \
   }
 
 #define GET_DISPATCH_MACRO(_1, _2, NAME, ...) NAME
@@ -345,96 +2900,159 @@ class Option {
 // ENUM_VARIANT0: no fields
 #define ENUM_VARIANT0(name) \
   struct name { \
+    RUSTCXX_VARIANT_NAME(name) \
     name() = default; \
-    ~name() = default; \
     bool operator==(const name&) const { return true; } \
     bool operator!=(const name&) const { return false; } \
+    std::size_t rustcxx_hash() const noexcept { return 0; } \
   }
 
 // ENUM_VARIANT1: 1 field (type, field)
 #define ENUM_VARIANT1(name, type1, field1) \
   struct name { \
+    RUSTCXX_VARIANT_NAME(name) \
+    RUSTCXX_VARIANT_FIELDS(1, #field1) \
     type1 field1; \
+    RUSTCXX_VARIANT_TIE(field1) \
     name() = default; \
-    ~name() = default; \
     explicit name(type1 v1) : field1(v1) {} \
-    bool operator==(const name&) const { return true; } \
-    bool operator!=(const name&) const { return false; } \
+    bool operator==(const name& other) const { \
+      return field1 == other.field1; \
+    } \
+    bool operator!=(const name& other) const { return !(*this == other); } \
+    static constexpr bool rustcxx_bitwise_comparable() noexcept { \
+      return ::rust::detail::bitwise_fields<sizeof(name), type1>::value; \
+    } \
+    std::size_t rustcxx_hash() const { \
+      return ::rust::detail::hash_fields(field1); \
+    } \
   }
 
 // ENUM_VARIANT2: 2 fields (type, field, type, field)
 #define ENUM_VARIANT2(name, type1, field1, type2, field2) \
   struct name { \
+    RUSTCXX_VARIANT_NAME(name) \
+    RUSTCXX_VARIANT_FIELDS(2, #field1, #field2) \
     type1 field1; \
     type2 field2; \
+    RUSTCXX_VARIANT_TIE(field1, field2) \
     name() = default; \
-    ~name() = default; \
     name(type1 v1, type2 v2) : field1(v1), field2(v2) {} \
-    bool operator==(const name&) const { return true; } \
-    bool operator!=(const name&) const { return false; } \
+    bool operator==(const name& other) const { \
+      return field1 == other.field1 && field2 == other.field2; \
+    } \
+    bool operator!=(const name& other) const { return !(*this == other); } \
+    static constexpr bool rustcxx_bitwise_comparable() noexcept { \
+      return ::rust::detail::bitwise_fields<sizeof(name), type1, type2>::value; \
+    } \
+    std::size_t rustcxx_hash() const { \
+      return ::rust::detail::hash_fields(field1, field2); \
+    } \
   }
 
 // ENUM_VARIANT3: 3 fields (type, field, ...)
 #define ENUM_VARIANT3(name, type1, field1, type2, field2, type3, field3) \
   struct name { \
+    RUSTCXX_VARIANT_NAME(name) \
+    RUSTCXX_VARIANT_FIELDS(3, #field1, #field2, #field3) \
     type1 field1; \
     type2 field2; \
     type3 field3; \
+    RUSTCXX_VARIANT_TIE(field1, field2, field3) \
     name() = default; \
-    ~name() = default; \
     name(type1 v1, type2 v2, type3 v3) : field1(v1), field2(v2), field3(v3) {} \
-    bool operator==(const name&) const { return true; } \
-    bool operator!=(const name&) const { return false; } \
+    bool operator==(const name& other) const { \
+      return field1 == other.field1 && field2 == other.field2 && field3 == other.field3; \
+    } \
+    bool operator!=(const name& other) const { return !(*this == other); } \
+    static constexpr bool rustcxx_bitwise_comparable() noexcept { \
+      return ::rust::detail::bitwise_fields<sizeof(name), type1, type2, type3>::value; \
+    } \
+    std::size_t rustcxx_hash() const { \
+      return ::rust::detail::hash_fields(field1, field2, field3); \
+    } \
   }
 
 // ENUM_VARIANT4: 4 fields (type, field, ...)
 #define ENUM_VARIANT4(name, type1, field1, type2, field2, type3, field3, type4, field4) \
   struct name { \
+    RUSTCXX_VARIANT_NAME(name) \
+    RUSTCXX_VARIANT_FIELDS(4, #field1, #field2, #field3, #field4) \
     type1 field1; \
     type2 field2; \
     type3 field3; \
     type4 field4; \
+    RUSTCXX_VARIANT_TIE(field1, field2, field3, field4) \
     name() = default; \
-    ~name() = default; \
     name(type1 v1, type2 v2, type3 v3, type4 v4) : field1(v1), field2(v2), field3(v3), field4(v4) {} \
-    bool operator==(const name&) const { return true; } \
-    bool operator!=(const name&) const { return false; } \
+    bool operator==(const name& other) const { \
+      return field1 == other.field1 && field2 == other.field2 && field3 == other.field3 && field4 == other.field4; \
+    } \
+    bool operator!=(const name& other) const { return !(*this == other); } \
+    static constexpr bool rustcxx_bitwise_comparable() noexcept { \
+      return ::rust::detail::bitwise_fields<sizeof(name), type1, type2, type3, type4>::value; \
+    } \
+    std::size_t rustcxx_hash() const { \
+      return ::rust::detail::hash_fields(field1, field2, field3, field4); \
+    } \
   }
 
 // ENUM_VARIANT5: 5 fields (type, field, ...)
 #define ENUM_VARIANT5(name, type1, field1, type2, field2, type3, field3, type4, field4, type5, field5) \
   struct name { \
+    RUSTCXX_VARIANT_NAME(name) \
+    RUSTCXX_VARIANT_FIELDS(5, #field1, #field2, #field3, #field4, #field5) \
     type1 field1; \
     type2 field2; \
     type3 field3; \
     type4 field4; \
     type5 field5; \
+    RUSTCXX_VARIANT_TIE(field1, field2, field3, field4, field5) \
     name() = default; \
-    ~name() = default; \
     name(type1 v1, type2 v2, type3 v3, type4 v4, type5 v5) : field1(v1), field2(v2), field3(v3), field4(v4), field5(v5) {} \
-    bool operator==(const name&) const { return true; } \
-    bool operator!=(const name&) const { return false; } \
+    bool operator==(const name& other) const { \
+      return field1 == other.field1 && field2 == other.field2 && field3 == other.field3 && field4 == other.field4 && field5 == other.field5; \
+    } \
+    bool operator!=(const name& other) const { return !(*this == other); } \
+    static constexpr bool rustcxx_bitwise_comparable() noexcept { \
+      return ::rust::detail::bitwise_fields<sizeof(name), type1, type2, type3, type4, type5>::value; \
+    } \
+    std::size_t rustcxx_hash() const { \
+      return ::rust::detail::hash_fields(field1, field2, field3, field4, field5); \
+    } \
   }
 
 // ENUM_VARIANT6: 6 fields (type, field, ...)
 #define ENUM_VARIANT6(name, type1, field1, type2, field2, type3, field3, type4, field4, type5, field5, type6, field6) \
   struct name { \
+    RUSTCXX_VARIANT_NAME(name) \
+    RUSTCXX_VARIANT_FIELDS(6, #field1, #field2, #field3, #field4, #field5, #field6) \
     type1 field1; \
     type2 field2; \
     type3 field3; \
     type4 field4; \
     type5 field5; \
     type6 field6; \
+    RUSTCXX_VARIANT_TIE(field1, field2, field3, field4, field5, field6) \
     name() = default; \
-    ~name() = default; \
     name(type1 v1, type2 v2, type3 v3, type4 v4, type5 v5, type6 v6) : field1(v1), field2(v2), field3(v3), field4(v4), field5(v5), field6(v6) {} \
-    bool operator==(const name&) const { return true; } \
-    bool operator!=(const name&) const { return false; } \
+    bool operator==(const name& other) const { \
+      return field1 == other.field1 && field2 == other.field2 && field3 == other.field3 && field4 == other.field4 && field5 == other.field5 && field6 == other.field6; \
+    } \
+    bool operator!=(const name& other) const { return !(*this == other); } \
+    static constexpr bool rustcxx_bitwise_comparable() noexcept { \
+      return ::rust::detail::bitwise_fields<sizeof(name), type1, type2, type3, type4, type5, type6>::value; \
+    } \
+    std::size_t rustcxx_hash() const { \
+      return ::rust::detail::hash_fields(field1, field2, field3, field4, field5, field6); \
+    } \
   }
 
 // ENUM_VARIANT7: 7 fields (type, field, ...)
 #define ENUM_VARIANT7(name, type1, field1, type2, field2, type3, field3, type4, field4, type5, field5, type6, field6, type7, field7) \
   struct name { \
+    RUSTCXX_VARIANT_NAME(name) \
+    RUSTCXX_VARIANT_FIELDS(7, #field1, #field2, #field3, #field4, #field5, #field6, #field7) \
     type1 field1; \
     type2 field2; \
     type3 field3; \
@@ -442,9 +3060,17 @@ class Option {
     type5 field5; \
     type6 field6; \
     type7 field7; \
+    RUSTCXX_VARIANT_TIE(field1, field2, field3, field4, field5, field6, field7) \
     name() = default; \
-    ~name() = default; \
     name(type1 v1, type2 v2, type3 v3, type4 v4, type5 v5, type6 v6, type7 v7) : field1(v1), field2(v2), field3(v3), field4(v4), field5(v5), field6(v6), field7(v7) {} \
-    bool operator==(const name&) const { return true; } \
-    bool operator!=(const name&) const { return false; } \
+    bool operator==(const name& other) const { \
+      return field1 == other.field1 && field2 == other.field2 && field3 == other.field3 && field4 == other.field4 && field5 == other.field5 && field6 == other.field6 && field7 == other.field7; \
+    } \
+    bool operator!=(const name& other) const { return !(*this == other); } \
+    static constexpr bool rustcxx_bitwise_comparable() noexcept { \
+      return ::rust::detail::bitwise_fields<sizeof(name), type1, type2, type3, type4, type5, type6, type7>::value; \
+    } \
+    std::size_t rustcxx_hash() const { \
+      return ::rust::detail::hash_fields(field1, field2, field3, field4, field5, field6, field7); \
+    } \
   }
@@ -0,0 +1,801 @@
+/*
+ * Copyright (c) 2025 Dapeng Feng
+ * All rights reserved.
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Vector kernels of the discriminant scans (count_of, find_first_err,
+// compress_some); RUSTCXX_CONFIG_SIMD=0 keeps them scalar
+#if !defined(RUSTCXX_CONFIG_SIMD)
+#define RUSTCXX_CONFIG_SIMD 1
+#endif
+
+#if RUSTCXX_CONFIG_SIMD && defined(__AVX2__)
+#include <immintrin.h>
+#define RUSTCXX_SIMD_AVX2 1
+#elif RUSTCXX_CONFIG_SIMD && \
+    (defined(__SSE2__) || defined(_M_X64) || \
+     (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define RUSTCXX_SIMD_SSE2 1
+#elif RUSTCXX_CONFIG_SIMD && defined(__ARM_NEON) && \
+    (defined(__aarch64__) || defined(_M_ARM64))
+#include <arm_neon.h>
+#define RUSTCXX_SIMD_NEON 1
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+#include "rustcxx.hpp"
+#include "rustcxx_enum_vec.hpp"
+
+namespace rust {
+
+// Selects the order-preserving mode of match_all
+struct preserve_order_t {};
+
+const preserve_order_t preserve_order = preserve_order_t();
+
+namespace detail {
+
+template <typename E>
+struct enum_size;
+
+template <typename... Ts>
+struct enum_size<Enum<Ts...> >
+    : std::integral_constant<std::size_t, sizeof...(Ts)> {};
+
+template <typename E>
+struct enum_size<const E> : enum_size<E> {};
+
+template <typename Range>
+struct range_element {
+  typedef typename std::remove_reference<decltype(
+      *std::begin(std::declval<Range&>()))>::type type;
+};
+
+// Runs arm I over the elements of one bucket
+template <std::size_t I, typename Visitor, typename E>
+inline void match_bucket(Visitor& visitor, E* const* first, E* const* last) {
+  for (; first != last; ++first) {
+    visitor((*first)->template get_unchecked<I>());
+  }
+}
+
+template <typename Visitor, typename E, std::size_t... Is>
+inline void match_buckets(Visitor& visitor, E* const* order,
+                          const std::size_t* offsets, index_sequence<Is...>) {
+  int expand[] = {
+      (match_bucket<Is>(visitor, order + offsets[Is], order + offsets[Is + 1]),
+       0)...};
+  static_cast<void>(expand);
+}
+
+// Scratch for the sorted addresses, kept per thread so that repeated
+// calls do not allocate. Buffers past the limit are freed after use.
+static const std::size_t grouped_scratch_limit = 4096;
+
+template <typename E>
+inline std::vector<E*>& grouped_scratch() {
+  thread_local std::vector<E*> scratch;
+  return scratch;
+}
+
+// Counting sort of the element addresses by index(), then one tight loop
+// per alternative: the arm is a direct call instead of a per-element
+// indirect branch. Elements of one alternative keep their relative order.
+template <typename Range, typename Visitor>
+inline void match_grouped(Range& range, Visitor& visitor) {
+  typedef typename range_element<Range>::type element;
+  static const std::size_t size = enum_size<element>::value;
+
+  std::size_t offsets[size + 1] = {};
+  std::size_t count = 0;
+  for (auto it = std::begin(range); it != std::end(range); ++it) {
+    const std::size_t index = it->index();
+    if (RUSTCXX_UNLIKELY(index >= size)) {
+      bad_variant_access();
+    }
+    ++offsets[index + 1];
+    ++count;
+  }
+  if (count == 0) {
+    return;
+  }
+  for (std::size_t i = 0; i < size; ++i) {
+    offsets[i + 1] += offsets[i];
+  }
+
+  // Taken rather than borrowed: a visitor that calls match_all again
+  // finds the scratch empty and uses its own
+  std::vector<element*> order;
+  order.swap(grouped_scratch<element>());
+  order.resize(count);
+  std::size_t cursor[size];
+  for (std::size_t i = 0; i < size; ++i) {
+    cursor[i] = offsets[i];
+  }
+  for (auto it = std::begin(range); it != std::end(range); ++it) {
+    order[cursor[it->index()]++] = &*it;
+  }
+
+  match_buckets(visitor, order.data(), offsets,
+                typename make_index_sequence<size>::type());
+  if (order.capacity() <= grouped_scratch_limit) {
+    order.clear();
+    order.swap(grouped_scratch<element>());
+  }
+}
+
+// Runs arm I over a run of elements that all hold alternative I
+template <std::size_t I, typename Visitor, typename Iterator>
+inline void match_run(Visitor& visitor, Iterator first, Iterator last) {
+  for (; first != last; ++first) {
+    visitor(first->template get_unchecked<I>());
+  }
+}
+
+template <typename Visitor, typename Iterator>
+inline void match_run_ladder(Visitor&, Iterator, Iterator, std::size_t,
+                             index_sequence<>) {
+  bad_variant_access();
+}
+
+template <typename Visitor, typename Iterator, std::size_t I,
+          std::size_t... Is>
+inline void match_run_ladder(Visitor& visitor, Iterator first, Iterator last,
+                             std::size_t index, index_sequence<I, Is...>) {
+  if (index == I) {
+    match_run<I>(visitor, first, last);
+    return;
+  }
+  match_run_ladder(visitor, first, last, index, index_sequence<Is...>());
+}
+
+// Splits the range into runs of equal index() and dispatches once per run,
+// so the arms still see the elements in their original order
+template <typename Range, typename Visitor>
+inline void match_ordered(Range& range, Visitor& visitor) {
+  typedef typename range_element<Range>::type element;
+  typedef typename make_index_sequence<enum_size<element>::value>::type
+      indices;
+
+  auto first = std::begin(range);
+  const auto last = std::end(range);
+  while (first != last) {
+    const std::size_t index = first->index();
+    auto run_end = first;
+    do {
+      ++run_end;
+    } while (run_end != last && run_end->index() == index);
+    match_run_ladder(visitor, first, run_end, index, indices());
+    first = run_end;
+  }
+}
+
+}  // namespace detail
+
+// Matches every Enum of a range, grouped by alternative: all elements
+// holding the first alternative are visited, then the second, and so on.
+// Visitors may take the alternatives by reference and mutate them. With
+// few alternatives and cheap arms, preserve_order is usually faster.
+//
+//   rust::match_all(events, [](Connect& c) { ... }, [](Send& s) { ... });
+template <typename Range, typename... Ts,
+          typename = typename std::enable_if<!std::is_same<
+              typename std::decay<Range>::type, preserve_order_t>::value>::type>
+inline void match_all(Range&& range, Ts&&... ts) {
+  auto&& visitor = detail::make_visitor(std::forward<Ts>(ts)...);
+  detail::match_grouped(range, visitor);
+}
+
+// Order-preserving variant for side-effecting visitors: elements are
+// visited in range order, with one dispatch per run of equal alternatives
+template <typename Range, typename... Ts>
+inline void match_all(preserve_order_t, Range&& range, Ts&&... ts) {
+  auto&& visitor = detail::make_visitor(std::forward<Ts>(ts)...);
+  detail::match_ordered(range, visitor);
+}
+
+namespace detail {
+
+// Element of Range with the value category of Range itself, so that
+// algorithms given an rvalue range move the payloads out
+template <typename Range, typename T>
+inline typename std::conditional<std::is_lvalue_reference<Range>::value, T&,
+                                 T&&>::type
+forward_element(T& element) noexcept {
+  return static_cast<typename std::conditional<
+      std::is_lvalue_reference<Range>::value, T&, T&&>::type>(element);
+}
+
+template <typename Vector, typename Iterator>
+inline void reserve_for(Vector& values, Iterator first, Iterator last,
+                        std::forward_iterator_tag) {
+  values.reserve(static_cast<std::size_t>(std::distance(first, last)));
+}
+
+template <typename Vector, typename Iterator>
+inline void reserve_for(Vector&, Iterator, Iterator, std::input_iterator_tag) {}
+
+template <typename Vector, typename Iterator>
+inline void reserve_for(Vector& values, Iterator first, Iterator last) {
+  reserve_for(values, first, last,
+              typename std::iterator_traits<Iterator>::iterator_category());
+}
+
+template <typename Element>
+struct collect_impl;
+
+template <typename T, typename E>
+struct collect_impl<Result<T, E> > {
+  typedef Result<std::vector<T>, E> result_type;
+
+  template <typename Range>
+  static result_type apply(Range&& range) {
+    std::vector<T> values;
+    reserve_for(values, std::begin(range), std::end(range));
+    for (auto it = std::begin(range); it != std::end(range); ++it) {
+      if (RUSTCXX_UNLIKELY(it->is_err())) {
+        return result_type::Err(
+            forward_element<Range>(*it).unwrap_err_unchecked());
+      }
+      values.push_back(forward_element<Range>(*it).unwrap_unchecked());
+    }
+    return result_type::Ok(std::move(values));
+  }
+};
+
+template <typename T>
+struct collect_impl<Option<T> > {
+  typedef Option<std::vector<T> > result_type;
+
+  template <typename Range>
+  static result_type apply(Range&& range) {
+    std::vector<T> values;
+    reserve_for(values, std::begin(range), std::end(range));
+    for (auto it = std::begin(range); it != std::end(range); ++it) {
+      if (RUSTCXX_UNLIKELY(it->is_none())) {
+        return result_type::None();
+      }
+      values.push_back(forward_element<Range>(*it).unwrap_unchecked());
+    }
+    return result_type::Some(std::move(values));
+  }
+};
+
+// Short-circuit protocol of try_fold: Ok/Some continue, Err/None stop
+template <typename R>
+struct try_traits;
+
+template <typename T, typename E>
+struct try_traits<Result<T, E> > {
+  static bool is_continue(const Result<T, E>& r) noexcept { return r.is_ok(); }
+
+  template <typename U>
+  static Result<T, E> from_output(U&& value) {
+    return Result<T, E>::Ok(std::forward<U>(value));
+  }
+};
+
+template <typename T>
+struct try_traits<Option<T> > {
+  static bool is_continue(const Option<T>& o) noexcept { return o.is_some(); }
+
+  template <typename U>
+  static Option<T> from_output(U&& value) {
+    return Option<T>::Some(std::forward<U>(value));
+  }
+};
+
+template <typename Range>
+struct collect_element {
+  typedef typename std::decay<decltype(
+      *std::begin(std::declval<Range&>()))>::type type;
+};
+
+}  // namespace detail
+
+// Collects a range of Result<T, E> into Result<std::vector<T>, E>, or a
+// range of Option<T> into Option<std::vector<T>>, stopping at the first
+// Err or None. Payloads are moved out when the range is an rvalue.
+//
+//   auto parsed = rust::collect(std::move(results));  // Result<vector<T>, E>
+template <typename Range>
+inline typename detail::collect_impl<
+    typename detail::collect_element<Range>::type>::result_type
+collect(Range&& range) {
+  return detail::collect_impl<typename detail::collect_element<Range>::type>::
+      apply(std::forward<Range>(range));
+}
+
+// Splits a range of Result<T, E> into its Ok values and its errors, both
+// in range order. Payloads are moved out when the range is an rvalue.
+template <typename Range,
+          typename Element = typename detail::collect_element<Range>::type,
+          typename T = typename Element::ok_type,
+          typename E = typename Element::err_type>
+inline std::pair<std::vector<T>, std::vector<E> > partition_results(
+    Range&& range) {
+  std::size_t oks = 0;
+  std::size_t errs = 0;
+  for (auto it = std::begin(range); it != std::end(range); ++it) {
+    if (it->is_ok()) {
+      ++oks;
+    } else {
+      ++errs;
+    }
+  }
+
+  std::pair<std::vector<T>, std::vector<E> > parts;
+  parts.first.reserve(oks);
+  parts.second.reserve(errs);
+  for (auto it = std::begin(range); it != std::end(range); ++it) {
+    if (it->is_ok()) {
+      parts.first.push_back(
+          detail::forward_element<Range>(*it).unwrap_unchecked());
+    } else {
+      parts.second.push_back(
+          detail::forward_element<Range>(*it).unwrap_err_unchecked());
+    }
+  }
+  return parts;
+}
+
+// Folds a range with an f that returns Result<Acc, E> (or Option<Acc>),
+// stopping at the first Err (or None) like Rust's Iterator::try_fold.
+// The accumulator is moved from step to step.
+//
+//   auto total = rust::try_fold(lines, 0, [](int sum, const std::string& s) {
+//     return parse_int(s).map([&](int v) { return sum + v; });
+//   });
+template <typename Range, typename Acc, typename F>
+inline auto try_fold(Range&& range, Acc init, F&& f)
+    -> decltype(f(std::move(init),
+                  detail::forward_element<Range>(*std::begin(range)))) {
+  typedef decltype(f(std::move(init),
+                     detail::forward_element<Range>(*std::begin(range))))
+      step_type;
+  typedef detail::try_traits<step_type> traits;
+
+  Acc acc(std::move(init));
+  for (auto it = std::begin(range); it != std::end(range); ++it) {
+    step_type step = f(std::move(acc), detail::forward_element<Range>(*it));
+    if (RUSTCXX_UNLIKELY(!traits::is_continue(step))) {
+      return step;
+    }
+    acc = std::move(step).unwrap_unchecked();
+  }
+  return traits::from_output(std::move(acc));
+}
+
+namespace detail {
+
+// The one-byte discriminant of an element type, when scans can read it
+// in place: Enums and Results of fewer than 255 alternatives, and Options
+// of such Enums (None is the niche value one past the last alternative)
+template <typename E>
+struct tag_byte {
+  static const bool available = false;
+};
+
+template <typename Layout>
+struct tag_byte_of_layout {
+  static const bool available = Layout::discriminant_size == 1;
+  static const std::size_t offset = Layout::discriminant_offset;
+};
+
+template <typename... Ts>
+struct tag_byte<Enum<Ts...> >
+    : tag_byte_of_layout<layout_of<Enum<Ts...> > > {};
+
+template <typename T, typename E>
+struct tag_byte<Result<T, E> >
+    : tag_byte_of_layout<layout_of<Result<T, E> > > {};
+
+template <typename... Ts>
+struct tag_byte<Option<Enum<Ts...> > > : tag_byte<Enum<Ts...> > {
+  static const unsigned char none = static_cast<unsigned char>(sizeof...(Ts));
+};
+
+template <typename E>
+struct tag_byte<const E> : tag_byte<E> {};
+
+// Position of the lowest set bit; mask is not 0
+inline unsigned lowest_bit32(std::uint32_t mask) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<unsigned>(__builtin_ctz(mask));
+#elif defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return static_cast<unsigned>(index);
+#else
+  unsigned index = 0;
+  while ((mask & 1u) == 0) {
+    mask >>= 1;
+    ++index;
+  }
+  return index;
+#endif
+}
+
+// Byte operations on one vector register: equal() sets the bytes that
+// match to 0xFF, tally() adds those matches to per-byte counters (at most
+// 255 times before sum()), mask() packs one bit per byte
+#if RUSTCXX_SIMD_AVX2
+struct tag_vector {
+  typedef __m256i type;
+  static const std::size_t width = 32;
+
+  static type load(const unsigned char* p) noexcept {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+  }
+  static type splat(unsigned char value) noexcept {
+    return _mm256_set1_epi8(static_cast<char>(value));
+  }
+  static type zero() noexcept { return _mm256_setzero_si256(); }
+  static type equal(type a, type b) noexcept { return _mm256_cmpeq_epi8(a, b); }
+  static type both(type a, type b) noexcept { return _mm256_and_si256(a, b); }
+  static type tally(type counts, type matches) noexcept {
+    return _mm256_sub_epi8(counts, matches);
+  }
+  static std::size_t sum(type counts) noexcept {
+    const __m256i sums = _mm256_sad_epu8(counts, zero());
+    const __m128i half = _mm_add_epi64(_mm256_castsi256_si128(sums),
+                                       _mm256_extracti128_si256(sums, 1));
+    return static_cast<std::size_t>(_mm_cvtsi128_si32(half)) +
+           static_cast<std::size_t>(_mm_extract_epi16(half, 4));
+  }
+  static std::uint32_t mask(type matches) noexcept {
+    return static_cast<std::uint32_t>(_mm256_movemask_epi8(matches));
+  }
+};
+#elif RUSTCXX_SIMD_SSE2
+struct tag_vector {
+  typedef __m128i type;
+  static const std::size_t width = 16;
+
+  static type load(const unsigned char* p) noexcept {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+  }
+  static type splat(unsigned char value) noexcept {
+    return _mm_set1_epi8(static_cast<char>(value));
+  }
+  static type zero() noexcept { return _mm_setzero_si128(); }
+  static type equal(type a, type b) noexcept { return _mm_cmpeq_epi8(a, b); }
+  static type both(type a, type b) noexcept { return _mm_and_si128(a, b); }
+  static type tally(type counts, type matches) noexcept {
+    return _mm_sub_epi8(counts, matches);
+  }
+  static std::size_t sum(type counts) noexcept {
+    const __m128i sums = _mm_sad_epu8(counts, zero());
+    return static_cast<std::size_t>(_mm_cvtsi128_si32(sums)) +
+           static_cast<std::size_t>(_mm_extract_epi16(sums, 4));
+  }
+  static std::uint32_t mask(type matches) noexcept {
+    return static_cast<std::uint32_t>(_mm_movemask_epi8(matches));
+  }
+};
+#elif RUSTCXX_SIMD_NEON
+struct tag_vector {
+  typedef uint8x16_t type;
+  static const std::size_t width = 16;
+
+  static type load(const unsigned char* p) noexcept { return vld1q_u8(p); }
+  static type splat(unsigned char value) noexcept { return vdupq_n_u8(value); }
+  static type zero() noexcept { return vdupq_n_u8(0); }
+  static type equal(type a, type b) noexcept { return vceqq_u8(a, b); }
+  static type both(type a, type b) noexcept { return vandq_u8(a, b); }
+  static type tally(type counts, type matches) noexcept {
+    return vsubq_u8(counts, matches);
+  }
+  static std::size_t sum(type counts) noexcept {
+    return static_cast<std::size_t>(vaddlvq_u8(counts));
+  }
+  static std::uint32_t mask(type matches) noexcept {
+    static const unsigned char weights[16] = {1, 2, 4, 8, 16, 32, 64, 128,
+                                              1, 2, 4, 8, 16, 32, 64, 128};
+    const uint8x16_t bits = vandq_u8(matches, vld1q_u8(weights));
+    return static_cast<std::uint32_t>(vaddv_u8(vget_low_u8(bits))) |
+           static_cast<std::uint32_t>(vaddv_u8(vget_high_u8(bits))) << 8;
+  }
+};
+#endif
+
+#if RUSTCXX_SIMD_AVX2 || RUSTCXX_SIMD_SSE2 || RUSTCXX_SIMD_NEON
+#define RUSTCXX_HAS_TAG_VECTOR 1
+#else
+#define RUSTCXX_HAS_TAG_VECTOR 0
+#endif
+
+// Discriminant bytes of count elements Stride bytes apart, the first at
+// tags, with extent bytes readable from tags. When Stride divides the
+// vector width, each load covers width / Stride elements and a constant
+// lane mask drops the payload bytes between them; other strides and the
+// tail are scanned one byte at a time.
+template <std::size_t Stride>
+class tag_scan {
+ public:
+  tag_scan(const unsigned char* tags, std::size_t count,
+           std::size_t extent) noexcept
+      : tags_(tags), count_(count), extent_(extent) {}
+
+  // Elements whose discriminant is value
+  std::size_t count(unsigned char value) const noexcept {
+    std::size_t total = 0;
+    std::size_t i = 0;
+#if RUSTCXX_HAS_TAG_VECTOR
+    if (vectorized) {
+      const tag_vector::type target = tag_vector::splat(value);
+      const tag_vector::type lanes = lane_bytes();
+      while (block_fits(i)) {
+        tag_vector::type counts = tag_vector::zero();
+        for (int round = 0; round < 255 && block_fits(i);
+             ++round, i += per_block) {
+          counts = tag_vector::tally(
+              counts, tag_vector::both(tag_vector::equal(load(i), target),
+                                       lanes));
+        }
+        total += tag_vector::sum(counts);
+      }
+    }
+#endif
+    for (; i < count_; ++i) {
+      total += tags_[i * Stride] == value;
+    }
+    return total;
+  }
+
+  // First element whose discriminant is value, count if none is
+  std::size_t find(unsigned char value) const noexcept {
+    std::size_t i = 0;
+#if RUSTCXX_HAS_TAG_VECTOR
+    if (vectorized) {
+      const tag_vector::type target = tag_vector::splat(value);
+      for (; block_fits(i); i += per_block) {
+        const std::uint32_t hits =
+            tag_vector::mask(tag_vector::equal(load(i), target)) & lane_bits();
+        if (hits != 0) {
+          return i + lowest_bit32(hits) / Stride;
+        }
+      }
+    }
+#endif
+    for (; i < count_; ++i) {
+      if (tags_[i * Stride] == value) {
+        return i;
+      }
+    }
+    return count_;
+  }
+
+  // Calls f(i), in order, for every element whose discriminant is not value
+  template <typename F>
+  void for_each_other(unsigned char value, F&& f) const {
+    std::size_t i = 0;
+#if RUSTCXX_HAS_TAG_VECTOR
+    if (vectorized) {
+      const tag_vector::type target = tag_vector::splat(value);
+      for (; block_fits(i); i += per_block) {
+        std::uint32_t others =
+            ~tag_vector::mask(tag_vector::equal(load(i), target)) &
+            lane_bits();
+        while (others != 0) {
+          f(i + lowest_bit32(others) / Stride);
+          others &= others - 1;
+        }
+      }
+    }
+#endif
+    for (; i < count_; ++i) {
+      if (tags_[i * Stride] != value) {
+        f(i);
+      }
+    }
+  }
+
+ private:
+#if RUSTCXX_HAS_TAG_VECTOR
+  static const bool vectorized =
+      Stride <= tag_vector::width && tag_vector::width % Stride == 0;
+  static const std::size_t per_block = vectorized ? tag_vector::width / Stride
+                                                  : 1;
+
+  bool block_fits(std::size_t i) const noexcept {
+    return i * Stride + tag_vector::width <= extent_;
+  }
+
+  tag_vector::type load(std::size_t i) const noexcept {
+    return tag_vector::load(tags_ + i * Stride);
+  }
+
+  // 0xFF at the discriminant bytes of a block, 0 at the payload bytes
+  static tag_vector::type lane_bytes() noexcept {
+    unsigned char lanes[tag_vector::width] = {};
+    for (std::size_t b = 0; b < tag_vector::width; b += Stride) {
+      lanes[b] = 0xFF;
+    }
+    return tag_vector::load(lanes);
+  }
+
+  static std::uint32_t lane_bits() noexcept {
+    std::uint32_t bits = 0;
+    for (std::size_t b = 0; b < tag_vector::width; b += Stride) {
+      bits |= std::uint32_t(1) << b;
+    }
+    return bits;
+  }
+#endif
+
+  const unsigned char* tags_;
+  std::size_t count_;
+  std::size_t extent_;
+};
+
+#if RUSTCXX_HAS_TAG_VECTOR
+template <std::size_t Stride>
+const bool tag_scan<Stride>::vectorized;
+
+template <std::size_t Stride>
+const std::size_t tag_scan<Stride>::per_block;
+#endif
+
+template <typename E>
+inline tag_scan<sizeof(E)> make_tag_scan(const E* first,
+                                         std::size_t count) noexcept {
+  const unsigned char* bytes = reinterpret_cast<const unsigned char*>(first);
+  const std::size_t extent =
+      count == 0 ? 0 : count * sizeof(E) - tag_byte<E>::offset;
+  return tag_scan<sizeof(E)>(bytes + tag_byte<E>::offset, count, extent);
+}
+
+// First element of a contiguous range (vectors, arrays, spans), or NULL
+// when the range is not known to be contiguous
+template <typename Range>
+inline auto contiguous_data(Range& range, int) -> decltype(&*range.data()) {
+  return range.data();
+}
+
+template <typename T, std::size_t N>
+inline T* contiguous_data(T (&array)[N], int) noexcept {
+  return array;
+}
+
+template <typename Range>
+inline std::nullptr_t contiguous_data(Range&, long) noexcept {
+  return nullptr;
+}
+
+template <typename Range>
+struct scannable
+    : std::integral_constant<
+          bool,
+          std::is_pointer<decltype(contiguous_data(std::declval<Range&>(),
+                                                   0))>::value &&
+              tag_byte<typename range_element<Range>::type>::available> {};
+
+template <typename Range>
+inline std::size_t range_size(Range& range) {
+  return static_cast<std::size_t>(
+      std::distance(std::begin(range), std::end(range)));
+}
+
+template <typename Range>
+inline std::size_t count_index(Range& range, std::size_t index,
+                               std::true_type) {
+  return make_tag_scan(contiguous_data(range, 0), range_size(range))
+      .count(static_cast<unsigned char>(index));
+}
+
+template <typename Range>
+inline std::size_t count_index(Range& range, std::size_t index,
+                               std::false_type) {
+  std::size_t total = 0;
+  for (auto it = std::begin(range); it != std::end(range); ++it) {
+    total += it->index() == index;
+  }
+  return total;
+}
+
+template <typename Range>
+inline auto find_err(Range& range, std::true_type)
+    -> decltype(std::begin(range)) {
+  const std::size_t position =
+      make_tag_scan(contiguous_data(range, 0), range_size(range)).find(1);
+  return std::next(std::begin(range),
+                   static_cast<std::ptrdiff_t>(position));
+}
+
+template <typename Range>
+inline auto find_err(Range& range, std::false_type)
+    -> decltype(std::begin(range)) {
+  auto it = std::begin(range);
+  for (; it != std::end(range); ++it) {
+    if (it->is_err()) {
+      break;
+    }
+  }
+  return it;
+}
+
+template <typename Range, typename T>
+inline void compress_into(Range&& range, std::vector<T>& values,
+                          std::true_type) {
+  typedef typename range_element<Range>::type element;
+  auto* first = contiguous_data(range, 0);
+  const std::size_t size = range_size(range);
+  const auto scan = make_tag_scan(first, size);
+  values.reserve(size - scan.count(tag_byte<element>::none));
+  scan.for_each_other(tag_byte<element>::none, [&](std::size_t i) {
+    values.push_back(forward_element<Range>(first[i]).unwrap_unchecked());
+  });
+}
+
+template <typename Range, typename T>
+inline void compress_into(Range&& range, std::vector<T>& values,
+                          std::false_type) {
+  for (auto it = std::begin(range); it != std::end(range); ++it) {
+    if (it->is_some()) {
+      values.push_back(forward_element<Range>(*it).unwrap_unchecked());
+    }
+  }
+}
+
+}  // namespace detail
+
+// Number of elements of a range of Enums that hold T. Contiguous ranges
+// of Enums with fewer than 255 alternatives compare their discriminant
+// bytes in place, 16 or 32 at a time (SSE2, AVX2 or NEON) when the
+// element size divides the vector width; other ranges call index().
+//
+//   std::size_t stops = rust::count_of<Stop>(events);
+template <typename T, typename Range>
+inline std::size_t count_of(const Range& range) {
+  typedef typename std::remove_const<
+      typename detail::range_element<const Range>::type>::type element;
+  return detail::count_index(range, index_of<T, element>::value,
+                             detail::scannable<const Range>());
+}
+
+// An EnumVec keeps a column per alternative, so this is its size
+template <typename T, typename... Types>
+inline std::size_t count_of(const EnumVec<Types...>& vec) noexcept {
+  return vec.template count_of<T>();
+}
+
+// First Err of a range of Results, or its end; contiguous ranges scan
+// their discriminant bytes like count_of
+//
+//   auto failed = rust::find_first_err(results);
+//   if (failed != results.end()) { ... }
+template <typename Range>
+inline auto find_first_err(Range&& range) -> decltype(std::begin(range)) {
+  return detail::find_err(range, detail::scannable<Range>());
+}
+
+// The Some values of a range of Options, in range order. Options of Enums
+// are scanned for their niche discriminant like count_of. Payloads are
+// moved out when the range is an rvalue.
+//
+//   std::vector<Token> tokens = rust::compress_some(maybe_tokens);
+template <typename Range,
+          typename Element = typename detail::collect_element<Range>::type,
+          typename T = typename Element::value_type>
+inline std::vector<T> compress_some(Range&& range) {
+  std::vector<T> values;
+  detail::compress_into(std::forward<Range>(range), values,
+                        detail::scannable<Range>());
+  return values;
+}
+
+}  // namespace rust
@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2025 Dapeng Feng
+ * All rights reserved.
+ */
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+#include "rustcxx.hpp"
+
+namespace rust {
+
+namespace detail {
+
+// Values that fit beside a presence byte in one 64-bit atomic word
+template <typename T>
+struct fits_atomic_word
+    : std::integral_constant<bool, std::is_trivially_copyable<T>::value &&
+                                       sizeof(T) < sizeof(std::uint64_t)> {};
+
+// Payload in the low bytes, presence in the top byte; 0 is None
+template <typename T>
+class atomic_option_word {
+ public:
+  static constexpr bool is_always_inline = true;
+
+  atomic_option_word() noexcept : word_(0) {}
+
+  Option<T> take() noexcept {
+    return decode(word_.exchange(0, std::memory_order_acq_rel));
+  }
+
+  Option<T> replace(T&& value) noexcept {
+    return decode(word_.exchange(encode(value), std::memory_order_acq_rel));
+  }
+
+  bool is_some() const noexcept {
+    return word_.load(std::memory_order_acquire) != 0;
+  }
+
+  // Takes the value only if its bytes equal those of expected
+  bool compare_and_take(const T& expected) noexcept {
+    std::uint64_t word = encode(expected);
+    return word_.compare_exchange_strong(word, 0, std::memory_order_acq_rel,
+                                         std::memory_order_acquire);
+  }
+
+ private:
+  static const std::uint64_t present = std::uint64_t(1) << 56;
+
+  static std::uint64_t encode(const T& value) noexcept {
+    std::uint64_t word = 0;
+    std::memcpy(&word, &value, sizeof(T));
+    if (!host_little_endian()) {
+      word >>= 8 * (sizeof(std::uint64_t) - sizeof(T));
+    }
+    return word | present;
+  }
+
+  static Option<T> decode(std::uint64_t word) noexcept {
+    if (word == 0) {
+      return Option<T>::None();
+    }
+    word &= present - 1;
+    if (!host_little_endian()) {
+      word <<= 8 * (sizeof(std::uint64_t) - sizeof(T));
+    }
+    // Raw storage rather than a T, which need not be default constructible
+    alignas(T) unsigned char bytes[sizeof(T)];
+    std::memcpy(bytes, &word, sizeof(T));
+    return Option<T>::Some(*reinterpret_cast<const T*>(bytes));
+  }
+
+  static bool host_little_endian() noexcept {
+    const std::uint16_t probe = 1;
+    unsigned char first;
+    std::memcpy(&first, &probe, 1);
+    return first == 1;
+  }
+
+  std::atomic<std::uint64_t> word_;
+};
+
+template <typename T>
+const std::uint64_t atomic_option_word<T>::present;
+
+template <typename T>
+constexpr bool atomic_option_word<T>::is_always_inline;
+
+// Larger values live in a heap box whose pointer is exchanged: whoever
+// exchanges a box out owns it outright, so no reader ever dereferences a
+// box another thread may free, and no epochs or hazard pointers are needed
+template <typename T>
+class atomic_option_box {
+ public:
+  static constexpr bool is_always_inline = false;
+
+  atomic_option_box() noexcept : box_(NULL) {}
+
+  ~atomic_option_box() { delete box_.load(std::memory_order_acquire); }
+
+  Option<T> take() {
+    return unbox(box_.exchange(NULL, std::memory_order_acq_rel));
+  }
+
+  Option<T> replace(T&& value) {
+    T* fresh = new T(std::move(value));
+    return unbox(box_.exchange(fresh, std::memory_order_acq_rel));
+  }
+
+  bool is_some() const noexcept {
+    return box_.load(std::memory_order_acquire) != NULL;
+  }
+
+ private:
+  static Option<T> unbox(T* box) {
+    if (box == NULL) {
+      return Option<T>::None();
+    }
+    Option<T> value = Option<T>::Some(std::move(*box));
+    delete box;
+    return value;
+  }
+
+  std::atomic<T*> box_;
+};
+
+template <typename T>
+constexpr bool atomic_option_box<T>::is_always_inline;
+
+template <typename T>
+struct atomic_option_storage {
+  typedef typename std::conditional<fits_atomic_word<T>::value,
+                                    atomic_option_word<T>,
+                                    atomic_option_box<T> >::type type;
+};
+
+}  // namespace detail
+
+// Option<T> slot shared between threads without a mutex: one thread
+// replaces the value, another takes it (last value wins). Trivially
+// copyable T of up to 7 bytes is packed with its presence flag into one
+// lock-free 64-bit word; larger T is boxed and the box pointer exchanged.
+//
+//   rust::AtomicOption<Config> latest;
+//   latest.replace(load_config());         // writer
+//   rust::Option<Config> c = latest.take();  // reader
+template <typename T>
+class AtomicOption : private detail::atomic_option_storage<T>::type {
+  typedef typename detail::atomic_option_storage<T>::type base;
+
+ public:
+  // True when the value lives in the atomic word itself, without a box
+  using base::is_always_inline;
+
+  AtomicOption() noexcept {}
+
+  explicit AtomicOption(T value) { base::replace(std::move(value)); }
+
+  AtomicOption(const AtomicOption&) = delete;
+  AtomicOption& operator=(const AtomicOption&) = delete;
+
+  // Removes and returns the value, leaving None
+  Option<T> take() { return base::take(); }
+
+  // Stores value and returns the one it displaced
+  Option<T> replace(T value) { return base::replace(std::move(value)); }
+
+  bool is_some() const noexcept { return base::is_some(); }
+
+  bool is_none() const noexcept { return !base::is_some(); }
+
+  // Takes the value only if it equals expected, bytewise; needs the
+  // inline representation, as a box would have to be read before it is
+  // owned
+  template <typename U = T>
+  bool compare_and_take(const T& expected) noexcept {
+    static_assert(detail::fits_atomic_word<U>::value &&
+                      detail::has_unique_bytes<U>::value,
+                  "compare_and_take needs a trivially copyable T of at most "
+                  "7 bytes without padding");
+    return base::compare_and_take(expected);
+  }
+};
+
+}  // namespace rust
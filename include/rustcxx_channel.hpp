@@ -0,0 +1,401 @@
+/*
+ * Copyright (c) 2025 Dapeng Feng
+ * All rights reserved.
+ */
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include "rustcxx.hpp"
+
+namespace rust {
+namespace mpsc {
+
+enum class RecvError : unsigned char {
+  disconnected,  // every Sender is gone and the channel is drained
+};
+
+enum class TryRecvError : unsigned char {
+  empty,         // no message right now
+  disconnected,  // every Sender is gone and the channel is drained
+};
+
+enum class TrySend : unsigned char {
+  sent,
+  full,          // the ring has no free slot; the value was not moved
+  disconnected,  // the Receiver is gone; the value was not moved
+};
+
+namespace detail {
+
+const std::size_t cache_line = 64;
+
+// Bounded ring for many producers and one consumer (Vyukov): every slot
+// carries a sequence number telling whose turn it is, so producers claim
+// slots with one CAS on the tail and the consumer needs no atomic RMW.
+// Values are stored inline in the slots.
+template <typename T>
+class mpsc_ring {
+ public:
+  explicit mpsc_ring(std::size_t capacity)
+      : mask_(round_up(capacity) - 1),
+        cells_(new cell[mask_ + 1]),
+        tail_(0),
+        head_(0) {
+    for (std::size_t i = 0; i <= mask_; ++i) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  mpsc_ring(const mpsc_ring&) = delete;
+  mpsc_ring& operator=(const mpsc_ring&) = delete;
+
+  ~mpsc_ring() {
+    while (T* value = front()) {
+      value->~T();
+      pop_front();
+    }
+  }
+
+  std::size_t capacity() const noexcept { return mask_ + 1; }
+
+  // Moves value into a free slot; false when the ring is full
+  bool try_push(T& value) noexcept {
+    std::size_t pos = tail_.load(std::memory_order_relaxed);
+    cell* c;
+    for (;;) {
+      c = &cells_[pos & mask_];
+      const std::size_t seq = c->sequence.load(std::memory_order_acquire);
+      const std::intptr_t diff =
+          static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+      if (diff == 0) {
+        if (tail_.compare_exchange_weak(pos, pos + 1,
+                                        std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = tail_.load(std::memory_order_relaxed);
+      }
+    }
+    ::new (static_cast<void*>(&c->storage)) T(std::move(value));
+    c->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Oldest value, or NULL when empty; consumer only
+  T* front() noexcept {
+    cell& c = cells_[head_ & mask_];
+    if (c.sequence.load(std::memory_order_acquire) != head_ + 1) {
+      return NULL;
+    }
+    return reinterpret_cast<T*>(&c.storage);
+  }
+
+  // Releases the slot of front() to the producers; consumer only
+  void pop_front() noexcept {
+    cells_[head_ & mask_].sequence.store(head_ + mask_ + 1,
+                                         std::memory_order_release);
+    ++head_;
+  }
+
+ private:
+  struct cell {
+    std::atomic<std::size_t> sequence;
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+  };
+
+  static std::size_t round_up(std::size_t n) noexcept {
+    std::size_t capacity = 2;
+    while (capacity < n) {
+      capacity *= 2;
+    }
+    return capacity;
+  }
+
+  const std::size_t mask_;
+  const std::unique_ptr<cell[]> cells_;
+  // Producers and the consumer write on separate cache lines
+  char pad0_[cache_line];
+  std::atomic<std::size_t> tail_;
+  char pad1_[cache_line];
+  std::size_t head_;
+};
+
+// State shared by the Senders and the Receiver. Sleeping goes through
+// the mutex; the fast paths only touch the ring and read the waiting
+// flags, which a seq_cst fence on each side orders against the ring so
+// that no wakeup is lost.
+template <typename T>
+struct channel_state {
+  explicit channel_state(std::size_t capacity)
+      : ring(capacity),
+        senders(1),
+        receiver_alive(true),
+        receiver_waiting(false),
+        senders_waiting(0) {}
+
+  mpsc_ring<T> ring;
+  std::atomic<std::size_t> senders;
+  std::atomic<bool> receiver_alive;
+  std::atomic<bool> receiver_waiting;
+  std::atomic<std::size_t> senders_waiting;
+  std::mutex mutex;
+  std::condition_variable not_empty;
+  std::condition_variable not_full;
+
+  void wake_receiver() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (receiver_waiting.load(std::memory_order_relaxed)) {
+      std::lock_guard<std::mutex> lock(mutex);
+      not_empty.notify_one();
+    }
+  }
+
+  void wake_senders() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (senders_waiting.load(std::memory_order_relaxed) != 0) {
+      std::lock_guard<std::mutex> lock(mutex);
+      not_full.notify_all();
+    }
+  }
+};
+
+// Rounds of polling before a blocked side goes to sleep
+const int spin_rounds = 64;
+
+}  // namespace detail
+
+template <typename T>
+class Sender;
+
+template <typename T>
+class Receiver;
+
+template <typename T>
+std::pair<Sender<T>, Receiver<T> > channel(std::size_t capacity = 1024);
+
+// Sending half; copy it to add producers. The channel disconnects for the
+// Receiver when the last Sender is destroyed.
+template <typename T>
+class Sender {
+ public:
+  Sender(const Sender& other) noexcept : state_(other.state_) {
+    if (state_) {
+      state_->senders.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  Sender(Sender&& other) noexcept : state_(std::move(other.state_)) {}
+
+  Sender& operator=(Sender other) noexcept {
+    std::swap(state_, other.state_);
+    return *this;
+  }
+
+  ~Sender() {
+    if (state_ &&
+        state_->senders.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      std::lock_guard<std::mutex> lock(state_->mutex);
+      state_->not_empty.notify_one();
+    }
+  }
+
+  // Sends without blocking; value is moved only when sent
+  TrySend try_send(T&& value) {
+    if (RUSTCXX_UNLIKELY(
+            !state_->receiver_alive.load(std::memory_order_acquire))) {
+      return TrySend::disconnected;
+    }
+    if (!state_->ring.try_push(value)) {
+      return TrySend::full;
+    }
+    state_->wake_receiver();
+    return TrySend::sent;
+  }
+
+  TrySend try_send(const T& value) {
+    T copy(value);
+    return try_send(std::move(copy));
+  }
+
+  // Sends, waiting for a free slot while the ring is full. Returns false,
+  // without moving value, when the Receiver is gone.
+  bool send(T&& value) {
+    for (int round = 0;; ++round) {
+      const TrySend sent = try_send(std::move(value));
+      if (RUSTCXX_LIKELY(sent == TrySend::sent)) {
+        return true;
+      }
+      if (sent == TrySend::disconnected) {
+        return false;
+      }
+      if (round < detail::spin_rounds) {
+        std::this_thread::yield();
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(state_->mutex);
+      state_->senders_waiting.fetch_add(1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (state_->ring.try_push(value)) {
+        state_->senders_waiting.fetch_sub(1, std::memory_order_relaxed);
+        lock.unlock();
+        state_->wake_receiver();
+        return true;
+      }
+      if (state_->receiver_alive.load(std::memory_order_acquire)) {
+        state_->not_full.wait(lock);
+      }
+      state_->senders_waiting.fetch_sub(1, std::memory_order_relaxed);
+    }
+  }
+
+  bool send(const T& value) {
+    T copy(value);
+    return send(std::move(copy));
+  }
+
+  std::size_t capacity() const noexcept { return state_->ring.capacity(); }
+
+ private:
+  template <typename U>
+  friend std::pair<Sender<U>, Receiver<U> > channel(std::size_t);
+
+  explicit Sender(std::shared_ptr<detail::channel_state<T> > state) noexcept
+      : state_(std::move(state)) {}
+
+  std::shared_ptr<detail::channel_state<T> > state_;
+};
+
+// Receiving half; move-only. Senders fail once it is destroyed, and
+// messages still queued are destroyed with the channel.
+template <typename T>
+class Receiver {
+ public:
+  Receiver(Receiver&& other) noexcept : state_(std::move(other.state_)) {}
+
+  Receiver& operator=(Receiver&& other) noexcept {
+    Receiver(std::move(other)).swap(*this);
+    return *this;
+  }
+
+  Receiver(const Receiver&) = delete;
+  Receiver& operator=(const Receiver&) = delete;
+
+  ~Receiver() {
+    if (state_) {
+      state_->receiver_alive.store(false, std::memory_order_release);
+      std::lock_guard<std::mutex> lock(state_->mutex);
+      state_->not_full.notify_all();
+    }
+  }
+
+  Result<T, TryRecvError> try_recv() {
+    typedef Result<T, TryRecvError> result_type;
+    // Read senders first: a zero count makes every earlier send visible
+    const bool disconnected =
+        state_->senders.load(std::memory_order_acquire) == 0;
+    T* value = state_->ring.front();
+    if (value == NULL) {
+      return result_type::Err(disconnected ? TryRecvError::disconnected
+                                           : TryRecvError::empty);
+    }
+    result_type result = result_type::Ok(std::move(*value));
+    value->~T();
+    state_->ring.pop_front();
+    state_->wake_senders();
+    return result;
+  }
+
+  // Waits for a message; Err once every Sender is gone and the queue is
+  // drained
+  Result<T, RecvError> recv() {
+    typedef Result<T, RecvError> result_type;
+    for (int round = 0;; ++round) {
+      Result<T, TryRecvError> message = try_recv();
+      if (RUSTCXX_LIKELY(message.is_ok())) {
+        return result_type::Ok(std::move(message).unwrap_unchecked());
+      }
+      if (message.unwrap_err_unchecked() == TryRecvError::disconnected) {
+        return result_type::Err(RecvError::disconnected);
+      }
+      if (round < detail::spin_rounds) {
+        std::this_thread::yield();
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(state_->mutex);
+      state_->receiver_waiting.store(true, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (state_->ring.front() == NULL &&
+          state_->senders.load(std::memory_order_acquire) != 0) {
+        state_->not_empty.wait(lock);
+      }
+      state_->receiver_waiting.store(false, std::memory_order_relaxed);
+    }
+  }
+
+  // Passes up to max queued messages to f(T&&) without blocking and
+  // returns how many; frees their slots to the producers in one step
+  template <typename F>
+  std::size_t try_recv_many(F&& f, std::size_t max) {
+    std::size_t received = 0;
+    while (received < max) {
+      T* value = state_->ring.front();
+      if (value == NULL) {
+        break;
+      }
+      f(std::move(*value));
+      value->~T();
+      state_->ring.pop_front();
+      ++received;
+    }
+    if (received != 0) {
+      state_->wake_senders();
+    }
+    return received;
+  }
+
+  std::size_t capacity() const noexcept { return state_->ring.capacity(); }
+
+  void swap(Receiver& other) noexcept { state_.swap(other.state_); }
+
+ private:
+  template <typename U>
+  friend std::pair<Sender<U>, Receiver<U> > channel(std::size_t);
+
+  explicit Receiver(std::shared_ptr<detail::channel_state<T> > state) noexcept
+      : state_(std::move(state)) {}
+
+  std::shared_ptr<detail::channel_state<T> > state_;
+};
+
+// Bounded channel holding up to capacity messages (rounded up to a power
+// of two) inline in a ring allocated once; sending and receiving do not
+// allocate
+//
+//   auto ch = rust::mpsc::channel<NetworkMessage>(1024);
+//   rust::mpsc::Sender<NetworkMessage> tx = ch.first;  // one per producer
+//   for (auto m = ch.second.recv(); m.is_ok(); m = ch.second.recv()) { ... }
+template <typename T>
+std::pair<Sender<T>, Receiver<T> > channel(std::size_t capacity) {
+  static_assert(std::is_nothrow_move_constructible<T>::value,
+                "channel messages are moved into the ring after a slot is "
+                "claimed, which must not throw");
+  std::shared_ptr<detail::channel_state<T> > state =
+      std::make_shared<detail::channel_state<T> >(capacity);
+  return std::pair<Sender<T>, Receiver<T> >(Sender<T>(state),
+                                            Receiver<T>(state));
+}
+
+}  // namespace mpsc
+}  // namespace rust
@@ -0,0 +1,275 @@
+/*
+ * Copyright (c) 2025 Dapeng Feng
+ * All rights reserved.
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "rustcxx.hpp"
+
+namespace rust {
+
+template <typename... Types>
+class EnumVec;
+
+namespace detail {
+
+// Element of an EnumVec: behaves like the Enum stored at that position
+// and can be passed to rust::match. Vec is EnumVec<...> or a const one.
+template <typename Vec>
+class enum_vec_ref {
+ public:
+  enum_vec_ref(Vec& vec, std::size_t position) noexcept
+      : vec_(&vec), position_(position) {}
+
+  std::size_t index() const noexcept { return vec_->index_at(position_); }
+
+  bool valueless_by_exception() const noexcept { return false; }
+
+  template <typename T>
+  bool is() const noexcept {
+    return index() == Vec::template index_of<T>();
+  }
+
+  // Alternative I; the caller guarantees index() == I
+  template <std::size_t I>
+  auto alternative() const noexcept
+      -> decltype(std::declval<Vec&>().template column<I>()[0]) {
+    return vec_->template column<I>()[vec_->slots_[position_]];
+  }
+
+  // Get the value if it's of type T, panics if not
+  template <typename T>
+  auto get() const -> decltype(std::declval<Vec&>().template column<T>()[0]) {
+    if (RUSTCXX_UNLIKELY(!is<T>())) {
+      panic("bad variant access");
+    }
+    return alternative<Vec::template index_of<T>()>();
+  }
+
+  // Get the value if it's of type T, returns nullptr if not
+  template <typename T>
+  auto get_if() const noexcept
+      -> decltype(&std::declval<Vec&>().template column<T>()[0]) {
+    if (!is<T>()) {
+      return NULL;
+    }
+    return &alternative<Vec::template index_of<T>()>();
+  }
+
+  template <typename... Ts>
+  RUSTCXX_RETURN_TYPE(
+      typename detail::match_result<const enum_vec_ref&, Ts...>::type)
+  match(Ts&&... ts) const {
+    return rust::match(*this, std::forward<Ts>(ts)...);
+  }
+
+ private:
+  Vec* vec_;
+  std::size_t position_;
+};
+
+template <typename Vec>
+struct is_indexed_variant<enum_vec_ref<Vec> > : std::true_type {};
+
+template <typename Vec>
+struct variant_size_impl<enum_vec_ref<Vec> >
+    : std::integral_constant<std::size_t, Vec::alternatives> {};
+
+template <std::size_t I, typename Vec>
+inline auto get_alternative(const enum_vec_ref<Vec>& ref) noexcept
+    -> decltype(ref.template alternative<I>()) {
+  return ref.template alternative<I>();
+}
+
+// Appends an Enum's active alternative to its column
+template <typename Vec>
+struct enum_vec_pusher {
+  Vec& vec;
+
+  template <typename T>
+  void operator()(T&& value) {
+    vec.push_back(std::forward<T>(value));
+  }
+};
+
+}  // namespace detail
+
+// Structure-of-arrays container for Enum<Types...>: a dense array of
+// discriminants plus one packed std::vector per alternative, so elements
+// are not padded to the largest alternative and for_each_of<T>() scans
+// one alternative without branching on the discriminant.
+template <typename... Types>
+class EnumVec {
+ public:
+  typedef typename detail::index_type<sizeof...(Types)>::type index_t;
+  typedef detail::enum_vec_ref<EnumVec> reference;
+  typedef detail::enum_vec_ref<const EnumVec> const_reference;
+
+  static constexpr std::size_t alternatives = sizeof...(Types);
+
+  EnumVec() {}
+
+  std::size_t size() const noexcept { return tags_.size(); }
+
+  bool empty() const noexcept { return tags_.empty(); }
+
+  // Reserve room for n elements in the discriminant and position arrays
+  void reserve(std::size_t n) {
+    tags_.reserve(n);
+    slots_.reserve(n);
+  }
+
+  void clear() noexcept {
+    tags_.clear();
+    slots_.clear();
+    clear_columns(typename detail::make_index_sequence<alternatives>::type());
+  }
+
+  // Append an alternative
+  template <typename T,
+            typename D = typename std::decay<T>::type,
+            typename = typename std::enable_if<
+                detail::index_of<D, Types...>::value < alternatives>::type>
+  void push_back(T&& value) {
+    emplace_back<D>(std::forward<T>(value));
+  }
+
+  // Append the active alternative of an Enum
+  void push_back(const Enum<Types...>& value) {
+    detail::enum_vec_pusher<EnumVec> pusher = {*this};
+    rust::match(detail::enum_access::storage(value), pusher);
+  }
+
+  void push_back(Enum<Types...>&& value) {
+    detail::enum_vec_pusher<EnumVec> pusher = {*this};
+    rust::match(std::move(detail::enum_access::storage(value)), pusher);
+  }
+
+  // Construct an alternative in place at the end. If construction throws
+  // the EnumVec is left unchanged. Panics once a column would hold more
+  // than 2^32 elements, the limit of positions().
+  template <typename T, typename... Args>
+  T& emplace_back(Args&&... args) {
+    std::vector<T>& values = column<T>();
+    if (RUSTCXX_UNLIKELY(static_cast<std::uint64_t>(values.size()) >
+                         UINT32_MAX)) {
+      panic("EnumVec column is full");
+    }
+    // Grow the index arrays first, so that nothing can throw once the
+    // value is in its column
+    reserve_one(tags_);
+    reserve_one(slots_);
+    values.emplace_back(std::forward<Args>(args)...);
+    tags_.push_back(static_cast<index_t>(index_of<T>()));
+    slots_.push_back(static_cast<std::uint32_t>(values.size() - 1));
+    return values.back();
+  }
+
+  reference operator[](std::size_t position) noexcept {
+    return reference(*this, position);
+  }
+
+  const_reference operator[](std::size_t position) const noexcept {
+    return const_reference(*this, position);
+  }
+
+  // Discriminant of the element at position
+  std::size_t index_at(std::size_t position) const noexcept {
+    return tags_[position];
+  }
+
+  // Dense discriminant array, one entry per element
+  const std::vector<index_t>& indices() const noexcept { return tags_; }
+
+  // Position of each element inside its alternative's column
+  const std::vector<std::uint32_t>& positions() const noexcept {
+    return slots_;
+  }
+
+  // Packed values of one alternative, in insertion order
+  template <std::size_t I>
+  std::vector<typename detail::type_at<I, Types...>::type>& column() noexcept {
+    return std::get<I>(columns_);
+  }
+
+  template <std::size_t I>
+  const std::vector<typename detail::type_at<I, Types...>::type>& column()
+      const noexcept {
+    return std::get<I>(columns_);
+  }
+
+  template <typename T>
+  std::vector<T>& column() noexcept {
+    return std::get<index_of<T>()>(columns_);
+  }
+
+  template <typename T>
+  const std::vector<T>& column() const noexcept {
+    return std::get<index_of<T>()>(columns_);
+  }
+
+  // Number of elements holding T
+  template <typename T>
+  std::size_t count_of() const noexcept {
+    return column<T>().size();
+  }
+
+  // Call f on every T, in insertion order, without touching the others
+  template <typename T, typename F>
+  void for_each_of(F&& f) {
+    std::vector<T>& values = column<T>();
+    for (std::size_t i = 0; i < values.size(); ++i) {
+      f(values[i]);
+    }
+  }
+
+  template <typename T, typename F>
+  void for_each_of(F&& f) const {
+    const std::vector<T>& values = column<T>();
+    for (std::size_t i = 0; i < values.size(); ++i) {
+      f(values[i]);
+    }
+  }
+
+  template <typename T>
+  static constexpr std::size_t index_of() {
+    static_assert(detail::index_of<T, Types...>::value < sizeof...(Types),
+                  "T is not an alternative of this EnumVec");
+    return detail::index_of<T, Types...>::value;
+  }
+
+ private:
+  template <typename Vec>
+  friend class detail::enum_vec_ref;
+
+  // Room for one more element, growing geometrically like push_back
+  template <typename V>
+  static void reserve_one(V& v) {
+    if (v.size() == v.capacity()) {
+      v.reserve(v.empty() ? 8 : 2 * v.size());
+    }
+  }
+
+  template <std::size_t... Is>
+  void clear_columns(detail::index_sequence<Is...>) noexcept {
+    int expand[] = {(std::get<Is>(columns_).clear(), 0)...};
+    static_cast<void>(expand);
+  }
+
+  std::vector<index_t> tags_;
+  // Position of each element inside its alternative's column
+  std::vector<std::uint32_t> slots_;
+  std::tuple<std::vector<Types>...> columns_;
+};
+
+template <typename... Types>
+constexpr std::size_t EnumVec<Types...>::alternatives;
+
+}  // namespace rust
@@ -0,0 +1,626 @@
+/*
+ * Copyright (c) 2025 Dapeng Feng
+ * All rights reserved.
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <string>
+#include <type_traits>
+
+#include "rustcxx.hpp"
+
+#if RUSTCXX_CPP17_OR_GREATER
+#include <string_view>
+#endif
+
+namespace rust {
+
+// Error code plus a message with static storage duration (usually a string
+// literal). Trivially copyable and two words wide, so Result<T, StaticError>
+// never allocates on the failure path.
+//
+//   rust::Result<int, rust::StaticError> parse_port(const char* s) {
+//     if (!*s) return rust::Result<int, rust::StaticError>::Err(
+//                  rust::StaticError("empty port", EINVAL));
+//     ...
+//   }
+class StaticError {
+ public:
+  constexpr StaticError() noexcept : code_(0), message_("") {}
+
+  constexpr explicit StaticError(const char* message, int code = 0) noexcept
+      : code_(code), message_(message) {}
+
+  constexpr int code() const noexcept { return code_; }
+
+  constexpr const char* message() const noexcept { return message_; }
+
+  // Copy of the message, for interop with std::string errors
+  std::string to_string() const { return message_; }
+
+  friend bool operator==(const StaticError& a, const StaticError& b) noexcept {
+    return a.code_ == b.code_ &&
+           (a.message_ == b.message_ || std::strcmp(a.message_, b.message_) == 0);
+  }
+
+  friend bool operator!=(const StaticError& a, const StaticError& b) noexcept {
+    return !(a == b);
+  }
+
+ private:
+  int code_;
+  const char* message_;
+};
+
+// Where an error was raised; see RUSTCXX_ERROR_LOCATION
+struct ErrorLocation {
+  const char* file;
+  int line;
+};
+
+// Pointer to a static ErrorLocation for the current line
+#define RUSTCXX_ERROR_LOCATION()                                        \
+  ([]() -> const ::rust::ErrorLocation* {                               \
+    static const ::rust::ErrorLocation location = {__FILE__, __LINE__}; \
+    return &location;                                                   \
+  }())
+
+namespace detail {
+
+typedef int (*error_renderer)(const char* format, const unsigned char* args,
+                              char* out, std::size_t size);
+
+template <typename... Ts>
+struct packed_size : std::integral_constant<std::size_t, 0> {};
+
+template <typename T, typename... Ts>
+struct packed_size<T, Ts...>
+    : std::integral_constant<std::size_t,
+                             sizeof(T) + packed_size<Ts...>::value> {};
+
+inline void pack_args(unsigned char*) noexcept {}
+
+template <typename T, typename... Ts>
+inline void pack_args(unsigned char* out, const T& value,
+                      const Ts&... rest) noexcept {
+  std::memcpy(out, &value, sizeof(T));
+  pack_args(out + sizeof(T), rest...);
+}
+
+template <typename... Done>
+inline int render_args(const char* format, const unsigned char*, char* out,
+                       std::size_t size, type_list<>, Done... done) {
+  return std::snprintf(out, size, format, done...);
+}
+
+template <typename T, typename... Ts, typename... Done>
+inline int render_args(const char* format, const unsigned char* args,
+                       char* out, std::size_t size, type_list<T, Ts...>,
+                       Done... done) {
+  T value;
+  std::memcpy(&value, args, sizeof(T));
+  return render_args(format, args + sizeof(T), out, size, type_list<Ts...>(),
+                     done..., value);
+}
+
+template <typename... Args>
+struct error_format {
+  static int render(const char* format, const unsigned char* args, char* out,
+                    std::size_t size) {
+    return render_args(format, args, out, size, type_list<Args...>());
+  }
+};
+
+}  // namespace detail
+
+// Error code, optional source location and up to N bytes of message, all
+// stored inline: Result<T, InlineError<N>> has a fixed size, is trivially
+// copyable and never allocates on the failure path. The message is either
+// copied in (and truncated to N - 1 bytes) or kept as a printf format plus
+// its packed arguments and only formatted when it is read.
+//
+//   typedef rust::InlineError<48> RpcError;
+//   return Result<Reply, RpcError>::Err(RpcError::with_location(
+//       404, RUSTCXX_ERROR_LOCATION(), "no method %d", id));
+template <std::size_t N>
+class InlineError {
+  static_assert(N > 0, "InlineError needs room for the terminator");
+
+ public:
+  InlineError() noexcept
+      : code_(0), location_(NULL), format_(NULL), render_(NULL) {
+    data_[0] = '\0';
+  }
+
+  explicit InlineError(const char* message, int code = 0,
+                       const ErrorLocation* location = NULL) noexcept
+      : code_(code), location_(location), format_(NULL), render_(NULL) {
+    std::size_t length = std::strlen(message);
+    if (length > N - 1) {
+      length = N - 1;
+    }
+    std::memcpy(data_, message, length);
+    data_[length] = '\0';
+  }
+
+  // Deferred printf-style message. format must have static storage
+  // duration and args must be scalars (pointed-to strings must outlive the
+  // error); they are copied into the inline buffer and formatted on read.
+  template <typename... Args>
+  static InlineError format(int code, const char* fmt, Args... args) {
+    return with_location(code, NULL, fmt, args...);
+  }
+
+  template <typename... Args>
+  static InlineError with_location(int code, const ErrorLocation* location,
+                                   const char* fmt, Args... args) {
+    static_assert(detail::all_of<std::is_scalar<Args>::value...>::value,
+                  "InlineError::format takes scalar arguments");
+    static_assert(detail::packed_size<Args...>::value <= N,
+                  "InlineError arguments do not fit inline");
+    InlineError error;
+    error.code_ = code;
+    error.location_ = location;
+    error.format_ = fmt;
+    error.render_ = &detail::error_format<Args...>::render;
+    detail::pack_args(reinterpret_cast<unsigned char*>(error.data_), args...);
+    return error;
+  }
+
+  int code() const noexcept { return code_; }
+
+  // NULL unless the error was given a location
+  const ErrorLocation* location() const noexcept { return location_; }
+
+  // Writes the message into out like snprintf: at most size bytes including
+  // the terminator. Returns the length of the whole message.
+  std::size_t format_to(char* out, std::size_t size) const {
+    if (render_ != NULL) {
+      const int length = render_(
+          format_, reinterpret_cast<const unsigned char*>(data_), out, size);
+      return length < 0 ? 0 : static_cast<std::size_t>(length);
+    }
+    const std::size_t length = std::strlen(data_);
+    if (size > 0) {
+      const std::size_t n = length < size - 1 ? length : size - 1;
+      std::memcpy(out, data_, n);
+      out[n] = '\0';
+    }
+    return length;
+  }
+
+  // The formatted message; the only operation that may allocate
+  std::string to_string() const {
+    if (render_ == NULL) {
+      return std::string(data_);
+    }
+    std::string text(format_to(NULL, 0), '\0');
+    if (!text.empty()) {
+      format_to(&text[0], text.size() + 1);
+    }
+    return text;
+  }
+
+  // Compares the messages without allocating. Deferred messages are
+  // rendered into N-byte buffers, so they compare on their lengths and
+  // first N - 1 characters.
+  friend bool operator==(const InlineError& a, const InlineError& b) {
+    if (a.code_ != b.code_) {
+      return false;
+    }
+    if (a.render_ == NULL && b.render_ == NULL) {
+      const std::size_t length = std::strlen(a.data_);
+      return length == std::strlen(b.data_) &&
+             std::memcmp(a.data_, b.data_, length) == 0;
+    }
+    char lhs[N];
+    char rhs[N];
+    return a.format_to(lhs, N) == b.format_to(rhs, N) &&
+           std::strcmp(lhs, rhs) == 0;
+  }
+
+  friend bool operator!=(const InlineError& a, const InlineError& b) {
+    return !(a == b);
+  }
+
+ private:
+  int code_;
+  const ErrorLocation* location_;
+  const char* format_;
+  detail::error_renderer render_;
+  char data_[N];
+};
+
+namespace detail {
+
+// Message text of an error payload, for ContextError::to_string()
+inline std::string error_text(const std::string& error) { return error; }
+
+inline std::string error_text(const char* error) { return error; }
+
+template <typename E>
+inline auto error_text(const E& error) -> decltype(error.to_string()) {
+  return error.to_string();
+}
+
+template <typename E>
+inline auto error_text(const E& error) ->
+    typename std::enable_if<std::is_arithmetic<E>::value, std::string>::type {
+  return std::to_string(error);
+}
+
+// Room for the packed arguments, copied strings or callable of one frame
+static const std::size_t context_frame_bytes = 64;
+
+// context() arguments kept as text: copied into the frame when the
+// context is added, so the caller's string may go away before rendering
+template <typename T>
+struct context_text : std::false_type {};
+
+template <>
+struct context_text<const char*> : std::true_type {};
+
+template <>
+struct context_text<char*> : std::true_type {};
+
+template <>
+struct context_text<std::string> : std::true_type {};
+
+#if RUSTCXX_CPP17_OR_GREATER
+template <>
+struct context_text<std::string_view> : std::true_type {};
+#endif
+
+template <typename T>
+struct context_arg
+    : std::integral_constant<bool, context_text<T>::value ||
+                                       std::is_scalar<T>::value> {};
+
+// Bytes of the packed scalars; strings follow them in the frame
+template <typename... Args>
+struct context_scalar_size
+    : std::integral_constant<std::size_t,
+                             size_sum((context_text<Args>::value
+                                           ? 0
+                                           : sizeof(Args))...)> {};
+
+template <typename... Args>
+struct context_text_count
+    : std::integral_constant<std::size_t,
+                             size_sum((context_text<Args>::value ? 1
+                                                                 : 0)...)> {};
+
+inline void copy_context_text(char*& text, char* text_end,
+                              std::size_t later, const char* data,
+                              std::size_t size) noexcept {
+  // Leave a terminator for every later string
+  const std::size_t room =
+      static_cast<std::size_t>(text_end - text) - 1 - later;
+  const std::size_t n = size < room ? size : room;
+  std::memcpy(text, data, n);
+  text[n] = '\0';
+  text += n + 1;
+}
+
+inline void pack_context_arg(unsigned char*&, char*& text, char* text_end,
+                             std::size_t later, const char* value) noexcept {
+  if (value == NULL) {
+    value = "(null)";
+  }
+  copy_context_text(text, text_end, later, value, std::strlen(value));
+}
+
+inline void pack_context_arg(unsigned char*&, char*& text, char* text_end,
+                             std::size_t later,
+                             const std::string& value) noexcept {
+  copy_context_text(text, text_end, later, value.data(), value.size());
+}
+
+#if RUSTCXX_CPP17_OR_GREATER
+inline void pack_context_arg(unsigned char*&, char*& text, char* text_end,
+                             std::size_t later,
+                             std::string_view value) noexcept {
+  copy_context_text(text, text_end, later, value.data(), value.size());
+}
+#endif
+
+template <typename T>
+inline typename std::enable_if<!context_text<T>::value>::type
+pack_context_arg(unsigned char*& scalars, char*&, char*, std::size_t,
+                 const T& value) noexcept {
+  std::memcpy(scalars, &value, sizeof(T));
+  scalars += sizeof(T);
+}
+
+inline void pack_context(unsigned char*, char*, char*) noexcept {}
+
+template <typename T, typename... Ts>
+inline void pack_context(unsigned char* scalars, char* text, char* text_end,
+                         const T& value, const Ts&... rest) noexcept {
+  pack_context_arg(scalars, text, text_end, context_text_count<Ts...>::value,
+                   value);
+  pack_context(scalars, text, text_end, rest...);
+}
+
+template <typename... Done>
+inline int render_context(const char* format, const unsigned char*,
+                          const char*, char* out, std::size_t size,
+                          type_list<>, Done... done) {
+  return std::snprintf(out, size, format, done...);
+}
+
+template <typename T, typename... Ts, typename... Done>
+inline typename std::enable_if<context_text<T>::value, int>::type
+render_context(const char* format, const unsigned char* scalars,
+               const char* text, char* out, std::size_t size,
+               type_list<T, Ts...>, Done... done) {
+  return render_context(format, scalars, text + std::strlen(text) + 1, out,
+                        size, type_list<Ts...>(), done..., text);
+}
+
+template <typename T, typename... Ts, typename... Done>
+inline typename std::enable_if<!context_text<T>::value, int>::type
+render_context(const char* format, const unsigned char* scalars,
+               const char* text, char* out, std::size_t size,
+               type_list<T, Ts...>, Done... done) {
+  T value;
+  std::memcpy(&value, scalars, sizeof(T));
+  return render_context(format, scalars + sizeof(T), text, out, size,
+                        type_list<Ts...>(), done..., value);
+}
+
+typedef void (*context_appender)(const char* format, const unsigned char* data,
+                                 std::string& out);
+
+struct context_frame {
+  const char* format;
+  context_appender append;
+  union {
+    std::max_align_t align;
+    unsigned char bytes[context_frame_bytes];
+  } data;
+};
+
+// The frames of a ContextError, allocated with the first one
+template <std::size_t Frames>
+struct context_chain {
+  std::size_t size;
+  std::size_t dropped;
+  context_frame frames[Frames];
+};
+
+// Appends a context() frame: snprintf into the grown string
+template <typename... Args>
+struct context_format {
+  static int render(const char* format, const unsigned char* data, char* out,
+                    std::size_t size) {
+    return render_context(
+        format, data,
+        reinterpret_cast<const char*>(data) +
+            context_scalar_size<Args...>::value,
+        out, size, type_list<Args...>());
+  }
+
+  static void append(const char* format, const unsigned char* data,
+                     std::string& out) {
+    const int length = render(format, data, NULL, 0);
+    if (length <= 0) {
+      return;
+    }
+    const std::size_t offset = out.size();
+    out.resize(offset + static_cast<std::size_t>(length) + 1);
+    render(format, data, &out[offset], static_cast<std::size_t>(length) + 1);
+    out.resize(offset + static_cast<std::size_t>(length));
+  }
+};
+
+// Appends a with_context() frame by calling the stored callable once
+template <typename F>
+struct context_callable {
+  static void append(const char*, const unsigned char* data,
+                     std::string& out) {
+    out += error_text((*reinterpret_cast<const F*>(data))());
+  }
+};
+
+}  // namespace detail
+
+// Error E plus up to Frames context frames, added by Result::context() and
+// Result::with_context() as the error travels up. Frames hold a format and
+// its packed arguments (or a callable) and live in one block allocated
+// with the first frame, so Result<T, ContextError<E> > is one pointer
+// wider than Result<T, E>. Adding context never formats; to_string()
+// renders "outer: inner: error" only when someone reads it. Context added
+// once all frames are used is counted by dropped() instead of stored.
+//
+//   return load(path).context("loading %s (attempt %d)", name, attempt);
+template <typename E, std::size_t Frames = 4>
+class ContextError {
+  static_assert(Frames > 0, "ContextError needs at least one frame");
+
+ public:
+  typedef E error_type;
+
+  explicit ContextError(const E& error) : error_(error), chain_(NULL) {}
+
+  explicit ContextError(E&& error) : error_(std::move(error)), chain_(NULL) {}
+
+  ContextError(const ContextError& other)
+      : error_(other.error_),
+        chain_(other.chain_ == NULL ? NULL : new chain(*other.chain_)) {}
+
+  ContextError(ContextError&& other) noexcept(
+      std::is_nothrow_move_constructible<E>::value)
+      : error_(std::move(other.error_)), chain_(other.chain_) {
+    other.chain_ = NULL;
+  }
+
+  ContextError& operator=(const ContextError& other) {
+    if (this != &other) {
+      ContextError copy(other);
+      *this = std::move(copy);
+    }
+    return *this;
+  }
+
+  ContextError& operator=(ContextError&& other) noexcept(
+      std::is_nothrow_move_assignable<E>::value) {
+    if (this != &other) {
+      error_ = std::move(other.error_);
+      delete chain_;
+      chain_ = other.chain_;
+      other.chain_ = NULL;
+    }
+    return *this;
+  }
+
+  ~ContextError() { delete chain_; }
+
+  // The original error
+  E& error() & noexcept { return error_; }
+
+  const E& error() const& noexcept { return error_; }
+
+  E error() && { return std::move(error_); }
+
+  // Number of stored frames
+  std::size_t frames() const noexcept {
+    return chain_ == NULL ? 0 : chain_->size;
+  }
+
+  // Number of frames that did not fit
+  std::size_t dropped() const noexcept {
+    return chain_ == NULL ? 0 : chain_->dropped;
+  }
+
+  // fmt must have static storage duration. Scalar arguments are stored by
+  // value and strings (const char*, std::string, std::string_view) are
+  // copied into the frame, truncated to fit. Pointers passed for anything
+  // other than %s are kept as they are.
+  template <typename... Args>
+  void push(const char* fmt, const Args&... args) {
+    push_format<typename std::decay<const Args>::type...>(fmt, args...);
+  }
+
+  // f runs when the message is rendered, so whatever it points at or
+  // refers to must outlive the error; capture by value
+  template <typename F>
+  void push_with(const F& f) {
+    static_assert(std::is_trivially_copyable<F>::value,
+                  "with_context() callables must be trivially copyable");
+    static_assert(sizeof(F) <= detail::context_frame_bytes &&
+                      alignof(F) <= alignof(std::max_align_t),
+                  "with_context() callable does not fit in a frame");
+    detail::context_frame* frame = next();
+    if (frame != NULL) {
+      frame->format = NULL;
+      frame->append = &detail::context_callable<F>::append;
+      new (frame->data.bytes) F(f);
+    }
+  }
+
+  // Outermost context first, then the error
+  std::string to_string() const {
+    std::string text;
+    if (dropped() > 0) {
+      text += '(';
+      text += std::to_string(dropped());
+      text += " more): ";
+    }
+    for (std::size_t i = frames(); i > 0; --i) {
+      const detail::context_frame& frame = chain_->frames[i - 1];
+      frame.append(frame.format, frame.data.bytes, text);
+      text += ": ";
+    }
+    text += detail::error_text(error_);
+    return text;
+  }
+
+ private:
+  typedef detail::context_chain<Frames> chain;
+
+  template <typename... Args, typename... Values>
+  void push_format(const char* fmt, const Values&... values) {
+    static_assert(detail::all_of<detail::context_arg<Args>::value...>::value,
+                  "context() takes scalar or string arguments");
+    static_assert(detail::context_scalar_size<Args...>::value +
+                          detail::context_text_count<Args...>::value <=
+                      detail::context_frame_bytes,
+                  "context() arguments do not fit in a frame");
+    detail::context_frame* frame = next();
+    if (frame != NULL) {
+      frame->format = fmt;
+      frame->append = &detail::context_format<Args...>::append;
+      unsigned char* bytes = frame->data.bytes;
+      detail::pack_context(
+          bytes,
+          reinterpret_cast<char*>(bytes) +
+              detail::context_scalar_size<Args...>::value,
+          reinterpret_cast<char*>(bytes) + detail::context_frame_bytes,
+          static_cast<const Args&>(values)...);
+    }
+  }
+
+  detail::context_frame* next() {
+    if (chain_ == NULL) {
+      chain_ = new chain;
+      chain_->size = 0;
+      chain_->dropped = 0;
+    }
+    if (chain_->size == Frames) {
+      ++chain_->dropped;
+      return NULL;
+    }
+    return &chain_->frames[chain_->size++];
+  }
+
+  E error_;
+  chain* chain_;
+};
+
+namespace detail {
+
+template <typename E>
+struct context_traits {
+  typedef ContextError<E> type;
+
+  template <typename... Args>
+  static type push(E error, const char* fmt, const Args&... args) {
+    type context(std::move(error));
+    context.push(fmt, args...);
+    return context;
+  }
+
+  template <typename F>
+  static type push_with(E error, const F& f) {
+    type context(std::move(error));
+    context.push_with(f);
+    return context;
+  }
+};
+
+// Context on a ContextError appends a frame instead of nesting
+template <typename E, std::size_t Frames>
+struct context_traits<ContextError<E, Frames> > {
+  typedef ContextError<E, Frames> type;
+
+  template <typename... Args>
+  static type push(type context, const char* fmt, const Args&... args) {
+    context.push(fmt, args...);
+    return context;
+  }
+
+  template <typename F>
+  static type push_with(type context, const F& f) {
+    context.push_with(f);
+    return context;
+  }
+};
+
+}  // namespace detail
+
+}  // namespace rust
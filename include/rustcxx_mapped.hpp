@@ -0,0 +1,467 @@
+/*
+ * Copyright (c) 2025 Dapeng Feng
+ * All rights reserved.
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <type_traits>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define RUSTCXX_HAS_MMAP 1
+#else
+#define RUSTCXX_HAS_MMAP 0
+#endif
+
+#include "rustcxx.hpp"
+#include "rustcxx_enum_vec.hpp"
+
+// Persisted EnumVec that is read in place:
+//
+//   header    magic, version, byte order, type signature, element count,
+//             then one 64-bit element count per alternative
+//   tags      one discriminant per element
+//   slots     32-bit position of each element inside its column
+//   columns   the packed values of each alternative, each aligned for its
+//             type
+//
+// The offsets follow from the counts, so a file is validated once when it
+// is opened and then matched without deserializing. Values are stored in
+// host layout: alternatives must be trivially copyable, and a file only
+// opens on a host with the same byte order.
+
+namespace rust {
+
+enum class MapError : unsigned char {
+  io,             // the file could not be opened, mapped or written
+  bad_magic,      // not a mapped EnumVec image
+  bad_version,    // written by an incompatible version of this header
+  byte_order,     // written on a host with the other byte order
+  type_mismatch,  // written for other alternatives
+  corrupt,        // sizes, tags or slots do not fit the image
+};
+
+inline const char* to_string(MapError error) noexcept {
+  switch (error) {
+    case MapError::io:
+      return "i/o error";
+    case MapError::bad_magic:
+      return "bad magic";
+    case MapError::bad_version:
+      return "unsupported version";
+    case MapError::byte_order:
+      return "byte order mismatch";
+    case MapError::type_mismatch:
+      return "alternative types mismatch";
+    case MapError::corrupt:
+      return "corrupt image";
+  }
+  return "unknown map error";
+}
+
+namespace detail {
+
+struct mapped_header {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t byte_order;
+  std::uint64_t signature;
+  std::uint64_t count;
+  std::uint64_t alternatives;
+};
+
+const char mapped_magic[8] = {'R', 'C', 'X', 'X', 'E', 'V', 'E', 'C'};
+const std::uint32_t mapped_version = 1;
+const std::uint32_t mapped_byte_order = 0x01020304u;
+// Images start on this boundary so that every column can be aligned
+const std::size_t mapped_alignment = 64;
+
+inline std::size_t align_up(std::size_t n, std::size_t alignment) noexcept {
+  return (n + alignment - 1) / alignment * alignment;
+}
+
+// Identifies the alternatives by size, alignment and reflected name
+inline std::uint64_t mapped_mix(std::uint64_t seed, std::uint64_t v) noexcept {
+  return (seed ^ v) * 1099511628211ull;
+}
+
+inline std::uint64_t mapped_mix(std::uint64_t seed, const char* name) noexcept {
+  for (; *name != '\0'; ++name) {
+    seed = mapped_mix(seed, static_cast<unsigned char>(*name));
+  }
+  return seed;
+}
+
+template <typename... Types>
+inline std::uint64_t mapped_signature() noexcept {
+  std::uint64_t seed = 14695981039346656037ull;
+  const std::uint64_t sizes[] = {sizeof(Types)...};
+  const std::uint64_t alignments[] = {alignof(Types)...};
+  const char* const names[] = {variant_traits<Types>::name()...};
+  for (std::size_t i = 0; i < sizeof...(Types); ++i) {
+    seed = mapped_mix(seed, sizes[i]);
+    seed = mapped_mix(seed, alignments[i]);
+    seed = mapped_mix(seed, names[i]);
+  }
+  return mapped_mix(seed, sizeof(typename index_type<sizeof...(Types)>::type));
+}
+
+// Byte offsets of the sections, computed from the counts
+template <typename... Types>
+struct mapped_layout {
+  static const std::size_t alternatives = sizeof...(Types);
+  typedef typename index_type<alternatives>::type index_t;
+
+  std::size_t tags;
+  std::size_t slots;
+  std::size_t columns[alternatives];
+  std::size_t size;
+
+  mapped_layout(std::size_t count, const std::uint64_t* column_counts) {
+    static const std::size_t sizes[] = {sizeof(Types)...};
+    static const std::size_t alignments[] = {alignof(Types)...};
+    tags = sizeof(mapped_header) + alternatives * sizeof(std::uint64_t);
+    slots = align_up(tags + count * sizeof(index_t), sizeof(std::uint32_t));
+    std::size_t end = slots + count * sizeof(std::uint32_t);
+    for (std::size_t i = 0; i < alternatives; ++i) {
+      columns[i] = align_up(end, alignments[i]);
+      end = columns[i] + static_cast<std::size_t>(column_counts[i]) * sizes[i];
+    }
+    size = end;
+  }
+};
+
+template <typename... Types>
+const std::size_t mapped_layout<Types...>::alternatives;
+
+inline void write_padding(std::ostream& out, std::size_t from, std::size_t to) {
+  static const char zeros[mapped_alignment] = {};
+  while (from < to) {
+    const std::size_t n =
+        to - from < mapped_alignment ? to - from : mapped_alignment;
+    out.write(zeros, static_cast<std::streamsize>(n));
+    from += n;
+  }
+}
+
+template <typename... Types>
+struct mapped_writer {
+  const EnumVec<Types...>& vec;
+  const mapped_layout<Types...>& layout;
+  std::ostream& out;
+  std::size_t written;
+
+  template <std::size_t I>
+  void column() {
+    typedef typename type_at<I, Types...>::type type;
+    write_padding(out, written, layout.columns[I]);
+    const std::size_t n = vec.template column<I>().size() * sizeof(type);
+    out.write(reinterpret_cast<const char*>(vec.template column<I>().data()),
+              static_cast<std::streamsize>(n));
+    written = layout.columns[I] + n;
+  }
+
+  template <std::size_t... Is>
+  void columns(index_sequence<Is...>) {
+    int expand[] = {0, (column<Is>(), 0)...};
+    static_cast<void>(expand);
+  }
+};
+
+}  // namespace detail
+
+// Writes vec in the mapped format and returns the number of bytes written
+//
+//   std::ofstream file("events.bin", std::ios::binary);
+//   rust::write_mapped(events, file);
+template <typename... Types>
+Result<std::size_t, MapError> write_mapped(const EnumVec<Types...>& vec,
+                                           std::ostream& out) {
+  static_assert(detail::all_of<std::is_trivially_copyable<Types>::value...>::value,
+                "mapped alternatives must be trivially copyable");
+  const std::uint64_t column_counts[] = {
+      static_cast<std::uint64_t>(vec.template count_of<Types>())...};
+  const detail::mapped_layout<Types...> layout(vec.size(), column_counts);
+
+  detail::mapped_header header;
+  std::memcpy(header.magic, detail::mapped_magic, sizeof(header.magic));
+  header.version = detail::mapped_version;
+  header.byte_order = detail::mapped_byte_order;
+  header.signature = detail::mapped_signature<Types...>();
+  header.count = vec.size();
+  header.alternatives = sizeof...(Types);
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  out.write(reinterpret_cast<const char*>(column_counts),
+            sizeof(column_counts));
+
+  typedef typename EnumVec<Types...>::index_t index_t;
+  out.write(reinterpret_cast<const char*>(vec.indices().data()),
+            static_cast<std::streamsize>(vec.size() * sizeof(index_t)));
+  detail::write_padding(out, layout.tags + vec.size() * sizeof(index_t),
+                        layout.slots);
+  out.write(reinterpret_cast<const char*>(vec.positions().data()),
+            static_cast<std::streamsize>(vec.size() * sizeof(std::uint32_t)));
+
+  detail::mapped_writer<Types...> writer = {
+      vec, layout, out, layout.slots + vec.size() * sizeof(std::uint32_t)};
+  writer.columns(typename detail::make_index_sequence<sizeof...(Types)>::type());
+  if (!out) {
+    return Result<std::size_t, MapError>::Err(MapError::io);
+  }
+  return Result<std::size_t, MapError>::Ok(layout.size);
+}
+
+// Read-only EnumVec over a mapped image: index(), is, get_if and match
+// read the image in place. Move-only; unmaps the file when destroyed.
+//
+//   auto events = rust::MappedEnumSpan<Click, Scroll>::open("events.bin");
+//   events.unwrap()[i].match([](const Click& c) { ... }, ...);
+template <typename... Types>
+class MappedEnumSpan {
+ public:
+  typedef typename detail::index_type<sizeof...(Types)>::type index_t;
+  typedef detail::enum_vec_ref<const MappedEnumSpan> const_reference;
+  typedef const_reference reference;
+
+  static constexpr std::size_t alternatives = sizeof...(Types);
+
+  static_assert(detail::all_of<std::is_trivially_copyable<Types>::value...>::value,
+                "mapped alternatives must be trivially copyable");
+
+  // Views an image already in memory, aligned to 64 bytes, which must
+  // outlive the span
+  static Result<MappedEnumSpan, MapError> from_bytes(const void* data,
+                                                     std::size_t size) {
+    MappedEnumSpan span;
+    const MapError error = span.attach(static_cast<const char*>(data), size);
+    if (RUSTCXX_UNLIKELY(error != ok)) {
+      return Result<MappedEnumSpan, MapError>::Err(error);
+    }
+    return Result<MappedEnumSpan, MapError>::Ok(std::move(span));
+  }
+
+#if RUSTCXX_HAS_MMAP
+  // Maps a file written by write_mapped read-only and validates it
+  static Result<MappedEnumSpan, MapError> open(const char* path) {
+    const int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+      return Result<MappedEnumSpan, MapError>::Err(MapError::io);
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+      ::close(fd);
+      return Result<MappedEnumSpan, MapError>::Err(MapError::io);
+    }
+    if (st.st_size <= 0) {
+      ::close(fd);
+      return Result<MappedEnumSpan, MapError>::Err(
+          st.st_size == 0 ? MapError::corrupt : MapError::io);
+    }
+    const std::size_t size = static_cast<std::size_t>(st.st_size);
+    void* data = ::mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+      return Result<MappedEnumSpan, MapError>::Err(MapError::io);
+    }
+    MappedEnumSpan span;
+    span.mapping_ = data;
+    span.mapping_size_ = size;
+    const MapError error = span.attach(static_cast<const char*>(data), size);
+    if (RUSTCXX_UNLIKELY(error != ok)) {
+      return Result<MappedEnumSpan, MapError>::Err(error);
+    }
+    return Result<MappedEnumSpan, MapError>::Ok(std::move(span));
+  }
+#endif
+
+  MappedEnumSpan(MappedEnumSpan&& other) noexcept { steal(other); }
+
+  MappedEnumSpan& operator=(MappedEnumSpan&& other) noexcept {
+    if (this != &other) {
+      unmap();
+      steal(other);
+    }
+    return *this;
+  }
+
+  MappedEnumSpan(const MappedEnumSpan&) = delete;
+  MappedEnumSpan& operator=(const MappedEnumSpan&) = delete;
+
+  ~MappedEnumSpan() { unmap(); }
+
+  std::size_t size() const noexcept { return size_; }
+
+  bool empty() const noexcept { return size_ == 0; }
+
+  const_reference operator[](std::size_t position) const noexcept {
+    return const_reference(*this, position);
+  }
+
+  // Discriminant of the element at position
+  std::size_t index_at(std::size_t position) const noexcept {
+    return tags_[position];
+  }
+
+  // Dense discriminant array, one entry per element
+  const index_t* indices() const noexcept { return tags_; }
+
+  // Packed values of one alternative, in insertion order
+  template <std::size_t I>
+  const typename detail::type_at<I, Types...>::type* column() const noexcept {
+    return static_cast<const typename detail::type_at<I, Types...>::type*>(
+        columns_[I]);
+  }
+
+  template <typename T>
+  const T* column() const noexcept {
+    return static_cast<const T*>(columns_[index_of<T>()]);
+  }
+
+  // Number of elements holding T
+  template <typename T>
+  std::size_t count_of() const noexcept {
+    return counts_[index_of<T>()];
+  }
+
+  // Call f on every T, in insertion order, without touching the others
+  template <typename T, typename F>
+  void for_each_of(F&& f) const {
+    const T* values = column<T>();
+    const std::size_t n = count_of<T>();
+    for (std::size_t i = 0; i < n; ++i) {
+      f(values[i]);
+    }
+  }
+
+  template <typename T>
+  static constexpr std::size_t index_of() {
+    static_assert(detail::index_of<T, Types...>::value < sizeof...(Types),
+                  "T is not an alternative of this MappedEnumSpan");
+    return detail::index_of<T, Types...>::value;
+  }
+
+ private:
+  template <typename Vec>
+  friend class detail::enum_vec_ref;
+
+  // Success marker for attach(); not an error a caller sees
+  static const MapError ok = static_cast<MapError>(0xff);
+
+  MappedEnumSpan() noexcept
+      : tags_(NULL), slots_(NULL), size_(0), mapping_(NULL), mapping_size_(0) {
+    for (std::size_t i = 0; i < alternatives; ++i) {
+      columns_[i] = NULL;
+      counts_[i] = 0;
+    }
+  }
+
+  // Checks the header, the section sizes and every tag and slot once, so
+  // that element access needs no checks later
+  MapError attach(const char* data, std::size_t size) noexcept {
+    typedef detail::mapped_header header_type;
+    const std::size_t table = sizeof(header_type) + sizeof(counts_wire_);
+    if (size < table ||
+        reinterpret_cast<std::uintptr_t>(data) % detail::mapped_alignment != 0) {
+      return size < sizeof(header_type) ? MapError::bad_magic
+                                        : MapError::corrupt;
+    }
+    header_type header;
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, detail::mapped_magic, sizeof(header.magic)) !=
+        0) {
+      return MapError::bad_magic;
+    }
+    if (header.version != detail::mapped_version) {
+      return MapError::bad_version;
+    }
+    if (header.byte_order != detail::mapped_byte_order) {
+      return MapError::byte_order;
+    }
+    if (header.alternatives != alternatives ||
+        header.signature != detail::mapped_signature<Types...>()) {
+      return MapError::type_mismatch;
+    }
+    std::memcpy(counts_wire_, data + sizeof(header_type), sizeof(counts_wire_));
+
+    // Counts large enough to overflow the layout cannot fit in the image
+    std::uint64_t total = 0;
+    for (std::size_t i = 0; i < alternatives; ++i) {
+      if (counts_wire_[i] > size) {
+        return MapError::corrupt;
+      }
+      total += counts_wire_[i];
+    }
+    if (header.count > size || total != header.count) {
+      return MapError::corrupt;
+    }
+    const detail::mapped_layout<Types...> layout(
+        static_cast<std::size_t>(header.count), counts_wire_);
+    if (layout.size != size) {
+      return MapError::corrupt;
+    }
+
+    size_ = static_cast<std::size_t>(header.count);
+    tags_ = reinterpret_cast<const index_t*>(data + layout.tags);
+    slots_ = reinterpret_cast<const std::uint32_t*>(data + layout.slots);
+    for (std::size_t i = 0; i < alternatives; ++i) {
+      columns_[i] = data + layout.columns[i];
+      counts_[i] = static_cast<std::size_t>(counts_wire_[i]);
+    }
+    for (std::size_t i = 0; i < size_; ++i) {
+      if (tags_[i] >= alternatives || slots_[i] >= counts_[tags_[i]]) {
+        return MapError::corrupt;
+      }
+    }
+    return ok;
+  }
+
+  void steal(MappedEnumSpan& other) noexcept {
+    tags_ = other.tags_;
+    slots_ = other.slots_;
+    size_ = other.size_;
+    mapping_ = other.mapping_;
+    mapping_size_ = other.mapping_size_;
+    for (std::size_t i = 0; i < alternatives; ++i) {
+      columns_[i] = other.columns_[i];
+      counts_[i] = other.counts_[i];
+      counts_wire_[i] = other.counts_wire_[i];
+    }
+    other.mapping_ = NULL;
+    other.mapping_size_ = 0;
+  }
+
+  void unmap() noexcept {
+#if RUSTCXX_HAS_MMAP
+    if (mapping_ != NULL) {
+      ::munmap(mapping_, mapping_size_);
+      mapping_ = NULL;
+    }
+#endif
+  }
+
+  const index_t* tags_;
+  // Position of each element inside its alternative's column
+  const std::uint32_t* slots_;
+  std::size_t size_;
+  const void* columns_[alternatives];
+  std::size_t counts_[alternatives];
+  std::uint64_t counts_wire_[alternatives];
+  void* mapping_;
+  std::size_t mapping_size_;
+};
+
+template <typename... Types>
+constexpr std::size_t MappedEnumSpan<Types...>::alternatives;
+
+template <typename... Types>
+const MapError MappedEnumSpan<Types...>::ok;
+
+}  // namespace rust
@@ -0,0 +1,325 @@
+/*
+ * Copyright (c) 2025 Dapeng Feng
+ * All rights reserved.
+ */
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "rustcxx.hpp"
+
+namespace rust {
+
+// Executors run callables, possibly on other threads:
+//   void execute(F&& f);            // run f() at some point
+//   std::size_t concurrency() const;  // workers available to the caller
+
+// Runs every task immediately on the calling thread
+class InlineExecutor {
+ public:
+  template <typename F>
+  void execute(F&& f) {
+    f();
+  }
+
+  std::size_t concurrency() const noexcept { return 1; }
+};
+
+// Fixed set of worker threads sharing one FIFO queue
+class ThreadPool {
+ public:
+  explicit ThreadPool(std::size_t threads = std::thread::hardware_concurrency())
+      : stopping_(false) {
+    if (threads == 0) {
+      threads = 1;
+    }
+    workers_.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i) {
+      workers_.emplace_back([this] { run(); });
+    }
+  }
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  // Finishes the queued tasks, then joins the workers
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    ready_.notify_all();
+    for (std::size_t i = 0; i < workers_.size(); ++i) {
+      workers_[i].join();
+    }
+  }
+
+  template <typename F>
+  void execute(F&& f) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      tasks_.push_back(std::function<void()>(std::forward<F>(f)));
+    }
+    ready_.notify_one();
+  }
+
+  std::size_t concurrency() const noexcept { return workers_.size(); }
+
+ private:
+  void run() {
+    for (;;) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        ready_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+        if (tasks_.empty()) {
+          return;
+        }
+        task = std::move(tasks_.front());
+        tasks_.pop_front();
+      }
+      task();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable ready_;
+  std::deque<std::function<void()> > tasks_;
+  std::vector<std::thread> workers_;
+  bool stopping_;
+};
+
+namespace detail {
+
+// Output slots written by index from several threads. Default-constructible
+// values are assigned in place; others (and bool, whose vector packs bits
+// that neighbouring writers would race on) are built in optional slots and
+// moved out once every worker is done.
+template <typename U, bool Direct = std::is_default_constructible<U>::value &&
+                                    !std::is_same<U, bool>::value>
+class par_output {
+ public:
+  explicit par_output(std::size_t n) : values_(n) {}
+
+  void set(std::size_t i, U&& value) { values_[i] = std::move(value); }
+
+  std::vector<U> take() { return std::move(values_); }
+
+ private:
+  std::vector<U> values_;
+};
+
+template <typename U>
+class par_output<U, false> {
+ public:
+  explicit par_output(std::size_t n) : slots_(n) {}
+
+  void set(std::size_t i, U&& value) { slots_[i].emplace(std::move(value)); }
+
+  std::vector<U> take() {
+    std::vector<U> values;
+    values.reserve(slots_.size());
+    for (std::size_t i = 0; i < slots_.size(); ++i) {
+      values.push_back(std::move(*slots_[i]));
+    }
+    return values;
+  }
+
+ private:
+  std::vector<detail::backend::optional<U> > slots_;
+};
+
+// State shared by the workers of one par_try_map call. Helpers hold it
+// through a shared_ptr: one that starts after the call has returned (a
+// nested call leaves its helpers queued behind busy workers) finds it
+// closed and touches nothing else.
+template <typename Iterator, typename F, typename U, typename E>
+struct par_try_map_state {
+  Iterator first;
+  F& f;
+  std::size_t size;
+  std::size_t chunk;
+  std::size_t chunks;
+
+  par_output<U> output;
+  std::atomic<std::size_t> next_chunk;
+  // Index of the earliest Err seen so far, size if none; workers stop as
+  // soon as everything they could still reach lies beyond it
+  std::atomic<std::size_t> first_error;
+
+  std::mutex mutex;
+  std::condition_variable done;
+  // Threads inside work(); the caller counts from the start, helpers
+  // only once they join
+  std::size_t running;
+  // Set when the caller has run out of work; later helpers do not join
+  bool closed;
+  detail::backend::optional<E> error;
+#if !RUSTCXX_CONFIG_NO_EXCEPTIONS
+  std::exception_ptr exception;
+#endif
+
+  par_try_map_state(Iterator begin, F& fn, std::size_t n, std::size_t c)
+      : first(begin),
+        f(fn),
+        size(n),
+        chunk(c),
+        chunks((n + c - 1) / c),
+        output(n),
+        next_chunk(0),
+        first_error(n),
+        running(1),
+        closed(false) {}
+
+  void fail(std::size_t index, E&& e) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (index < first_error.load(std::memory_order_relaxed)) {
+      error.emplace(std::move(e));
+      first_error.store(index, std::memory_order_release);
+    }
+  }
+
+  void process() {
+    for (;;) {
+      const std::size_t c = next_chunk.fetch_add(1, std::memory_order_relaxed);
+      const std::size_t begin = c * chunk;
+      if (c >= chunks ||
+          begin >= first_error.load(std::memory_order_acquire)) {
+        return;
+      }
+      const std::size_t end = begin + chunk < size ? begin + chunk : size;
+      for (std::size_t i = begin; i < end; ++i) {
+        if (RUSTCXX_UNLIKELY(i >= first_error.load(std::memory_order_relaxed))) {
+          return;
+        }
+        Result<U, E> r = f(first[static_cast<std::ptrdiff_t>(i)]);
+        if (RUSTCXX_UNLIKELY(r.is_err())) {
+          fail(i, std::move(r).unwrap_err_unchecked());
+          return;
+        }
+        output.set(i, std::move(r).unwrap_unchecked());
+      }
+    }
+  }
+
+  void work() {
+#if RUSTCXX_CONFIG_NO_EXCEPTIONS
+    process();
+#else
+    try {
+      process();
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!exception) {
+        exception = std::current_exception();
+      }
+      first_error.store(0, std::memory_order_release);
+    }
+#endif
+    std::lock_guard<std::mutex> lock(mutex);
+    if (--running == 0) {
+      done.notify_all();
+    }
+  }
+
+  // Entry point of a helper task
+  void help() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (closed) {
+        return;
+      }
+      ++running;
+    }
+    work();
+  }
+
+  // The caller's share: works until no chunk is left, then waits only for
+  // the helpers that joined
+  void run_and_wait() {
+    work();
+    std::unique_lock<std::mutex> lock(mutex);
+    closed = true;
+    done.wait(lock, [this] { return running == 0; });
+  }
+};
+
+template <typename Range, typename F>
+struct par_try_map_result {
+  typedef typename std::decay<decltype(std::declval<F&>()(
+      *std::begin(std::declval<Range&>())))>::type step_type;
+  typedef typename step_type::ok_type ok_type;
+  typedef typename step_type::err_type err_type;
+  typedef Result<std::vector<ok_type>, err_type> type;
+};
+
+}  // namespace detail
+
+// Applies f, which returns Result<U, E>, to every element of a random
+// access range on the executor's workers, writing the values into
+// preallocated output. The first Err stops the other workers through an
+// atomic index. The returned Err is always the one with the lowest index,
+// whatever order the workers ran in. f is called concurrently and may
+// itself call par_try_map on the same executor: the caller works through
+// the chunks itself and never waits for helpers that have not started.
+//
+//   rust::ThreadPool pool(8);
+//   auto parsed = rust::par_try_map(lines, parse_record, pool);
+template <typename Range, typename F, typename Executor>
+typename detail::par_try_map_result<Range, F>::type par_try_map(
+    Range&& range, F&& f, Executor& executor) {
+  typedef detail::par_try_map_result<Range, F> traits;
+  typedef typename traits::type result_type;
+  typedef decltype(std::begin(range)) iterator;
+  typedef detail::par_try_map_state<iterator, F, typename traits::ok_type,
+                                    typename traits::err_type>
+      state_type;
+
+  const std::size_t size =
+      static_cast<std::size_t>(std::distance(std::begin(range), std::end(range)));
+  if (size == 0) {
+    return result_type::Ok(std::vector<typename traits::ok_type>());
+  }
+
+  // A few chunks per worker balances uneven elements; the caller works too
+  std::size_t workers = executor.concurrency() + 1;
+  std::size_t chunk = size / (workers * 4);
+  if (chunk == 0) {
+    chunk = 1;
+  }
+  const std::size_t chunks = (size + chunk - 1) / chunk;
+  if (workers > chunks) {
+    workers = chunks;
+  }
+
+  const std::shared_ptr<state_type> state =
+      std::make_shared<state_type>(std::begin(range), f, size, chunk);
+  for (std::size_t i = 1; i < workers; ++i) {
+    executor.execute([state] { state->help(); });
+  }
+  state->run_and_wait();
+
+#if !RUSTCXX_CONFIG_NO_EXCEPTIONS
+  if (state->exception) {
+    std::rethrow_exception(state->exception);
+  }
+#endif
+  if (state->error) {
+    return result_type::Err(std::move(*state->error));
+  }
+  return result_type::Ok(state->output.take());
+}
+
+}  // namespace rust
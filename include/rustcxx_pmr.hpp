@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2025 Dapeng Feng
+ * All rights reserved.
+ */
+
+#pragma once
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "rustcxx.hpp"
+
+// Helpers that construct Result and Enum payloads from a
+// std::pmr::memory_resource (requires C++17). Result and Enum themselves
+// are not allocator-aware: they take no allocator and copy their payloads
+// with the payload's own copy constructor. std::pmr::string and the
+// std::pmr containers keep their resource when moved, so a Result built
+// here stays on its arena as long as it is moved; a copy allocates from
+// the default resource.
+
+namespace rust {
+namespace pmr {
+
+typedef std::pmr::polymorphic_allocator<char> allocator_type;
+
+typedef std::pmr::string string;
+
+}  // namespace pmr
+
+namespace detail {
+
+// Uses-allocator construction as in [allocator.uses.construction]: T takes
+// (allocator_arg, alloc, args...), (args..., alloc), or ignores allocators
+template <typename T, typename... Args>
+struct pmr_leading_allocator
+    : std::integral_constant<
+          bool, std::uses_allocator<T, pmr::allocator_type>::value &&
+                    std::is_constructible<T, std::allocator_arg_t,
+                                          const pmr::allocator_type&,
+                                          Args...>::value> {};
+
+template <typename T, typename F, typename... Args>
+inline decltype(auto) pmr_construct(std::integral_constant<int, 0>, F&& f,
+                                    const pmr::allocator_type&,
+                                    Args&&... args) {
+  return f(std::forward<Args>(args)...);
+}
+
+template <typename T, typename F, typename... Args>
+inline decltype(auto) pmr_construct(std::integral_constant<int, 1>, F&& f,
+                                    const pmr::allocator_type& alloc,
+                                    Args&&... args) {
+  return f(std::allocator_arg, alloc, std::forward<Args>(args)...);
+}
+
+template <typename T, typename F, typename... Args>
+inline decltype(auto) pmr_construct(std::integral_constant<int, 2>, F&& f,
+                                    const pmr::allocator_type& alloc,
+                                    Args&&... args) {
+  return f(std::forward<Args>(args)..., alloc);
+}
+
+// Calls f with args plus the allocator in the position T expects
+template <typename T, typename F, typename... Args>
+inline decltype(auto) pmr_construct(std::pmr::memory_resource* resource,
+                                    F&& f, Args&&... args) {
+  typedef std::integral_constant<
+      int, !std::uses_allocator<T, pmr::allocator_type>::value ? 0
+           : pmr_leading_allocator<T, Args...>::value       ? 1
+                                                             : 2>
+      kind;
+  return pmr_construct<T>(kind(), std::forward<F>(f),
+                          pmr::allocator_type(resource),
+                          std::forward<Args>(args)...);
+}
+
+}  // namespace detail
+
+namespace pmr {
+
+// Builds a T whose allocations (if any) come from resource
+//
+//   std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer));
+//   auto message = rust::pmr::make<rust::pmr::string>(&arena, "bad header");
+template <typename T, typename... Args>
+inline T make(std::pmr::memory_resource* resource, Args&&... args) {
+  return detail::pmr_construct<T>(
+      resource,
+      [](auto&&... a) { return T(std::forward<decltype(a)>(a)...); },
+      std::forward<Args>(args)...);
+}
+
+// Ok result whose value is constructed in place from resource
+template <typename R, typename... Args>
+inline R emplace_ok(std::pmr::memory_resource* resource, Args&&... args) {
+  return detail::pmr_construct<typename R::ok_type>(
+      resource,
+      [](auto&&... a) { return R::emplace_ok(std::forward<decltype(a)>(a)...); },
+      std::forward<Args>(args)...);
+}
+
+// Err result whose error is constructed in place from resource
+//
+//   typedef rust::Result<Header, rust::pmr::string> HeaderResult;
+//   return rust::pmr::emplace_err<HeaderResult>(&arena, "bad header");
+template <typename R, typename... Args>
+inline R emplace_err(std::pmr::memory_resource* resource, Args&&... args) {
+  return detail::pmr_construct<typename R::err_type>(
+      resource,
+      [](auto&&... a) {
+        return R::emplace_err(std::forward<decltype(a)>(a)...);
+      },
+      std::forward<Args>(args)...);
+}
+
+// Enum holding a T constructed from resource; the payload is moved in,
+// which keeps its allocator
+template <typename E, typename T, typename... Args>
+inline E make_enum(std::pmr::memory_resource* resource, Args&&... args) {
+  return E(make<T>(resource, std::forward<Args>(args)...));
+}
+
+}  // namespace pmr
+}  // namespace rust
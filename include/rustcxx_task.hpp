@@ -0,0 +1,721 @@
+/*
+ * Copyright (c) 2025 Dapeng Feng
+ * All rights reserved.
+ */
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "rustcxx.hpp"
+
+// Lazy coroutines resolving to a value, usually a rust::Result (requires
+// C++20). Inside a Task<Result<T, E>>, co_await on a Result is Rust's `?`:
+// it yields the Ok value or returns the Err, converted by rust::From,
+// from the task. Tasks start when awaited or handed to an executor's
+// block_on, and their frames come from a thread-local pool.
+//
+//   rust::Task<rust::Result<Header, IoError>> read_header(Socket& s) {
+//     Bytes raw = co_await co_await s.read(64);  // await, then `?`
+//     Header h = co_await parse_header(raw);     // `?` on a plain Result
+//     co_return rust::Result<Header, IoError>::Ok(h);
+//   }
+
+namespace rust {
+
+template <typename T>
+class Task;
+
+namespace detail {
+
+// Thread-local free lists of coroutine frames in 64-byte size classes up
+// to 1 KiB; larger frames, and blocks beyond the per-class cap, go to the
+// global operator new. A frame freed on another thread joins that
+// thread's lists.
+class frame_pool {
+ public:
+  static void* allocate(std::size_t size) {
+    const std::size_t c = size_class(size);
+    if (c >= classes) {
+      return ::operator new(size);
+    }
+    cache& local = thread_cache();
+    if (block* b = local.head[c]) {
+      local.head[c] = b->next;
+      --local.count[c];
+      return b;
+    }
+    return ::operator new((c + 1) * granule);
+  }
+
+  static void deallocate(void* p, std::size_t size) noexcept {
+    const std::size_t c = size_class(size);
+    if (c >= classes) {
+      ::operator delete(p);
+      return;
+    }
+    cache& local = thread_cache();
+    if (local.count[c] >= max_cached) {
+      ::operator delete(p);
+      return;
+    }
+    block* b = static_cast<block*>(p);
+    b->next = local.head[c];
+    local.head[c] = b;
+    ++local.count[c];
+  }
+
+ private:
+  static constexpr std::size_t granule = 64;
+  static constexpr std::size_t classes = 16;
+  static constexpr std::size_t max_cached = 256;
+
+  struct block {
+    block* next;
+  };
+
+  struct cache {
+    block* head[classes] = {};
+    std::size_t count[classes] = {};
+
+    ~cache() {
+      for (block* b : head) {
+        while (b != nullptr) {
+          block* next = b->next;
+          ::operator delete(b);
+          b = next;
+        }
+      }
+    }
+  };
+
+  static std::size_t size_class(std::size_t size) noexcept {
+    return (size + granule - 1) / granule - 1;
+  }
+
+  static cache& thread_cache() {
+    thread_local cache local;
+    return local;
+  }
+};
+
+template <typename T>
+struct is_result : std::false_type {};
+
+template <typename T, typename E>
+struct is_result<Result<T, E> > : std::true_type {};
+
+// Frame allocation, lazy start and symmetric transfer back to the awaiter
+struct task_promise_base {
+  static void* operator new(std::size_t size) {
+    return frame_pool::allocate(size);
+  }
+
+  static void operator delete(void* p, std::size_t size) noexcept {
+    frame_pool::deallocate(p, size);
+  }
+
+  struct final_awaiter {
+    bool await_ready() noexcept { return false; }
+
+    template <typename Promise>
+    std::coroutine_handle<> await_suspend(
+        std::coroutine_handle<Promise> h) noexcept {
+      return h.promise().continuation;
+    }
+
+    void await_resume() noexcept {}
+  };
+
+  std::suspend_always initial_suspend() noexcept { return {}; }
+
+  final_awaiter final_suspend() noexcept { return {}; }
+
+  void unhandled_exception() noexcept {
+#if RUSTCXX_CONFIG_NO_EXCEPTIONS
+    std::terminate();
+#else
+    exception = std::current_exception();
+#endif
+  }
+
+  void rethrow_if_failed() const {
+#if !RUSTCXX_CONFIG_NO_EXCEPTIONS
+    if (RUSTCXX_UNLIKELY(exception)) {
+      std::rethrow_exception(exception);
+    }
+#endif
+  }
+
+  std::coroutine_handle<> continuation = std::noop_coroutine();
+  std::exception_ptr exception;
+};
+
+// `?` on a Result: resumes with the Ok value without suspending, or stores
+// the Err as the task's value and hands control straight to the awaiter.
+// The task's frame then stays suspended until its Task is destroyed.
+template <typename R>
+struct try_awaiter {
+  R&& result;
+
+  bool await_ready() const noexcept { return result.is_ok(); }
+
+  template <typename Promise>
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) {
+    Promise& promise = h.promise();
+    promise.return_err(std::forward<R>(result).unwrap_err_unchecked());
+    return promise.continuation;
+  }
+
+  decltype(auto) await_resume() {
+    return std::forward<R>(result).unwrap_unchecked();
+  }
+};
+
+template <typename T>
+struct task_promise : task_promise_base {
+  Task<T> get_return_object() noexcept;
+
+  template <typename U = T>
+  void return_value(U&& result) {
+    value.emplace(std::forward<U>(result));
+  }
+
+  template <typename F>
+  void return_err(F&& error) {
+    static_assert(is_result<T>::value,
+                  "co_await on a Result needs a Task<Result<T, E>>");
+    typedef typename T::err_type err_type;
+    typedef typename std::decay<F>::type source;
+    value.emplace(T::Err(From<err_type, source>::from(std::forward<F>(error))));
+  }
+
+  template <typename A>
+  decltype(auto) await_transform(A&& awaitable) {
+    if constexpr (is_result<typename std::remove_cv<
+                      typename std::remove_reference<A>::type>::type>::value) {
+      return try_awaiter<A>{std::forward<A>(awaitable)};
+    } else {
+      return std::forward<A>(awaitable);
+    }
+  }
+
+  T result() {
+    rethrow_if_failed();
+    return std::move(*value);
+  }
+
+  std::optional<T> value;
+};
+
+struct task_access;
+
+}  // namespace detail
+
+// Lazy coroutine producing a T; move-only, and destroying it destroys the
+// frame whether or not the task ran. co_await on a Task starts it and
+// yields its value.
+template <typename T>
+class [[nodiscard]] Task {
+ public:
+  typedef detail::task_promise<T> promise_type;
+  typedef T value_type;
+
+  Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+
+  Task& operator=(Task&& other) noexcept {
+    Task(std::move(other)).swap(*this);
+    return *this;
+  }
+
+  Task(const Task&) = delete;
+  Task& operator=(const Task&) = delete;
+
+  ~Task() {
+    if (handle_) {
+      handle_.destroy();
+    }
+  }
+
+  void swap(Task& other) noexcept { std::swap(handle_, other.handle_); }
+
+  auto operator co_await() noexcept {
+    struct awaiter {
+      std::coroutine_handle<promise_type> handle;
+
+      bool await_ready() const noexcept { return false; }
+
+      std::coroutine_handle<> await_suspend(
+          std::coroutine_handle<> awaiting) noexcept {
+        handle.promise().continuation = awaiting;
+        return handle;
+      }
+
+      T await_resume() { return handle.promise().result(); }
+    };
+    return awaiter{handle_};
+  }
+
+ private:
+  friend struct detail::task_promise<T>;
+  friend struct detail::task_access;
+
+  explicit Task(std::coroutine_handle<promise_type> handle) noexcept
+      : handle_(handle) {}
+
+  std::coroutine_handle<promise_type> handle_;
+};
+
+namespace detail {
+
+template <typename T>
+Task<T> task_promise<T>::get_return_object() noexcept {
+  return Task<T>(std::coroutine_handle<task_promise>::from_promise(*this));
+}
+
+// Executors and when_all reach into a task's promise through this
+struct task_access {
+  template <typename T>
+  static task_promise<T>& promise(Task<T>& task) noexcept {
+    return task.handle_.promise();
+  }
+
+  // Runs the task and resumes awaiting without reading its value
+  template <typename T>
+  static auto completion(Task<T>& task) noexcept {
+    struct awaiter {
+      std::coroutine_handle<task_promise<T> > handle;
+
+      bool await_ready() const noexcept { return false; }
+
+      std::coroutine_handle<> await_suspend(
+          std::coroutine_handle<> awaiting) noexcept {
+        handle.promise().continuation = awaiting;
+        return handle;
+      }
+
+      void await_resume() noexcept {}
+    };
+    return awaiter{task.handle_};
+  }
+};
+
+// Fire-and-forget coroutine that starts at once and frees itself at the
+// end; it drives Tasks for when_all and block_on
+struct detached_task {
+  struct promise_type {
+    static void* operator new(std::size_t size) {
+      return frame_pool::allocate(size);
+    }
+
+    static void operator delete(void* p, std::size_t size) noexcept {
+      frame_pool::deallocate(p, size);
+    }
+
+    detached_task get_return_object() noexcept { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() noexcept {}
+    void unhandled_exception() noexcept { std::terminate(); }
+  };
+};
+
+template <typename Executor>
+struct schedule_awaiter {
+  Executor* executor;
+
+  bool await_ready() const noexcept { return false; }
+
+  void await_suspend(std::coroutine_handle<> h) { executor->post(h); }
+
+  void await_resume() const noexcept {}
+};
+
+// Shared by when_all and its children. The first failure, an Err or an
+// exception, is recorded once and resumes the parent as soon as every
+// child has been started; otherwise the last child to finish resumes it.
+// Children still running after a failure finish on their own and are
+// freed with the state.
+template <typename U, typename E>
+struct when_all_state {
+  typedef Result<U, E> result_type;
+
+  explicit when_all_state(std::vector<Task<result_type> >&& children)
+      : tasks(std::move(children)),
+        values(tasks.size()),
+        remaining(tasks.size() + 1) {}
+
+  void complete(std::size_t i) {
+    task_promise<result_type>& promise = task_access::promise(tasks[i]);
+    if (RUSTCXX_UNLIKELY(promise.exception)) {
+      fail([&] { exception = promise.exception; });
+    } else if (RUSTCXX_LIKELY(promise.value->is_ok())) {
+      values[i].emplace(std::move(*promise.value).unwrap_unchecked());
+    } else {
+      fail([&] {
+        error.emplace(std::move(*promise.value).unwrap_err_unchecked());
+      });
+    }
+    if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      resume_parent();
+    }
+  }
+
+  template <typename Record>
+  void fail(Record record) {
+    if (claimed.exchange(true)) {
+      return;
+    }
+    record();
+    failed.store(true);
+    if (launched.load()) {
+      resume_parent();
+    }
+  }
+
+  // True for the one caller that gets to resume the parent
+  bool claim_resume() noexcept { return !resumed.exchange(true); }
+
+  void resume_parent() {
+    if (claim_resume()) {
+      parent.resume();
+    }
+  }
+
+  std::vector<Task<result_type> > tasks;
+  std::vector<std::optional<U> > values;
+  std::optional<E> error;
+  std::exception_ptr exception;
+  std::coroutine_handle<> parent;
+  std::atomic<std::size_t> remaining;
+  std::atomic<bool> claimed{false};
+  std::atomic<bool> failed{false};
+  std::atomic<bool> launched{false};
+  std::atomic<bool> resumed{false};
+};
+
+template <typename U, typename E>
+detached_task drive_child(std::shared_ptr<when_all_state<U, E> > state,
+                          std::size_t i) {
+  co_await task_access::completion(state->tasks[i]);
+  state->complete(i);
+}
+
+template <typename U, typename E>
+class when_all_awaiter {
+ public:
+  explicit when_all_awaiter(std::shared_ptr<when_all_state<U, E> > state)
+      : state_(std::move(state)) {}
+
+  bool await_ready() const noexcept { return state_->tasks.empty(); }
+
+  bool await_suspend(std::coroutine_handle<> parent) {
+    // Once launched a child may resume the parent and free *this
+    std::shared_ptr<when_all_state<U, E> > state = state_;
+    state->parent = parent;
+    for (std::size_t i = 0; i < state->tasks.size(); ++i) {
+      drive_child(state, i);
+    }
+    state->launched.store(true);
+    if (state->failed.load() ||
+        state->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      return !state->claim_resume();
+    }
+    return true;
+  }
+
+  Result<std::vector<U>, E> await_resume() {
+    typedef Result<std::vector<U>, E> result_type;
+#if !RUSTCXX_CONFIG_NO_EXCEPTIONS
+    if (RUSTCXX_UNLIKELY(state_->exception)) {
+      std::rethrow_exception(state_->exception);
+    }
+#endif
+    if (RUSTCXX_UNLIKELY(state_->failed.load())) {
+      return result_type::Err(std::move(*state_->error));
+    }
+    std::vector<U> values;
+    values.reserve(state_->values.size());
+    for (std::size_t i = 0; i < state_->values.size(); ++i) {
+      values.push_back(std::move(*state_->values[i]));
+    }
+    return result_type::Ok(std::move(values));
+  }
+
+ private:
+  std::shared_ptr<when_all_state<U, E> > state_;
+};
+
+// Lets block_on sleep until a task finishes on another thread
+class completion_event {
+ public:
+  void set() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    done_ = true;
+    ready_.notify_all();
+  }
+
+  void wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    ready_.wait(lock, [this] { return done_; });
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable ready_;
+  bool done_ = false;
+};
+
+}  // namespace detail
+
+// Runs every task concurrently and resolves to Ok with their values in
+// order, or to the first Err as soon as one fails; tasks still running
+// then finish in the background and their results are dropped. Children
+// start on the awaiting thread and run there until they first suspend.
+//
+//   std::vector<rust::Task<rust::Result<Page, IoError>>> fetches;
+//   for (const Url& url : urls) fetches.push_back(fetch(url));
+//   std::vector<Page> pages =
+//       co_await co_await rust::when_all(std::move(fetches));  // then `?`
+template <typename U, typename E>
+detail::when_all_awaiter<U, E> when_all(
+    std::vector<Task<Result<U, E> > > tasks) {
+  return detail::when_all_awaiter<U, E>(
+      std::make_shared<detail::when_all_state<U, E> >(std::move(tasks)));
+}
+
+// Resumes coroutines on the thread that calls block_on or run. post is
+// safe from any thread, so completions from other threads hop back here.
+class SingleThreadExecutor {
+ public:
+  SingleThreadExecutor() = default;
+  SingleThreadExecutor(const SingleThreadExecutor&) = delete;
+  SingleThreadExecutor& operator=(const SingleThreadExecutor&) = delete;
+
+  // Runs what is still queued, such as when_all children left behind by
+  // a short-circuit, so that their frames are released
+  ~SingleThreadExecutor() { run(); }
+
+  void post(std::coroutine_handle<> h) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ready_.push_back(h);
+    }
+    wake_.notify_one();
+  }
+
+  // co_await executor.schedule() continues the coroutine on this executor
+  detail::schedule_awaiter<SingleThreadExecutor> schedule() noexcept {
+    return {this};
+  }
+
+  // Resumes queued coroutines until none is left; returns how many ran
+  std::size_t run() {
+    std::size_t resumed = 0;
+    while (std::coroutine_handle<> h = pop(nullptr)) {
+      h.resume();
+      ++resumed;
+    }
+    return resumed;
+  }
+
+  // Runs task on this thread, waiting for posts from other threads while
+  // the queue is empty, and returns its value
+  template <typename T>
+  T block_on(Task<T> task) {
+    bool done = false;
+    drive(task, done);
+    while (std::coroutine_handle<> h = pop(&done)) {
+      h.resume();
+    }
+    return detail::task_access::promise(task).result();
+  }
+
+ private:
+  // The task may finish on another thread. done is set and signalled
+  // under mutex_ and only read under it, so once block_on sees it that
+  // thread is done with the executor, which may then be destroyed.
+  template <typename T>
+  detail::detached_task drive(Task<T>& task, bool& done) {
+    co_await schedule();
+    co_await detail::task_access::completion(task);
+    std::lock_guard<std::mutex> lock(mutex_);
+    done = true;
+    wake_.notify_one();
+  }
+
+  // Next queued coroutine; given a block_on flag, sleeps until one
+  // arrives or the flag is set (a null handle)
+  std::coroutine_handle<> pop(const bool* done) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (done != nullptr) {
+      wake_.wait(lock, [this, done] { return !ready_.empty() || *done; });
+      if (*done) {
+        return nullptr;
+      }
+    }
+    if (ready_.empty()) {
+      return nullptr;
+    }
+    std::coroutine_handle<> h = ready_.front();
+    ready_.pop_front();
+    return h;
+  }
+
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::deque<std::coroutine_handle<> > ready_;
+};
+
+// Fixed pool of worker threads, each with its own queue. A worker runs
+// its queue in order and, when it runs dry, steals the newest coroutine
+// from another worker's queue; idle workers sleep. Coroutines posted from
+// a worker stay on its queue; others are spread round-robin.
+class WorkStealingExecutor {
+ public:
+  explicit WorkStealingExecutor(
+      std::size_t threads = std::thread::hardware_concurrency())
+      : queues_(threads == 0 ? 1 : threads) {
+    for (std::size_t i = 0; i < queues_.size(); ++i) {
+      workers_.emplace_back([this, i] { work(i); });
+    }
+  }
+
+  WorkStealingExecutor(const WorkStealingExecutor&) = delete;
+  WorkStealingExecutor& operator=(const WorkStealingExecutor&) = delete;
+
+  // Runs what is still queued, then joins the workers
+  ~WorkStealingExecutor() {
+    {
+      std::lock_guard<std::mutex> lock(sleep_mutex_);
+      stopping_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  std::size_t size() const noexcept { return queues_.size(); }
+
+  void post(std::coroutine_handle<> h) {
+    const worker_slot& slot = current();
+    const std::size_t i =
+        slot.executor == this
+            ? slot.index
+            : next_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+    {
+      std::lock_guard<std::mutex> lock(queues_[i].mutex);
+      queues_[i].ready.push_back(h);
+    }
+    // Pairs with the sleeping count in work() so no wakeup is lost
+    pending_.fetch_add(1);
+    if (sleeping_.load() != 0) {
+      std::lock_guard<std::mutex> lock(sleep_mutex_);
+      wake_.notify_one();
+    }
+  }
+
+  // co_await executor.schedule() continues the coroutine on a worker
+  detail::schedule_awaiter<WorkStealingExecutor> schedule() noexcept {
+    return {this};
+  }
+
+  // Runs task on the workers and waits for its value; must not be called
+  // from one of this executor's workers
+  template <typename T>
+  T block_on(Task<T> task) {
+    detail::completion_event done;
+    drive(task, done);
+    done.wait();
+    return detail::task_access::promise(task).result();
+  }
+
+ private:
+  struct alignas(64) queue {
+    std::mutex mutex;
+    std::deque<std::coroutine_handle<> > ready;
+  };
+
+  struct worker_slot {
+    WorkStealingExecutor* executor;
+    std::size_t index;
+  };
+
+  static worker_slot& current() noexcept {
+    thread_local worker_slot slot = {nullptr, 0};
+    return slot;
+  }
+
+  template <typename T>
+  detail::detached_task drive(Task<T>& task, detail::completion_event& done) {
+    co_await schedule();
+    co_await detail::task_access::completion(task);
+    done.set();
+  }
+
+  std::coroutine_handle<> pop(std::size_t i) {
+    {
+      std::lock_guard<std::mutex> lock(queues_[i].mutex);
+      if (!queues_[i].ready.empty()) {
+        std::coroutine_handle<> h = queues_[i].ready.front();
+        queues_[i].ready.pop_front();
+        return h;
+      }
+    }
+    for (std::size_t k = 1; k < queues_.size(); ++k) {
+      queue& victim = queues_[(i + k) % queues_.size()];
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      if (!victim.ready.empty()) {
+        std::coroutine_handle<> h = victim.ready.back();
+        victim.ready.pop_back();
+        return h;
+      }
+    }
+    return nullptr;
+  }
+
+  void work(std::size_t i) {
+    current() = worker_slot{this, i};
+    for (;;) {
+      if (std::coroutine_handle<> h = pop(i)) {
+        pending_.fetch_sub(1, std::memory_order_relaxed);
+        h.resume();
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(sleep_mutex_);
+      sleeping_.fetch_add(1);
+      if (pending_.load() == 0) {
+        if (stopping_) {
+          sleeping_.fetch_sub(1);
+          return;
+        }
+        wake_.wait(lock);
+      }
+      sleeping_.fetch_sub(1);
+    }
+  }
+
+  std::vector<queue> queues_;
+  std::vector<std::thread> workers_;
+  std::atomic<std::size_t> next_{0};
+  std::atomic<std::size_t> pending_{0};
+  std::atomic<std::size_t> sleeping_{0};
+  std::mutex sleep_mutex_;
+  std::condition_variable wake_;
+  bool stopping_ = false;
+};
+
+}  // namespace rust
@@ -0,0 +1,789 @@
+/*
+ * Copyright (c) 2025 Dapeng Feng
+ * All rights reserved.
+ */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#if __has_include(<sys/uio.h>)
+#include <sys/uio.h>
+#endif
+
+#include "rustcxx.hpp"
+
+// Binary wire format for Enum, Option and Result (requires C++17).
+//
+//   Enum      one discriminant byte, then the active alternative
+//   Option    one byte (0 None, 1 Some), then the value
+//   Result    one byte (0 Ok, 1 Err), then the payload
+//   struct    the fields of ENUM_VARIANT1..7 in declaration order; empty
+//             structs take no bytes, structs marked with raw_bytes are
+//             copied as host bytes
+//   integer   fixed width, little-endian (also enums, float, double)
+//   bool      one byte, 0 or 1
+//   string    32-bit little-endian length, then the bytes
+//
+// Decoding never copies: strings come back as std::string_view into the
+// received buffer, inside view types (see view_of) that must not outlive it.
+
+namespace rust {
+namespace wire {
+
+enum class Error : unsigned char {
+  truncated,         // the input ends inside a value
+  bad_discriminant,  // a tag byte names no alternative
+  bad_value,         // a bool byte is neither 0 nor 1
+  trailing_bytes,    // decode() read a value but the input goes on
+  buffer_too_small,  // the output buffer or segment array is full
+  too_large,         // a string is longer than a 32-bit length can say
+};
+
+inline const char* to_string(Error error) noexcept {
+  switch (error) {
+    case Error::truncated:
+      return "truncated input";
+    case Error::bad_discriminant:
+      return "bad discriminant";
+    case Error::bad_value:
+      return "bad value";
+    case Error::trailing_bytes:
+      return "trailing bytes";
+    case Error::buffer_too_small:
+      return "buffer too small";
+    case Error::too_large:
+      return "string too large";
+  }
+  return "unknown wire error";
+}
+
+// One piece of a gathered encoding, laid out as struct iovec so that an
+// array of them can go straight to writev/sendmsg
+#if __has_include(<sys/uio.h>)
+typedef ::iovec segment;
+#else
+struct segment {
+  void* iov_base;
+  std::size_t iov_len;
+};
+#endif
+
+template <typename T>
+class record;
+
+// Marks a struct without ENUM_VARIANTn fields as copied as host bytes.
+// Only for structs where every byte pattern is a value: no bool, enum or
+// pointer members, which decoding could not check.
+//
+//   template <> struct rust::wire::raw_bytes<Pixel> : std::true_type {};
+template <typename T>
+struct raw_bytes : std::false_type {};
+
+namespace detail {
+
+template <typename T, typename = void>
+struct has_fields : std::false_type {};
+
+template <typename T>
+struct has_fields<T, std::void_t<decltype(std::declval<const T&>()
+                                              .rustcxx_fields())> >
+    : std::true_type {};
+
+template <typename T>
+struct is_scalar_field
+    : std::integral_constant<bool, std::is_arithmetic<T>::value ||
+                                       std::is_enum<T>::value> {};
+
+// Scalars whose only values are the bytes 0 and 1
+template <typename T, bool = std::is_enum<T>::value>
+struct holds_bool : std::is_same<T, bool> {};
+
+template <typename T>
+struct holds_bool<T, true>
+    : std::is_same<typename std::underlying_type<T>::type, bool> {};
+
+// Structs copied as host bytes
+template <typename T>
+struct is_raw_struct
+    : std::integral_constant<bool, std::is_empty<T>::value ||
+                                       (raw_bytes<T>::value &&
+                                        rust::detail::has_unique_bytes<
+                                            T>::value)> {};
+
+// Types with a codec of their own rather than a field or byte layout
+template <typename T>
+struct is_wire_builtin : std::false_type {};
+
+template <>
+struct is_wire_builtin<std::string> : std::true_type {};
+
+template <>
+struct is_wire_builtin<std::string_view> : std::true_type {};
+
+template <typename T>
+struct is_wire_builtin<Option<T> > : std::true_type {};
+
+template <typename T, typename E>
+struct is_wire_builtin<Result<T, E> > : std::true_type {};
+
+template <typename... Types>
+struct is_wire_builtin<Enum<Types...> > : std::true_type {};
+
+template <typename Fields>
+struct field_types;
+
+template <typename... Fs>
+struct field_types<std::tuple<Fs...> > {
+  typedef rust::detail::type_list<typename std::decay<Fs>::type...> type;
+};
+
+template <typename T>
+using fields_of = typename field_types<decltype(
+    std::declval<const T&>().rustcxx_fields())>::type;
+
+}  // namespace detail
+
+// Type that decoding T produces: T itself when that needs no copy,
+// std::string_view for strings, record<T> for structs with string fields
+template <typename T, typename = void>
+struct view_of {
+  static_assert(detail::is_raw_struct<T>::value,
+                "type has no wire format: use ENUM_VARIANTn, or specialize "
+                "rust::wire::raw_bytes for a struct of plain integers");
+  typedef T type;
+};
+
+template <typename T>
+using view_of_t = typename view_of<T>::type;
+
+template <typename T>
+struct view_of<T, typename std::enable_if<
+                      detail::is_scalar_field<T>::value>::type> {
+  typedef T type;
+};
+
+template <>
+struct view_of<std::string> {
+  typedef std::string_view type;
+};
+
+template <>
+struct view_of<std::string_view> {
+  typedef std::string_view type;
+};
+
+template <typename T>
+struct view_of<Option<T> > {
+  typedef Option<view_of_t<T> > type;
+};
+
+template <typename T, typename E>
+struct view_of<Result<T, E> > {
+  typedef Result<view_of_t<T>, view_of_t<E> > type;
+};
+
+template <typename... Types>
+struct view_of<Enum<Types...> > {
+  typedef Enum<view_of_t<Types>...> type;
+};
+
+namespace detail {
+
+template <typename List>
+struct views_are_values;
+
+template <typename... Fs>
+struct views_are_values<rust::detail::type_list<Fs...> >
+    : rust::detail::all_of<std::is_same<view_of_t<Fs>, Fs>::value...> {};
+
+template <typename List>
+struct view_tuple;
+
+template <typename... Fs>
+struct view_tuple<rust::detail::type_list<Fs...> > {
+  typedef std::tuple<view_of_t<Fs>...> type;
+};
+
+}  // namespace detail
+
+template <typename T>
+struct view_of<T, typename std::enable_if<detail::has_fields<T>::value>::type> {
+  typedef typename std::conditional<
+      detail::views_are_values<detail::fields_of<T> >::value, T,
+      record<T> >::type type;
+};
+
+// Decoded form of a struct with string fields: the fields by position,
+// as views into the decoded buffer
+//
+//   ENUM_VARIANT2(Send, std::uint32_t, id, std::string, data);
+//   [](const rust::wire::record<Send>& s) { s.get<1>(); }  // string_view
+template <typename T>
+class record {
+ public:
+  typedef typename detail::view_tuple<detail::fields_of<T> >::type
+      fields_type;
+
+  record() = default;
+
+  explicit record(fields_type fields) : fields_(std::move(fields)) {}
+
+  template <std::size_t I>
+  const typename std::tuple_element<I, fields_type>::type& get()
+      const noexcept {
+    return std::get<I>(fields_);
+  }
+
+  const fields_type& fields() const noexcept { return fields_; }
+
+  // Copy the fields out into an owning T
+  T to_owned() const;
+
+ private:
+  fields_type fields_;
+};
+
+namespace detail {
+
+inline bool host_is_little_endian() noexcept {
+#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__)
+  return __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__;
+#else
+  const std::uint16_t probe = 1;
+  unsigned char first;
+  std::memcpy(&first, &probe, 1);
+  return first == 1;
+#endif
+}
+
+inline void reverse_bytes(unsigned char* bytes, std::size_t n) noexcept {
+  for (std::size_t i = 0; i < n / 2; ++i) {
+    const unsigned char b = bytes[i];
+    bytes[i] = bytes[n - 1 - i];
+    bytes[n - 1 - i] = b;
+  }
+}
+
+// Writers keep the first failure and leave the rest to the caller, the
+// same way reader does
+
+// Counts the encoded size
+struct size_writer {
+  std::size_t size = 0;
+  bool failed = false;
+  Error error = Error::buffer_too_small;
+
+  void put(const void*, std::size_t n) noexcept { size += n; }
+  void put_ref(const void*, std::size_t n) noexcept { size += n; }
+
+  void fail(Error e) noexcept {
+    if (!failed) {
+      failed = true;
+      error = e;
+    }
+  }
+};
+
+// Copies into one contiguous buffer
+struct buffer_writer {
+  char* cur;
+  char* end;
+  bool failed = false;
+  Error error = Error::buffer_too_small;
+
+  void put(const void* data, std::size_t n) noexcept {
+    if (RUSTCXX_UNLIKELY(static_cast<std::size_t>(end - cur) < n)) {
+      fail(Error::buffer_too_small);
+      cur = end;
+      return;
+    }
+    std::memcpy(cur, data, n);
+    cur += n;
+  }
+
+  void put_ref(const void* data, std::size_t n) noexcept { put(data, n); }
+
+  void fail(Error e) noexcept {
+    if (!failed) {
+      failed = true;
+      error = e;
+    }
+  }
+};
+
+// Copies headers and scalars into a scratch buffer and points at string
+// bytes where they are, merging adjacent scratch pieces into one segment
+struct segment_writer {
+  char* scratch;
+  char* scratch_end;
+  segment* segments;
+  std::size_t capacity;
+  std::size_t count = 0;
+  bool failed = false;
+  Error error = Error::buffer_too_small;
+
+  void put(const void* data, std::size_t n) noexcept {
+    if (RUSTCXX_UNLIKELY(static_cast<std::size_t>(scratch_end - scratch) < n)) {
+      fail(Error::buffer_too_small);
+      return;
+    }
+    std::memcpy(scratch, data, n);
+    if (count > 0 && static_cast<char*>(segments[count - 1].iov_base) +
+                             segments[count - 1].iov_len ==
+                         scratch) {
+      segments[count - 1].iov_len += n;
+    } else {
+      append(scratch, n);
+    }
+    scratch += n;
+  }
+
+  void put_ref(const void* data, std::size_t n) noexcept {
+    if (n != 0) {
+      append(const_cast<void*>(data), n);
+    }
+  }
+
+  void append(void* data, std::size_t n) noexcept {
+    if (RUSTCXX_UNLIKELY(count == capacity)) {
+      fail(Error::buffer_too_small);
+      return;
+    }
+    segments[count].iov_base = data;
+    segments[count].iov_len = n;
+    ++count;
+  }
+
+  void fail(Error e) noexcept {
+    if (!failed) {
+      failed = true;
+      error = e;
+    }
+  }
+};
+
+// Reads from a received buffer. After the first failure every read yields
+// a value-initialized result without touching the input, so decoders can
+// run to the end and check failed once.
+struct reader {
+  const char* cur;
+  const char* end;
+  bool failed = false;
+  Error error = Error::truncated;
+
+  const char* take(std::size_t n) noexcept {
+    if (RUSTCXX_UNLIKELY(failed ||
+                         static_cast<std::size_t>(end - cur) < n)) {
+      fail(Error::truncated);
+      return nullptr;
+    }
+    const char* data = cur;
+    cur += n;
+    return data;
+  }
+
+  void fail(Error e) noexcept {
+    if (!failed) {
+      failed = true;
+      error = e;
+    }
+  }
+};
+
+template <typename T, typename = void>
+struct codec;
+
+template <typename T>
+struct codec<T, typename std::enable_if<is_scalar_field<T>::value>::type> {
+  template <typename Writer>
+  static void write(Writer& w, const T& value) noexcept {
+    unsigned char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    if (!host_is_little_endian()) {
+      reverse_bytes(bytes, sizeof(T));
+    }
+    w.put(bytes, sizeof(T));
+  }
+
+  static T read(reader& r) noexcept {
+    T value{};
+    if (const char* data = r.take(sizeof(T))) {
+      if (holds_bool<T>::value &&
+          RUSTCXX_UNLIKELY(static_cast<unsigned char>(data[0]) > 1)) {
+        r.fail(Error::bad_value);
+        return value;
+      }
+      unsigned char bytes[sizeof(T)];
+      std::memcpy(bytes, data, sizeof(T));
+      if (!host_is_little_endian()) {
+        reverse_bytes(bytes, sizeof(T));
+      }
+      std::memcpy(&value, bytes, sizeof(T));
+    }
+    return value;
+  }
+};
+
+struct string_codec {
+  template <typename Writer>
+  static void write(Writer& w, std::string_view value) noexcept {
+    if (RUSTCXX_UNLIKELY(value.size() > UINT32_MAX)) {
+      w.fail(Error::too_large);
+      return;
+    }
+    codec<std::uint32_t>::write(w, static_cast<std::uint32_t>(value.size()));
+    w.put_ref(value.data(), value.size());
+  }
+
+  static std::string_view read(reader& r) noexcept {
+    const std::uint32_t size = codec<std::uint32_t>::read(r);
+    if (const char* data = r.take(size)) {
+      return std::string_view(data, size);
+    }
+    return std::string_view();
+  }
+};
+
+template <>
+struct codec<std::string> : string_codec {};
+
+template <>
+struct codec<std::string_view> : string_codec {};
+
+template <typename T>
+struct codec<Option<T> > {
+  typedef view_of_t<Option<T> > view_type;
+
+  template <typename Writer>
+  static void write(Writer& w, const Option<T>& value) {
+    codec<std::uint8_t>::write(w, value.is_some() ? 1 : 0);
+    if (value.is_some()) {
+      codec<T>::write(w, value.unwrap_unchecked());
+    }
+  }
+
+  static view_type read(reader& r) {
+    const std::uint8_t tag = codec<std::uint8_t>::read(r);
+    if (tag == 0) {
+      return view_type::None();
+    }
+    if (RUSTCXX_UNLIKELY(tag != 1)) {
+      r.fail(Error::bad_discriminant);
+    }
+    return view_type::Some(codec<T>::read(r));
+  }
+};
+
+template <typename T, typename E>
+struct codec<Result<T, E> > {
+  typedef view_of_t<Result<T, E> > view_type;
+
+  template <typename Writer>
+  static void write(Writer& w, const Result<T, E>& value) {
+    codec<std::uint8_t>::write(w, value.is_ok() ? 0 : 1);
+    if (value.is_ok()) {
+      codec<T>::write(w, value.unwrap_unchecked());
+    } else {
+      codec<E>::write(w, value.unwrap_err_unchecked());
+    }
+  }
+
+  static view_type read(reader& r) {
+    const std::uint8_t tag = codec<std::uint8_t>::read(r);
+    if (tag == 1) {
+      return view_type::Err(codec<E>::read(r));
+    }
+    if (RUSTCXX_UNLIKELY(tag != 0)) {
+      r.fail(Error::bad_discriminant);
+    }
+    return view_type::Ok(codec<T>::read(r));
+  }
+};
+
+template <typename... Types>
+struct codec<Enum<Types...> > {
+  static_assert(sizeof...(Types) <= 256,
+                "the wire discriminant is a single byte");
+
+  typedef view_of_t<Enum<Types...> > view_type;
+
+  template <typename Writer>
+  static void write(Writer& w, const Enum<Types...>& value) {
+    codec<std::uint8_t>::write(w, static_cast<std::uint8_t>(value.index()));
+    rust::match(rust::detail::enum_access::storage(value),
+                [&w](const auto& alternative) {
+                  codec<typename std::decay<decltype(alternative)>::type>::
+                      write(w, alternative);
+                });
+  }
+
+  static view_type read(reader& r) {
+    return read(r, std::index_sequence_for<Types...>());
+  }
+
+ private:
+  template <std::size_t I>
+  static view_type read_alternative(reader& r) {
+    return view_type(
+        codec<typename rust::detail::type_at<I, Types...>::type>::read(r));
+  }
+
+  template <std::size_t... Is>
+  static view_type read(reader& r, std::index_sequence<Is...>) {
+    static view_type (*const table[])(reader&) = {&read_alternative<Is>...};
+    std::size_t index = codec<std::uint8_t>::read(r);
+    if (RUSTCXX_UNLIKELY(index >= sizeof...(Types))) {
+      r.fail(Error::bad_discriminant);
+      index = 0;
+    }
+    return table[index](r);
+  }
+};
+
+// ENUM_VARIANT1..7 structs, field by field
+template <typename T>
+struct codec<T, typename std::enable_if<has_fields<T>::value>::type> {
+  typedef view_of_t<T> view_type;
+
+  template <typename Writer>
+  static void write(Writer& w, const T& value) {
+    std::apply(
+        [&w](const auto&... fields) {
+          (codec<typename std::decay<decltype(fields)>::type>::write(w,
+                                                                     fields),
+           ...);
+        },
+        value.rustcxx_fields());
+  }
+
+  static view_type read(reader& r) { return read(r, fields_of<T>()); }
+
+ private:
+  template <typename... Fs>
+  static view_type read(reader& r, rust::detail::type_list<Fs...>) {
+    // Braced initialization reads the fields left to right
+    typename view_tuple<fields_of<T> >::type fields{codec<Fs>::read(r)...};
+    return make(std::move(fields), std::is_same<view_type, T>());
+  }
+
+  template <typename Fields>
+  static view_type make(Fields&& fields, std::false_type) {
+    return view_type(std::move(fields));
+  }
+
+  template <typename Fields>
+  static view_type make(Fields&& fields, std::true_type) {
+    T value;
+    value.rustcxx_fields() = std::move(fields);
+    return value;
+  }
+};
+
+// Empty structs take no bytes; other raw structs are copied as host bytes
+template <typename T>
+struct codec<T, typename std::enable_if<std::is_class<T>::value &&
+                                        !is_wire_builtin<T>::value &&
+                                        !has_fields<T>::value>::type> {
+  static_assert(detail::is_raw_struct<T>::value,
+                "type has no wire format: use ENUM_VARIANTn, or specialize "
+                "rust::wire::raw_bytes for a struct of plain integers");
+
+  template <typename Writer>
+  static void write(Writer& w, const T& value) noexcept {
+    if (!std::is_empty<T>::value) {
+      w.put(&value, sizeof(T));
+    }
+  }
+
+  static T read(reader& r) noexcept {
+    T value{};
+    if (!std::is_empty<T>::value) {
+      if (const char* data = r.take(sizeof(T))) {
+        std::memcpy(static_cast<void*>(&value), data, sizeof(T));
+      }
+    }
+    return value;
+  }
+};
+
+// Owning copy of a decoded view
+template <typename T, typename = void>
+struct owned {
+  static T from(const view_of_t<T>& view) { return view; }
+};
+
+template <typename T>
+struct owned<T, typename std::enable_if<
+                    !std::is_same<view_of_t<T>, T>::value &&
+                    has_fields<T>::value>::type> {
+  static T from(const record<T>& view) { return view.to_owned(); }
+};
+
+template <>
+struct owned<std::string> {
+  static std::string from(std::string_view view) {
+    return std::string(view);
+  }
+};
+
+template <typename T>
+struct owned<Option<T> > {
+  static Option<T> from(const view_of_t<Option<T> >& view) {
+    if (view.is_none()) {
+      return Option<T>::None();
+    }
+    return Option<T>::Some(owned<T>::from(view.unwrap_unchecked()));
+  }
+};
+
+template <typename T, typename E>
+struct owned<Result<T, E> > {
+  static Result<T, E> from(const view_of_t<Result<T, E> >& view) {
+    if (view.is_ok()) {
+      return Result<T, E>::Ok(owned<T>::from(view.unwrap_unchecked()));
+    }
+    return Result<T, E>::Err(owned<E>::from(view.unwrap_err_unchecked()));
+  }
+};
+
+template <typename... Types>
+struct owned<Enum<Types...> > {
+  static Enum<Types...> from(const view_of_t<Enum<Types...> >& view) {
+    return from(view, std::index_sequence_for<Types...>());
+  }
+
+  template <std::size_t I>
+  static Enum<Types...> from_alternative(
+      const view_of_t<Enum<Types...> >& view) {
+    typedef typename rust::detail::type_at<I, Types...>::type type;
+    return Enum<Types...>(
+        owned<type>::from(view.template get_unchecked<I>()));
+  }
+
+  template <std::size_t... Is>
+  static Enum<Types...> from(const view_of_t<Enum<Types...> >& view,
+                             std::index_sequence<Is...>) {
+    static Enum<Types...> (*const table[])(
+        const view_of_t<Enum<Types...> >&) = {&from_alternative<Is>...};
+    return table[view.index()](view);
+  }
+};
+
+template <typename T>
+struct owned_fields;
+
+template <typename... Fs>
+struct owned_fields<rust::detail::type_list<Fs...> > {
+  template <typename Fields, std::size_t... Is>
+  static std::tuple<Fs...> from(const Fields& fields,
+                                std::index_sequence<Is...>) {
+    return std::tuple<Fs...>(owned<Fs>::from(std::get<Is>(fields))...);
+  }
+};
+
+}  // namespace detail
+
+template <typename T>
+T record<T>::to_owned() const {
+  T value;
+  value.rustcxx_fields() =
+      detail::owned_fields<detail::fields_of<T> >::from(
+          fields_, std::make_index_sequence<std::tuple_size<fields_type>::value>());
+  return value;
+}
+
+// Bytes that encode(value) writes
+template <typename T>
+std::size_t encoded_size(const T& value) {
+  detail::size_writer w;
+  detail::codec<T>::write(w, value);
+  return w.size;
+}
+
+// Encodes into out[0, capacity) and returns the number of bytes written
+//
+//   char buffer[256];
+//   auto written = rust::wire::encode(message, buffer, sizeof(buffer));
+template <typename T>
+Result<std::size_t, Error> encode(const T& value, char* out,
+                                  std::size_t capacity) {
+  detail::buffer_writer w = {out, out + capacity};
+  detail::codec<T>::write(w, value);
+  if (RUSTCXX_UNLIKELY(w.failed)) {
+    return Result<std::size_t, Error>::Err(w.error);
+  }
+  return Result<std::size_t, Error>::Ok(static_cast<std::size_t>(w.cur - out));
+}
+
+// Appends the encoding to a byte string and returns the number of bytes
+// appended; out is left as it was on error
+template <typename T>
+Result<std::size_t, Error> encode_append(const T& value, std::string& out) {
+  detail::size_writer size;
+  detail::codec<T>::write(size, value);
+  if (RUSTCXX_UNLIKELY(size.failed)) {
+    return Result<std::size_t, Error>::Err(size.error);
+  }
+  const std::size_t offset = out.size();
+  out.resize(offset + size.size);
+  detail::buffer_writer w = {&out[offset], &out[0] + out.size()};
+  detail::codec<T>::write(w, value);
+  return Result<std::size_t, Error>::Ok(size.size);
+}
+
+// Encodes as a gather list for writev: tags, lengths and scalars go to
+// scratch, string bytes are referenced in place. Returns the number of
+// segments used; value must outlive them.
+template <typename T>
+Result<std::size_t, Error> encode_segments(const T& value, char* scratch,
+                                           std::size_t scratch_size,
+                                           segment* segments,
+                                           std::size_t max_segments) {
+  detail::segment_writer w = {scratch, scratch + scratch_size, segments,
+                              max_segments};
+  detail::codec<T>::write(w, value);
+  if (RUSTCXX_UNLIKELY(w.failed)) {
+    return Result<std::size_t, Error>::Err(w.error);
+  }
+  return Result<std::size_t, Error>::Ok(w.count);
+}
+
+// Decodes one T from the front of input and advances input past it
+template <typename T>
+Result<view_of_t<T>, Error> decode_prefix(std::string_view& input) {
+  detail::reader r = {input.data(), input.data() + input.size()};
+  view_of_t<T> value = detail::codec<T>::read(r);
+  if (RUSTCXX_UNLIKELY(r.failed)) {
+    return Result<view_of_t<T>, Error>::Err(r.error);
+  }
+  input.remove_prefix(static_cast<std::size_t>(r.cur - input.data()));
+  return Result<view_of_t<T>, Error>::Ok(std::move(value));
+}
+
+// Decodes exactly one T from input; views point into input
+//
+//   auto message = rust::wire::decode<NetworkMessage>(received);
+template <typename T>
+Result<view_of_t<T>, Error> decode(std::string_view input) {
+  Result<view_of_t<T>, Error> value = decode_prefix<T>(input);
+  if (value.is_ok() && RUSTCXX_UNLIKELY(!input.empty())) {
+    return Result<view_of_t<T>, Error>::Err(Error::trailing_bytes);
+  }
+  return value;
+}
+
+// Owning copy of a decoded view, e.g. to keep a message past its buffer
+template <typename T>
+T to_owned(const view_of_t<T>& view) {
+  return detail::owned<T>::from(view);
+}
+
+}  // namespace wire
+}  // namespace rust
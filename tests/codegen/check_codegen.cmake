@@ -0,0 +1,54 @@
+# Checks the hot path of functions in an assembly listing.
+#
+#   cmake -DASM=<file.s> -DCHECKS=<name:max_instructions:max_compares;...>
+#         -P check_codegen.cmake
+#
+# The hot path runs from the function label to the next non-local label
+# (GCC moves unlikely blocks to <name>.cold) or the end of the function.
+
+file(STRINGS "${ASM}" lines)
+
+set(failed FALSE)
+foreach(check IN LISTS CHECKS)
+  string(REPLACE ":" ";" fields "${check}")
+  list(GET fields 0 name)
+  list(GET fields 1 max_instructions)
+  list(GET fields 2 max_compares)
+
+  set(inside FALSE)
+  set(found FALSE)
+  set(instructions 0)
+  set(compares 0)
+  foreach(line IN LISTS lines)
+    if(line MATCHES "^_?${name}:")
+      set(inside TRUE)
+      set(found TRUE)
+    elseif(inside)
+      if(line MATCHES "^[A-Za-z_][^ \t]*:" OR line MATCHES "^[ \t]*\\.(size|cfi_endproc)")
+        break()
+      endif()
+      if(line MATCHES "^[ \t]+([a-z][a-z0-9.]*)")
+        set(mnemonic "${CMAKE_MATCH_1}")
+        math(EXPR instructions "${instructions} + 1")
+        if(mnemonic MATCHES "^(cmp|test|tst|cbz|cbnz)")
+          math(EXPR compares "${compares} + 1")
+        endif()
+      endif()
+    endif()
+  endforeach()
+
+  if(NOT found)
+    message(SEND_ERROR "${name}: not found in ${ASM}")
+    set(failed TRUE)
+  elseif(instructions GREATER max_instructions OR compares GREATER max_compares)
+    message(SEND_ERROR "${name}: ${instructions} instructions, ${compares} compares "
+                       "(limit ${max_instructions}, ${max_compares})")
+    set(failed TRUE)
+  else()
+    message(STATUS "${name}: ${instructions} instructions, ${compares} compares")
+  endif()
+endforeach()
+
+if(failed)
+  message(FATAL_ERROR "codegen check failed")
+endif()
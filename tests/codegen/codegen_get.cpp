@@ -0,0 +1,37 @@
+/*
+ * Copyright (c) 2025 Dapeng Feng
+ * All rights reserved.
+ */
+
+// Compiled to assembly at -O2 and checked by check_codegen.cmake: each
+// accessor must load the index at most once and branch at most once.
+
+#include <string>
+
+#include "rustcxx.hpp"
+
+struct Send {
+  std::string data;
+};
+
+struct Close {};
+
+typedef rust::Enum<int, Send, Close> Message;
+
+extern "C" {
+
+int* codegen_get_if(Message& message) { return message.get_if<int>(); }
+
+int& codegen_get_type(Message& message) { return message.get<int>(); }
+
+int& codegen_get_index(Message& message) { return message.get<0>(); }
+
+int& codegen_get_unchecked_type(Message& message) {
+  return message.get_unchecked<int>();
+}
+
+Send& codegen_get_unchecked_index(Message& message) {
+  return message.get_unchecked<1>();
+}
+
+}  // extern "C"
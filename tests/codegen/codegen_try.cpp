@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2025 Dapeng Feng
+ * All rights reserved.
+ */
+
+// Compiled to assembly at -O2 and checked by check_codegen.cmake: `?`
+// must branch once on the discriminant, like checking an error code.
+
+#include "rustcxx.hpp"
+
+enum class Errc : unsigned char { invalid = 1 };
+
+struct Failure {
+  Failure(Errc e) : code(static_cast<int>(e)) {}  // NOLINT
+  int code;
+};
+
+typedef rust::Result<int, Errc> Parsed;
+typedef rust::Result<int, Failure> Checked;
+
+extern "C" {
+
+Checked codegen_try(Parsed* parsed) {
+  const int value = RUSTCXX_TRY(std::move(*parsed));
+  return Checked::Ok(value + 1);
+}
+
+Checked codegen_try_assign(Parsed* parsed) {
+  RUSTCXX_TRY_ASSIGN(const int value, std::move(*parsed));
+  return Checked::Ok(value + 1);
+}
+
+// The same with an error code, for comparison
+int codegen_error_code(const int* status, const int* value, int* out) {
+  if (*status != 0) {
+    return *status;
+  }
+  *out = *value + 1;
+  return 0;
+}
+
+}  // extern "C"
@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2025 Dapeng Feng
+ * All rights reserved.
+ */
+
+// Built once per language standard (C++11/14/17/20) by the
+// rustcxx_standard_matrix target: the core API must compile and behave the
+// same everywhere, and tag-only matches must fold at compile time wherever
+// RUSTCXX_HAS_CONSTEXPR_MATCH is set. Uses no generic lambdas so that C++11 can build it.
+// The C++17/20 builds run again in slim mode (RUSTCXX_CONFIG_SLIM=1).
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "rustcxx.hpp"
+#include "rustcxx_algorithm.hpp"
+
+#define CHECK(condition)                                            \
+  do {                                                              \
+    if (!(condition)) {                                             \
+      std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__,   \
+                   __LINE__, #condition);                           \
+      return 1;                                                     \
+    }                                                               \
+  } while (0)
+
+namespace {
+
+ENUM_VARIANT0(North);
+ENUM_VARIANT0(East);
+ENUM_VARIANT0(South);
+ENUM_VARIANT0(West);
+
+typedef rust::Enum<North, East, South, West> Direction;
+
+// Bytewise equality before C++20, defaulted from C++20 on
+ENUM_VARIANT(Level, int value);
+ENUM_VARIANT2(Span, int, begin, int, end);
+ENUM_VARIANT(Padded, char tag; int value);  // NOLINT
+
+ENUM_VARIANT(Message, std::string text);  // NOLINT
+
+static_assert(!rust::detail::has_unique_bytes<Padded>::value,
+              "padded fields never compare as bytes");
+static_assert(rust::detail::is_hashable<rust::Enum<Level, Span> >::value,
+              "byte-hashed variants without padding are hashable");
+static_assert(!rust::detail::is_hashable<rust::Enum<Level, Padded> >::value &&
+                  !rust::detail::is_hashable<rust::Enum<Message> >::value,
+              "padded or non-trivial declared fields disable std::hash");
+static_assert(!std::is_default_constructible<
+                  std::hash<rust::Option<rust::Enum<Message> > > >::value,
+              "a disabled std::hash cannot be constructed");
+
+struct Degrees {
+  constexpr int operator()(North) const { return 0; }
+  constexpr int operator()(East) const { return 90; }
+  constexpr int operator()(South) const { return 180; }
+  constexpr int operator()(West) const { return 270; }
+};
+
+struct Text {
+  std::string value;
+};
+
+typedef rust::Enum<int, Text> Token;
+
+struct Length {
+  std::size_t operator()(int) const { return 1; }
+  std::size_t operator()(const Text& text) const { return text.value.size(); }
+};
+
+int twice(int value) { return value * 2; }
+
+rust::Result<int> parse(const std::string& text) {
+  if (text.empty()) {
+    return rust::Result<int>::Err("empty");
+  }
+  return rust::Result<int>::Ok(static_cast<int>(text.size()));
+}
+
+// Both forms of `?`; the statement expression builds under -Wpedantic
+rust::Result<int> twice_parsed(const std::string& text) {
+  RUSTCXX_TRY_ASSIGN(const int value, parse(text));
+  return rust::Result<int>::Ok(twice(value));
+}
+
+#if RUSTCXX_HAS_TRY_EXPRESSION
+rust::Result<int> sum_parsed(const std::string& a, const std::string& b) {
+  return rust::Result<int>::Ok(RUSTCXX_TRY(parse(a)) + RUSTCXX_TRY(parse(b)));
+}
+#endif
+
+#if RUSTCXX_HAS_CONSTEXPR_MATCH
+// Tag-only Enums are literal types and match at compile time
+static_assert(rust::match(Direction(South()), Degrees()) == 180,
+              "constexpr rust::match");
+static_assert(Direction(West()).match(Degrees()) == 270,
+              "constexpr Enum::match");
+static_assert(sizeof(Direction) == 1, "tag-only Enum is its discriminant");
+#endif
+
+#if RUSTCXX_HAS_CONSTEXPR_MATCH && RUSTCXX_CPP17_OR_GREATER
+static_assert(Direction(East()).match(rust::overloads{
+                  [](North) { return 'N'; }, [](East) { return 'E'; },
+                  [](South) { return 'S'; }, [](West) { return 'W'; }}) == 'E',
+              "constexpr lambdas through overloads");
+#endif
+
+}  // namespace
+
+int main() {
+  Direction direction = East();
+  CHECK(direction.match(Degrees()) == 90);
+  CHECK(rust::match(direction, Degrees()) == 90);
+
+  Text text = {"hello"};
+  Token token = text;
+  CHECK(token.match(Length()) == 5u);
+  CHECK(rust::match(token, rust::make_overloads(
+                               [](int) { return false; },
+                               [](const Text&) { return true; })));
+  token = 7;
+  CHECK(token.is<int>() && token.get<int>() == 7);
+
+  rust::Result<int> ok = parse("four");
+  CHECK(ok.is_ok() && ok.map(twice).unwrap() == 8);
+  CHECK(parse("").is_err() && parse("").unwrap_err() == "empty");
+
+  CHECK(twice_parsed("abc").unwrap() == 6);
+  CHECK(twice_parsed("").unwrap_err() == "empty");
+#if RUSTCXX_HAS_TRY_EXPRESSION
+  CHECK(sum_parsed("ab", "c").unwrap() == 3);
+  CHECK(sum_parsed("ab", "").unwrap_err() == "empty");
+#endif
+
+  rust::Option<int> some = rust::Option<int>::Some(3);
+  CHECK(some.map(twice).unwrap_or(0) == 6);
+
+  typedef rust::Enum<Level, Span> Mark;
+  CHECK(Mark(Level{1}) == Mark(Level{1}) && Mark(Level{1}) != Mark(Level{2}));
+  CHECK(Mark(Span(1, 2)) != Mark(Span(1, 3)));
+  CHECK(std::hash<Mark>()(Mark(Span(1, 2))) ==
+        std::hash<Mark>()(Mark(Span(1, 2))));
+  CHECK(std::hash<rust::Option<int> >()(some) ==
+        std::hash<rust::Option<int> >()(rust::Option<int>::Some(3)));
+
+  // Discriminant scans of rustcxx_algorithm.hpp
+  std::vector<Direction> directions(20, Direction(North()));
+  directions[3] = West();
+  directions[17] = West();
+  CHECK(rust::count_of<West>(directions) == 2u);
+
+  std::vector<rust::Result<int, int> > checked(
+      9, rust::Result<int, int>::Ok(1));
+  checked[6] = rust::Result<int, int>::Err(2);
+  CHECK(rust::find_first_err(checked) - checked.begin() == 6);
+
+  std::vector<rust::Option<Direction> > maybe(
+      18, rust::Option<Direction>::None());
+  maybe[2] = rust::Option<Direction>::Some(Direction(South()));
+  maybe[16] = rust::Option<Direction>::Some(Direction(East()));
+  const std::vector<Direction> present = rust::compress_some(maybe);
+  CHECK(present.size() == 2u && present[1].is<East>());
+
+  std::printf("rustcxx C++%ld OK\n", static_cast<long>(__cplusplus / 100 % 100));
+  return 0;
+}
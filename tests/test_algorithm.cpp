@@ -0,0 +1,345 @@
+/*
+ * Copyright (c) 2025 Dapeng Feng
+ * All rights reserved.
+ */
+
+#include <gtest/gtest.h>
+
+#include <list>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rustcxx_algorithm.hpp"
+
+using namespace rust;  // NOLINT
+
+namespace {
+
+ENUM_VARIANT(Tick, int step);            // NOLINT
+ENUM_VARIANT(Log, std::string line);     // NOLINT
+ENUM_VARIANT(Stop);
+
+using Event = Enum<Tick, Log, Stop>;
+
+ENUM_VARIANT(Red);
+ENUM_VARIANT(Amber);
+ENUM_VARIANT(Green);
+
+using Light = Enum<Red, Amber, Green>;     // one byte per element
+using Reading = Enum<int, short, Amber>;   // eight bytes per element
+
+// Payload that counts how often it is copied
+struct Record {
+  static int copies;
+
+  int id;
+
+  explicit Record(int i) : id(i) {}
+  Record(const Record& other) : id(other.id) { ++copies; }
+  Record(Record&& other) noexcept : id(other.id) {}
+  Record& operator=(const Record&) = default;
+  Record& operator=(Record&&) = default;
+};
+
+int Record::copies = 0;
+
+Result<int> parse(const std::string& text) {
+  if (text.empty() ||
+      text.find_first_not_of("0123456789") != std::string::npos) {
+    return Result<int>::Err("not a number: " + text);
+  }
+  return Result<int>::Ok(std::stoi(text));
+}
+
+// Pseudo-random index in [0, n)
+std::size_t next_index(unsigned& state, std::size_t n) {
+  state = state * 1103515245u + 12345u;
+  return (state >> 16) % n;
+}
+
+std::vector<Event> make_events() {
+  std::vector<Event> events;
+  events.push_back(Tick{1});
+  events.push_back(Log{"a"});
+  events.push_back(Tick{2});
+  events.push_back(Stop{});
+  events.push_back(Log{"b"});
+  events.push_back(Log{"c"});
+  events.push_back(Tick{3});
+  return events;
+}
+
+}  // namespace
+
+class AlgorithmTest : public ::testing::Test {
+ protected:
+  void SetUp() override {}
+  void TearDown() override {}
+};
+
+TEST_F(AlgorithmTest, MatchAllGroupsByAlternative) {
+  const std::vector<Event> events = make_events();
+  std::string trace;
+
+  match_all(events,
+            [&](const Tick& t) { trace += "t" + std::to_string(t.step); },
+            [&](const Log& l) { trace += "l" + l.line; },
+            [&](const Stop&) { trace += "s"; });
+
+  EXPECT_EQ(trace, "t1t2t3lalblcs");
+}
+
+TEST_F(AlgorithmTest, MatchAllMutates) {
+  std::vector<Event> events = make_events();
+
+  match_all(events, [](Tick& t) { t.step *= 10; }, [](Log& l) { l.line += "!"; },
+            [](Stop&) {});
+
+  EXPECT_EQ(events[0].get<Tick>().step, 10);
+  EXPECT_EQ(events[6].get<Tick>().step, 30);
+  EXPECT_EQ(events[5].get<Log>().line, "c!");
+}
+
+TEST_F(AlgorithmTest, MatchAllStatefulVisitor) {
+  struct Totals {
+    int steps = 0;
+    int logs = 0;
+    void operator()(const Tick& t) { steps += t.step; }
+    void operator()(const Log&) { ++logs; }
+    void operator()(const Stop&) {}
+  };
+
+  const std::vector<Event> events = make_events();
+  Totals totals;
+  match_all(events, totals);
+
+  EXPECT_EQ(totals.steps, 6);
+  EXPECT_EQ(totals.logs, 3);
+}
+
+TEST_F(AlgorithmTest, MatchAllNested) {
+  const std::vector<Event> events = make_events();
+  std::string trace;
+
+  // The inner call runs while the outer one holds its sorted addresses
+  for (int round = 0; round < 2; ++round) {
+    match_all(
+        events, [&](const Tick& t) { trace += "t" + std::to_string(t.step); },
+        [&](const Log& l) {
+          match_all(events, [](const Tick&) {}, [](const Log&) {},
+                    [](const Stop&) {});
+          trace += "l" + l.line;
+        },
+        [&](const Stop&) { trace += "s"; });
+  }
+
+  EXPECT_EQ(trace, "t1t2t3lalblcst1t2t3lalblcs");
+}
+
+TEST_F(AlgorithmTest, MatchAllPreservingOrder) {
+  const std::vector<Event> events = make_events();
+  std::string trace;
+
+  match_all(preserve_order, events,
+            [&](const Tick& t) { trace += "t" + std::to_string(t.step); },
+            [&](const Log& l) { trace += "l" + l.line; },
+            [&](const Stop&) { trace += "s"; });
+
+  EXPECT_EQ(trace, "t1lat2slblct3");
+}
+
+TEST_F(AlgorithmTest, MatchAllEmptyRange) {
+  std::vector<Event> events;
+  int calls = 0;
+
+  match_all(events, [&](const auto&) { ++calls; });
+  match_all(preserve_order, events, [&](const auto&) { ++calls; });
+
+  EXPECT_EQ(calls, 0);
+}
+
+TEST_F(AlgorithmTest, CollectResults) {
+  std::vector<Result<Record>> records;
+  for (int i = 0; i < 4; ++i) {
+    records.push_back(Result<Record>::Ok(Record(i)));
+  }
+
+  Record::copies = 0;
+  Result<std::vector<Record>> collected = collect(std::move(records));
+  ASSERT_TRUE(collected.is_ok());
+  EXPECT_EQ(collected.unwrap().size(), 4u);
+  EXPECT_EQ(collected.unwrap()[3].id, 3);
+  EXPECT_EQ(Record::copies, 0) << "an rvalue range moves its payloads";
+
+  std::vector<Result<int>> mixed;
+  mixed.push_back(Result<int>::Ok(1));
+  mixed.push_back(Result<int>::Err("first"));
+  mixed.push_back(Result<int>::Err("second"));
+  Result<std::vector<int>> failed = collect(mixed);
+  ASSERT_TRUE(failed.is_err());
+  EXPECT_EQ(failed.unwrap_err(), "first");
+  EXPECT_EQ(mixed[1].unwrap_err(), "first") << "an lvalue range is copied";
+}
+
+TEST_F(AlgorithmTest, CollectOptions) {
+  std::list<Option<int>> some;
+  some.push_back(Option<int>::Some(1));
+  some.push_back(Option<int>::Some(2));
+
+  Option<std::vector<int>> all = collect(some);
+  ASSERT_TRUE(all.is_some());
+  EXPECT_EQ(all.unwrap(), (std::vector<int>{1, 2}));
+
+  some.push_back(Option<int>::None());
+  EXPECT_TRUE(collect(some).is_none());
+}
+
+TEST_F(AlgorithmTest, PartitionResults) {
+  std::vector<Result<int>> results;
+  results.push_back(Result<int>::Ok(1));
+  results.push_back(Result<int>::Err("a"));
+  results.push_back(Result<int>::Ok(2));
+  results.push_back(Result<int>::Err("b"));
+
+  std::pair<std::vector<int>, std::vector<std::string>> parts =
+      partition_results(std::move(results));
+
+  EXPECT_EQ(parts.first, (std::vector<int>{1, 2}));
+  EXPECT_EQ(parts.second, (std::vector<std::string>{"a", "b"}));
+  EXPECT_EQ(parts.first.capacity(), 2u);
+}
+
+TEST_F(AlgorithmTest, TryFold) {
+  const std::vector<std::string> good = {"1", "20", "300"};
+  const std::vector<std::string> bad = {"1", "x", "y"};
+  int calls = 0;
+
+  auto add = [&](int sum, const std::string& text) {
+    ++calls;
+    return parse(text).map([&](int value) { return sum + value; });
+  };
+
+  Result<int> total = try_fold(good, 0, add);
+  ASSERT_TRUE(total.is_ok());
+  EXPECT_EQ(total.unwrap(), 321);
+
+  calls = 0;
+  Result<int> stopped = try_fold(bad, 0, add);
+  ASSERT_TRUE(stopped.is_err());
+  EXPECT_EQ(stopped.unwrap_err(), "not a number: x");
+  EXPECT_EQ(calls, 2) << "folding stops at the first Err";
+
+  Option<int> product = try_fold(good, 1, [](int acc, const std::string& s) {
+    return s.size() < 3 ? Option<int>::Some(acc * static_cast<int>(s.size()))
+                        : Option<int>::None();
+  });
+  EXPECT_TRUE(product.is_none());
+}
+
+TEST_F(AlgorithmTest, DiscriminantOffsetMatchesStorage) {
+  const Reading reading = short(3);
+  const Result<int, int> err = Result<int, int>::Err(1);
+  const Event event = Stop{};
+  const Option<Light> none = Option<Light>::None();
+
+  auto tag = [](const void* object, std::size_t offset) {
+    return static_cast<const unsigned char*>(object)[offset];
+  };
+  EXPECT_EQ(tag(&reading, layout_of<Reading>::discriminant_offset), 1);
+  EXPECT_EQ(tag(&err, layout_of<Result<int, int>>::discriminant_offset), 1);
+  EXPECT_EQ(tag(&event, layout_of<Event>::discriminant_offset), 2);
+  static_assert(sizeof(Option<Light>) == sizeof(Light), "niche Option");
+  EXPECT_EQ(tag(&none, layout_of<Light>::discriminant_offset), 3);
+}
+
+TEST_F(AlgorithmTest, CountOf) {
+  unsigned state = 7;
+  for (std::size_t size : {0, 1, 15, 16, 17, 33, 100, 1000}) {
+    std::vector<Light> lights;
+    std::vector<Reading> readings;
+    std::list<Light> listed;
+    std::size_t greens = 0;
+    std::size_t shorts = 0;
+    for (std::size_t i = 0; i < size; ++i) {
+      const std::size_t index = next_index(state, 3);
+      greens += index == 2;
+      shorts += index == 1;
+      lights.push_back(index == 0 ? Light(Red{})
+                                  : index == 1 ? Light(Amber{}) : Light(Green{}));
+      readings.push_back(index == 0 ? Reading(int(i))
+                                    : index == 1 ? Reading(short(i))
+                                                 : Reading(Amber{}));
+      listed.push_back(lights.back());
+    }
+    EXPECT_EQ(count_of<Green>(lights), greens) << size;
+    EXPECT_EQ(count_of<short>(readings), shorts) << size;
+    EXPECT_EQ(count_of<Green>(listed), greens) << size;
+  }
+
+  const std::vector<Event> events = make_events();
+  EXPECT_EQ(count_of<Log>(events), 3u);
+
+  const Light array[] = {Green{}, Red{}, Green{}};
+  EXPECT_EQ(count_of<Green>(array), 2u);
+}
+
+TEST_F(AlgorithmTest, FindFirstErr) {
+  typedef Result<int, int> Checked;
+  for (std::size_t size : {0, 1, 7, 8, 9, 40}) {
+    for (std::size_t err = 0; err <= size; ++err) {
+      std::vector<Checked> results;
+      for (std::size_t i = 0; i < size; ++i) {
+        results.push_back(i < err ? Checked::Ok(int(i)) : Checked::Err(int(i)));
+      }
+      EXPECT_EQ(find_first_err(results) - results.begin(),
+                static_cast<std::ptrdiff_t>(err))
+          << size;
+    }
+  }
+
+  std::list<Result<int>> listed;
+  listed.push_back(Result<int>::Ok(1));
+  listed.push_back(Result<int>::Err("bad"));
+  EXPECT_EQ(find_first_err(listed)->unwrap_err(), "bad");
+}
+
+TEST_F(AlgorithmTest, CompressSome) {
+  unsigned state = 11;
+  std::vector<Option<Light>> lights;
+  std::vector<std::size_t> expected;
+  for (std::size_t i = 0; i < 77; ++i) {
+    const std::size_t index = next_index(state, 4);
+    if (index == 3) {
+      lights.push_back(Option<Light>::None());
+    } else {
+      lights.push_back(Option<Light>::Some(
+          index == 0 ? Light(Red{}) : index == 1 ? Light(Amber{})
+                                                 : Light(Green{})));
+      expected.push_back(index);
+    }
+  }
+  std::vector<std::size_t> indices;
+  for (const Light& light : compress_some(lights)) {
+    indices.push_back(light.index());
+  }
+  EXPECT_EQ(indices, expected);
+
+  std::vector<Option<Record>> records;
+  records.push_back(Option<Record>::Some(Record(1)));
+  records.push_back(Option<Record>::None());
+  records.push_back(Option<Record>::Some(Record(3)));
+  Record::copies = 0;
+  std::vector<Record> kept = compress_some(std::move(records));
+  ASSERT_EQ(kept.size(), 2u);
+  EXPECT_EQ(kept[1].id, 3);
+  EXPECT_EQ(Record::copies, 0) << "an rvalue range moves its payloads";
+}
+
+TEST_F(AlgorithmTest, CountOfEnumVec) {
+  EnumVec<Red, Amber, Green> lights;
+  lights.push_back(Green{});
+  lights.push_back(Red{});
+  lights.push_back(Green{});
+  EXPECT_EQ(count_of<Green>(lights), 2u);
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2025 Dapeng Feng
+ * All rights reserved.
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rustcxx_atomic.hpp"
+
+using namespace rust;  // NOLINT
+
+namespace {
+
+struct Completion {
+  std::uint16_t code;
+  std::uint8_t shard;
+  std::uint8_t flags;
+};
+
+// Trivially copyable but not default constructible
+class Ticket {
+ public:
+  explicit Ticket(std::uint32_t id) : id_(id) {}
+
+  std::uint32_t id() const { return id_; }
+
+ private:
+  std::uint32_t id_;
+};
+
+}  // namespace
+
+class AtomicTest : public ::testing::Test {
+ protected:
+  void SetUp() override {}
+  void TearDown() override {}
+};
+
+TEST_F(AtomicTest, InlineWord) {
+  static_assert(AtomicOption<int>::is_always_inline, "");
+  static_assert(AtomicOption<Completion>::is_always_inline, "");
+  static_assert(!AtomicOption<std::uint64_t>::is_always_inline,
+                "no room left for the presence flag");
+  static_assert(!AtomicOption<std::string>::is_always_inline, "");
+
+  AtomicOption<int> slot;
+  EXPECT_TRUE(slot.is_none());
+  EXPECT_TRUE(slot.replace(0).is_none());
+  EXPECT_TRUE(slot.is_some()) << "a zero payload is still Some";
+  EXPECT_EQ(slot.replace(-1).unwrap(), 0);
+  EXPECT_FALSE(slot.compare_and_take(5));
+  EXPECT_TRUE(slot.compare_and_take(-1));
+  EXPECT_TRUE(slot.take().is_none());
+
+  AtomicOption<Completion> done(Completion{404, 3, 1});
+  const Completion c = done.take().unwrap();
+  EXPECT_EQ(c.code, 404);
+  EXPECT_EQ(c.shard, 3);
+  EXPECT_EQ(c.flags, 1);
+}
+
+TEST_F(AtomicTest, InlineWordWithoutDefaultConstructor) {
+  static_assert(AtomicOption<Ticket>::is_always_inline, "");
+
+  AtomicOption<Ticket> slot;
+  EXPECT_TRUE(slot.replace(Ticket(7)).is_none());
+  EXPECT_EQ(slot.replace(Ticket(9)).unwrap().id(), 7u);
+  EXPECT_EQ(slot.take().unwrap().id(), 9u);
+  EXPECT_TRUE(slot.take().is_none());
+}
+
+TEST_F(AtomicTest, BoxedValues) {
+  AtomicOption<std::string> slot(std::string("first"));
+  EXPECT_EQ(slot.replace("second").unwrap(), "first");
+  EXPECT_EQ(slot.take().unwrap(), "second");
+  EXPECT_TRUE(slot.is_none());
+  slot.replace("dropped with the slot");
+}
+
+TEST_F(AtomicTest, ConcurrentHandoff) {
+  const int writers = 4;
+  const int per_writer = 20000;
+  AtomicOption<int> slot;
+  std::atomic<long long> taken_sum(0);
+  std::atomic<bool> done(false);
+
+  std::thread reader([&] {
+    for (;;) {
+      const bool finished = done.load();
+      Option<int> v = slot.take();
+      if (v.is_some()) {
+        taken_sum += v.unwrap();
+      } else if (finished) {
+        return;
+      }
+    }
+  });
+
+  std::vector<std::thread> threads;
+  std::atomic<long long> displaced_sum(0);
+  for (int w = 0; w < writers; ++w) {
+    threads.emplace_back([&] {
+      for (int i = 1; i <= per_writer; ++i) {
+        Option<int> old = slot.replace(i);
+        if (old.is_some()) {
+          displaced_sum += old.unwrap();
+        }
+      }
+    });
+  }
+  for (std::size_t i = 0; i < threads.size(); ++i) {
+    threads[i].join();
+  }
+  done.store(true);
+  reader.join();
+
+  // Every value written is either taken or displaced exactly once
+  const long long written =
+      static_cast<long long>(writers) * per_writer * (per_writer + 1) / 2;
+  EXPECT_EQ(taken_sum.load() + displaced_sum.load(), written);
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2025 Dapeng Feng
+ * All rights reserved.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "rustcxx_channel.hpp"
+
+using namespace rust;  // NOLINT
+
+namespace {
+
+ENUM_VARIANT2(Send, int, producer, int, sequence);
+ENUM_VARIANT1(Log, std::string, text);
+ENUM_VARIANT0(Stop);
+
+typedef Enum<Send, Log, Stop> Message;
+
+// Payload that counts live instances
+struct Counted {
+  static int live;
+
+  Counted() { ++live; }
+  Counted(const Counted&) { ++live; }
+  Counted(Counted&&) noexcept { ++live; }
+  ~Counted() { --live; }
+};
+
+int Counted::live = 0;
+
+}  // namespace
+
+class ChannelTest : public ::testing::Test {
+ protected:
+  void SetUp() override { Counted::live = 0; }
+  void TearDown() override {}
+};
+
+TEST_F(ChannelTest, SendAndReceiveInOrder) {
+  auto ch = mpsc::channel<Message>(8);
+  EXPECT_EQ(ch.first.capacity(), 8u);
+  EXPECT_TRUE(ch.first.send(Message(Log{"hello"})));
+  EXPECT_TRUE(ch.first.send(Message(Send(0, 1))));
+
+  Message first = ch.second.recv().unwrap();
+  EXPECT_EQ(first.get<Log>().text, "hello");
+  EXPECT_TRUE(ch.second.recv().unwrap().is<Send>());
+  EXPECT_EQ(ch.second.try_recv().unwrap_err(), mpsc::TryRecvError::empty);
+}
+
+TEST_F(ChannelTest, BoundedTrySend) {
+  auto ch = mpsc::channel<int>(2);
+  int value = 1;
+  EXPECT_EQ(ch.first.try_send(std::move(value)), mpsc::TrySend::sent);
+  EXPECT_EQ(ch.first.try_send(2), mpsc::TrySend::sent);
+  EXPECT_EQ(ch.first.try_send(3), mpsc::TrySend::full);
+  EXPECT_EQ(ch.second.try_recv().unwrap(), 1);
+  EXPECT_EQ(ch.first.try_send(3), mpsc::TrySend::sent);
+}
+
+TEST_F(ChannelTest, DisconnectWhenSendersDrop) {
+  auto ch = mpsc::channel<int>(4);
+  mpsc::Receiver<int> rx = std::move(ch.second);
+  {
+    mpsc::Sender<int> tx = std::move(ch.first);
+    mpsc::Sender<int> copy = tx;
+    EXPECT_TRUE(copy.send(7));
+  }
+  EXPECT_EQ(rx.recv().unwrap(), 7);
+  EXPECT_EQ(rx.recv().unwrap_err(), mpsc::RecvError::disconnected);
+  EXPECT_EQ(rx.try_recv().unwrap_err(), mpsc::TryRecvError::disconnected);
+}
+
+TEST_F(ChannelTest, SendFailsWithoutReceiver) {
+  auto ch = mpsc::channel<std::string>(4);
+  { mpsc::Receiver<std::string> rx = std::move(ch.second); }
+  std::string text = "kept";
+  EXPECT_FALSE(ch.first.send(std::move(text)));
+  EXPECT_EQ(text, "kept");
+  EXPECT_EQ(ch.first.try_send(std::string("x")), mpsc::TrySend::disconnected);
+}
+
+TEST_F(ChannelTest, QueuedMessagesAreDestroyed) {
+  {
+    auto ch = mpsc::channel<Counted>(4);
+    ch.first.send(Counted());
+    ch.first.send(Counted());
+    EXPECT_EQ(Counted::live, 2);
+  }
+  EXPECT_EQ(Counted::live, 0);
+}
+
+TEST_F(ChannelTest, ManyProducersBlockingOnSmallRing) {
+  const int producers = 4;
+  const int per_producer = 5000;
+  auto ch = mpsc::channel<Message>(16);
+
+  std::vector<std::thread> threads;
+  for (int p = 0; p < producers; ++p) {
+    mpsc::Sender<Message> tx = ch.first;
+    threads.emplace_back([tx, p, per_producer]() mutable {
+      for (int i = 0; i < per_producer; ++i) {
+        tx.send(Message(Send(p, i)));
+      }
+    });
+  }
+  { mpsc::Sender<Message> last = std::move(ch.first); }
+
+  std::vector<int> next(producers, 0);
+  std::size_t received = 0;
+  bool ordered = true;
+  const auto on_message = [&](Message&& m) {
+    const Send& s = m.get<Send>();
+    ordered = ordered && s.sequence == next[s.producer];
+    ++next[s.producer];
+    ++received;
+  };
+  for (;;) {
+    if (ch.second.try_recv_many(on_message, 8) != 0) {
+      continue;
+    }
+    Result<Message, mpsc::RecvError> m = ch.second.recv();
+    if (m.is_err()) {
+      break;
+    }
+    on_message(std::move(m).unwrap());
+  }
+  for (std::size_t i = 0; i < threads.size(); ++i) {
+    threads[i].join();
+  }
+
+  EXPECT_TRUE(ordered) << "each producer's messages arrive in order";
+  EXPECT_EQ(received, static_cast<std::size_t>(producers * per_producer));
+}
@@ -5,9 +5,15 @@
 
 #include <gtest/gtest.h>
 
+#include <memory>
+#include <stdexcept>
 #include <string>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
-#include "rustcxx/rustcxx.hpp"
+#include "rustcxx.hpp"
 
 using namespace rust;  // NOLINT
 
@@ -134,3 +140,345 @@ TEST_F(EnumTest, Index) {
   EXPECT_NE(green.index(), blue.index());
   EXPECT_NE(red.index(), blue.index());
 }
+
+TEST_F(EnumTest, MatchSingleAlternative) {
+  using Single = Enum<Blue>;
+  Single single = Blue{7};
+
+  auto result = single.match([](const Blue& b) { return b.intensity; });
+
+  EXPECT_EQ(result, 7);
+}
+
+TEST_F(EnumTest, MatchEveryAlternative) {
+  const auto& visitor = overloads{
+      [](const TextMessage& m) { return m.data; },
+      [](const NumberMessage& m) { return m.value; },
+      [](const EmptyMessage&) { return -1; },
+  };
+
+  Message text_msg = TextMessage{"text", 1};
+  Message num_msg = NumberMessage{2};
+  Message empty_msg = EmptyMessage{};
+
+  EXPECT_EQ(text_msg.match(visitor), 1);
+  EXPECT_EQ(num_msg.match(visitor), 2);
+  EXPECT_EQ(empty_msg.match(visitor), -1);
+}
+
+// 23 alternatives: beyond variant-lite's 16-type limit
+template <int N>
+struct Msg {
+  int id;
+  bool operator==(const Msg& other) const { return id == other.id; }
+};
+
+using WideMessage =
+    Enum<Msg<0>, Msg<1>, Msg<2>, Msg<3>, Msg<4>, Msg<5>, Msg<6>, Msg<7>,
+         Msg<8>, Msg<9>, Msg<10>, Msg<11>, Msg<12>, Msg<13>, Msg<14>,
+         Msg<15>, Msg<16>, Msg<17>, Msg<18>, Msg<19>, Msg<20>, Msg<21>,
+         Msg<22>>;
+
+struct WideVisitor {
+  template <int N>
+  int operator()(const Msg<N>& m) const {
+    return N * 100 + m.id;
+  }
+};
+
+TEST_F(EnumTest, MoreThanSixteenAlternatives) {
+  WideMessage first = Msg<0>{1};
+  WideMessage last = Msg<22>{7};
+
+  EXPECT_EQ(first.index(), 0u);
+  EXPECT_EQ(last.index(), 22u);
+  EXPECT_TRUE(last.is<Msg<22>>());
+  EXPECT_EQ(last.get<Msg<22>>().id, 7);
+  EXPECT_EQ(last.match(WideVisitor()), 2207);
+  EXPECT_EQ(first.match(WideVisitor()), 1);
+
+  last = Msg<17>{3};
+
+  EXPECT_EQ(last.index(), 17u);
+  EXPECT_EQ(last.match(WideVisitor()), 1703);
+  EXPECT_NE(first, last);
+}
+
+TEST_F(EnumTest, CopyAndMove) {
+  Message original = TextMessage{"payload", 1};
+  Message copy = original;  // non-const lvalue picks the copy constructor
+
+  EXPECT_TRUE(copy.is<TextMessage>());
+  EXPECT_EQ(copy.get<TextMessage>().content, "payload");
+
+  Message moved = std::move(copy);
+
+  EXPECT_EQ(moved.get<TextMessage>().content, "payload");
+
+  Message assigned = NumberMessage{3};
+  assigned = original;
+
+  EXPECT_TRUE(assigned.is<TextMessage>());
+  EXPECT_EQ(assigned.get<TextMessage>().content, "payload");
+
+  assigned = NumberMessage{4};
+
+  EXPECT_EQ(assigned.get<NumberMessage>().value, 4);
+}
+
+TEST_F(EnumTest, MoveOnlyAlternative) {
+  using Owned = Enum<std::unique_ptr<int>, EmptyMessage>;
+
+  static_assert(!std::is_copy_constructible<Owned>::value,
+                "move-only alternatives make the Enum move-only");
+  static_assert(std::is_nothrow_move_constructible<Owned>::value,
+                "moving an Enum of nothrow-movable alternatives is nothrow");
+
+  Owned owned = std::unique_ptr<int>(new int(5));
+  Owned other = std::move(owned);
+
+  ASSERT_TRUE(other.is<std::unique_ptr<int>>());
+  EXPECT_EQ(*other.get<std::unique_ptr<int>>(), 5);
+
+  std::vector<Owned> owners;
+  owners.push_back(std::move(other));
+  owners.push_back(EmptyMessage{});
+
+  EXPECT_TRUE(owners[0].is<std::unique_ptr<int>>());
+  EXPECT_TRUE(owners[1].is<EmptyMessage>());
+}
+
+TEST_F(EnumTest, ConvertingConstruction) {
+  Enum<int, std::string> number = 42;
+  Enum<int, std::string> text = "hello";
+
+  EXPECT_TRUE(number.is<int>());
+  EXPECT_TRUE(text.is<std::string>());
+  EXPECT_EQ(text.get<std::string>(), "hello");
+}
+
+TEST_F(EnumTest, MatchMutatesInPlace) {
+  Message message = TextMessage{"hello", 1};
+
+  message.match([](TextMessage& text) { text.content += " world"; },
+                [](NumberMessage& number) { number.value = 0; },
+                [](EmptyMessage&) {});
+
+  EXPECT_EQ(message.get<TextMessage>().content, "hello world");
+
+  detail::backend::variant<int, std::string> raw = std::string("raw");
+  match(raw, [](int& i) { ++i; }, [](std::string& str) { str += "!"; });
+  EXPECT_EQ(detail::backend::get<std::string>(raw), "raw!");
+}
+
+TEST_F(EnumTest, RvalueMatchMovesOut) {
+  std::vector<std::string> queue;
+  Message message = TextMessage{std::string(64, 'x'), 0};
+  const char* buffer = message.get<TextMessage>().content.data();
+
+  std::move(message).match(
+      [&](TextMessage&& text) { queue.push_back(std::move(text.content)); },
+      [](NumberMessage&&) {}, [](EmptyMessage&&) {});
+
+  ASSERT_EQ(queue.size(), 1u);
+  EXPECT_EQ(queue[0].data(), buffer) << "the payload was moved, not copied";
+}
+
+TEST_F(EnumTest, StatefulVisitor) {
+  struct Counter {
+    int texts = 0;
+    int numbers = 0;
+    void operator()(const TextMessage&) { ++texts; }
+    void operator()(const NumberMessage& n) { numbers += n.value; }
+    void operator()(const EmptyMessage&) {}
+  };
+
+  std::vector<Message> messages;
+  messages.push_back(TextMessage{"a", 0});
+  messages.push_back(NumberMessage{2});
+  messages.push_back(NumberMessage{3});
+
+  Counter counter;
+  for (const Message& message : messages) {
+    message.match(counter);
+  }
+
+  EXPECT_EQ(counter.texts, 1);
+  EXPECT_EQ(counter.numbers, 5);
+}
+
+TEST_F(EnumTest, MatchSeveralEnums) {
+  Color color = Blue{7};
+  Message message = NumberMessage{5};
+
+  auto describe = [](const Color& c, const Message& m) {
+    return match(
+        c, m, [](const Blue& b, const NumberMessage& n) {
+          return b.intensity + n.value;
+        },
+        [](const auto&, const auto&) { return -1; });
+  };
+
+  EXPECT_EQ(describe(color, message), 12);
+  EXPECT_EQ(describe(Red{}, message), -1);
+
+  Message other = TextMessage{"moved", 0};
+  std::string taken = match(
+      std::move(other), color,
+      [](TextMessage&& text, Blue&) { return std::move(text.content); },
+      [](auto&&, auto&&) { return std::string(); });
+  EXPECT_EQ(taken, "moved");
+}
+
+TEST_F(EnumTest, IndexAndUncheckedAccess) {
+  Message message = NumberMessage{12};
+
+  EXPECT_EQ(message.get<1>().value, 12);
+  EXPECT_THROW(message.get<0>(), std::runtime_error);
+
+  message.get_unchecked<NumberMessage>().value = 13;
+  EXPECT_EQ(message.get_unchecked<1>().value, 13);
+
+  const Message& view = message;
+  EXPECT_EQ(view.get<1>().value, 13);
+  EXPECT_EQ(view.get_unchecked<NumberMessage>().value, 13);
+}
+
+TEST_F(EnumTest, TriviallyCopyable) {
+  using Number = Enum<int, double>;
+
+  static_assert(std::is_trivially_copyable<Number>::value, "");
+  static_assert(std::is_trivially_copyable<Enum<Red, Green>>::value, "");
+  static_assert(!std::is_trivially_copyable<Message>::value,
+                "TextMessage owns a std::string");
+
+  Number number = 2.5;
+  Number copy = number;
+  ASSERT_TRUE(copy.is<double>());
+  EXPECT_EQ(copy.get<double>(), 2.5);
+  copy = 7;
+  EXPECT_EQ(copy.get<int>(), 7);
+}
+
+TEST_F(EnumTest, TagOnlyLayout) {
+  using Traffic = Enum<Red, Green, EmptyMessage>;
+
+  static_assert(sizeof(Traffic) == 1, "an Enum of empty tags is one byte");
+  static_assert(layout_of<Traffic>::tag_only, "empty tags need no payload");
+  static_assert(layout_of<Traffic>::payload_size == 0, "");
+  static_assert(layout_of<Traffic>::discriminant_size == 1, "");
+
+  Traffic light = Red{};
+  EXPECT_TRUE(light.is<Red>());
+  light = Green{};
+  EXPECT_TRUE(light.is<Green>());
+
+  Traffic copy = light;
+  EXPECT_TRUE(copy == light);
+  copy = EmptyMessage{};
+  EXPECT_TRUE(copy != light);
+
+  int seen = copy.match([](const Red&) { return 0; },
+                        [](const Green&) { return 1; },
+                        [](const EmptyMessage&) { return 2; });
+  EXPECT_EQ(seen, 2);
+}
+
+TEST_F(EnumTest, PayloadLayout) {
+  static_assert(!layout_of<Color>::tag_only, "Blue carries an intensity");
+  static_assert(layout_of<Color>::payload_size == sizeof(Blue), "");
+  static_assert(layout_of<Color>::discriminant_size == 1, "");
+  static_assert(layout_of<Color>::size == 2 * sizeof(int),
+                "the discriminant packs into the payload's alignment");
+  static_assert(layout_of<Result<int, int> >::size == 2 * sizeof(int), "");
+  static_assert(layout_of<Enum<char, bool> >::size == 2,
+                "small payloads get a byte-sized discriminant");
+}
+
+namespace {
+
+ENUM_VARIANT2(Move, int, dx, int, dy);
+ENUM_VARIANT0(Quit);
+
+struct Unreflected {
+  bool operator==(const Unreflected&) const { return true; }
+};
+
+}  // namespace
+
+TEST_F(EnumTest, Reflection) {
+  static_assert(variant_traits<Move>::field_count() == 2, "");
+  static_assert(variant_traits<Quit>::field_count() == 0, "");
+  static_assert(variant_traits<Blue>::field_count() == 0,
+                "declarations are not parsed into fields");
+  static_assert(index_of<Blue, Color>::value == 2, "");
+  static_assert(index_of<Quit, Enum<Move, Quit> >::value == 1, "");
+  static_assert(variant_count<Message>::value == 3, "");
+
+  EXPECT_STREQ(variant_traits<Move>::name(), "Move");
+  EXPECT_STREQ(variant_traits<Move>::field_name(0), "dx");
+  EXPECT_STREQ(variant_traits<Move>::field_name(1), "dy");
+  EXPECT_EQ(variant_traits<Move>::field_name(2), nullptr);
+  EXPECT_STREQ(variant_traits<Blue>::name(), "Blue");
+  EXPECT_STREQ(variant_traits<Unreflected>::name(), "");
+  EXPECT_EQ(variant_traits<int>::field_name(0), nullptr);
+
+  Color color = Blue{};
+  EXPECT_STREQ(variant_name(color), "Blue");
+  color = Red{};
+  EXPECT_STREQ(variant_name(color), "Red");
+
+  Enum<Move, Quit, Unreflected> command = Move(1, 2);
+  EXPECT_STREQ(variant_name(command), "Move");
+  command = Unreflected{};
+  EXPECT_STREQ(variant_name(command), "");
+}
+
+namespace {
+
+ENUM_VARIANT2(Point, int, x, int, y);
+ENUM_VARIANT2(Sample, double, weight, std::string, label);
+
+}  // namespace
+
+TEST_F(EnumTest, FieldEquality) {
+  static_assert(detail::is_bitwise_comparable<Point>::value,
+                "two ints without padding compare as bytes");
+  static_assert(!detail::is_bitwise_comparable<Sample>::value, "");
+
+  EXPECT_TRUE(Point(1, 2) == Point(1, 2));
+  EXPECT_TRUE(Point(1, 2) != Point(2, 1));
+  EXPECT_TRUE(Sample(0.5, "a") == Sample(0.5, "a"));
+  EXPECT_TRUE(Sample(0.5, "a") != Sample(0.5, "b"));
+  EXPECT_TRUE(Sample(0.0, "a") == Sample(-0.0, "a"));
+
+  Enum<Point, Sample> shape = Point(3, 4);
+  EXPECT_EQ(shape, (Enum<Point, Sample>(Point(3, 4))));
+  EXPECT_NE(shape, (Enum<Point, Sample>(Point(4, 3))));
+  EXPECT_NE(shape, (Enum<Point, Sample>(Sample(3, "4"))));
+
+  Message text = TextMessage{"hi", 1};
+  EXPECT_EQ(text, (Message(TextMessage{"hi", 1})));
+  EXPECT_NE(text, (Message(TextMessage{"hi", 2})));
+}
+
+TEST_F(EnumTest, Hash) {
+  std::hash<Color> hash;
+  EXPECT_EQ(hash(Color(Blue{7})), hash(Color(Blue{7})));
+  EXPECT_NE(hash(Color(Red{})), hash(Color(Green{})));
+
+  std::unordered_set<Enum<Point, Sample, Quit> > seen;
+  seen.insert(Point(1, 2));
+  seen.insert(Point(1, 2));
+  seen.insert(Point(2, 1));
+  seen.insert(Sample(1.5, "x"));
+  seen.insert(Quit());
+  seen.insert(Quit());
+  EXPECT_EQ(seen.size(), 4u);
+  EXPECT_EQ(seen.count(Point(2, 1)), 1u);
+  EXPECT_EQ(seen.count(Sample(1.5, "y")), 0u);
+
+  // Equal fields hash equally, signed zeros included
+  std::hash<Enum<Point, Sample, Quit> > shape_hash;
+  EXPECT_EQ(shape_hash(Sample(0.0, "z")), shape_hash(Sample(-0.0, "z")));
+}
@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2025 Dapeng Feng
+ * All rights reserved.
+ */
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "rustcxx_enum_vec.hpp"
+
+using namespace rust;  // NOLINT
+
+namespace {
+
+ENUM_VARIANT(Connect, int port);          // NOLINT
+ENUM_VARIANT(Send, std::string data);     // NOLINT
+ENUM_VARIANT(Disconnect);
+
+using Event = Enum<Connect, Send, Disconnect>;
+using EventVec = EnumVec<Connect, Send, Disconnect>;
+
+// Alternative whose construction fails on request
+struct Fragile {
+  explicit Fragile(bool fail) {
+    if (fail) {
+      throw std::runtime_error("construction failed");
+    }
+  }
+};
+
+}  // namespace
+
+class EnumVecTest : public ::testing::Test {
+ protected:
+  void SetUp() override {}
+  void TearDown() override {}
+};
+
+TEST_F(EnumVecTest, PushBackAndIndex) {
+  EventVec events;
+  events.push_back(Connect{80});
+  events.push_back(Send{"hello"});
+  events.push_back(Disconnect{});
+  events.push_back(Send{"bye"});
+
+  ASSERT_EQ(events.size(), 4u);
+  EXPECT_TRUE(events[0].is<Connect>());
+  EXPECT_EQ(events[0].get<Connect>().port, 80);
+  EXPECT_EQ(events[1].get<Send>().data, "hello");
+  EXPECT_TRUE(events[2].is<Disconnect>());
+  EXPECT_EQ(events[3].get<Send>().data, "bye");
+  EXPECT_EQ(events[3].index(), 1u);
+
+  EXPECT_EQ(events[0].get_if<Send>(), nullptr);
+  EXPECT_THROW(events[0].get<Send>(), std::runtime_error);
+
+  EXPECT_EQ(events.count_of<Send>(), 2u);
+  EXPECT_EQ(events.column<Send>().size(), 2u);
+}
+
+TEST_F(EnumVecTest, MatchThroughReference) {
+  EventVec events;
+  events.push_back(Connect{443});
+  events.push_back(Send{"data"});
+
+  auto describe = [](EventVec::const_reference event) {
+    return event.match(
+        [](const Connect& c) { return "connect " + std::to_string(c.port); },
+        [](const Send& s) { return "send " + s.data; },
+        [](const Disconnect&) { return std::string("disconnect"); });
+  };
+
+  const EventVec& view = events;
+  EXPECT_EQ(describe(view[0]), "connect 443");
+  EXPECT_EQ(describe(view[1]), "send data");
+
+  match(events[1], [](Connect&) {}, [](Send& s) { s.data += "!"; },
+        [](Disconnect&) {});
+  EXPECT_EQ(events[1].get<Send>().data, "data!");
+}
+
+TEST_F(EnumVecTest, ForEachOf) {
+  EventVec events;
+  for (int i = 0; i < 10; ++i) {
+    if (i % 3 == 0) {
+      events.push_back(Connect{i});
+    } else {
+      events.push_back(Disconnect{});
+    }
+  }
+
+  std::vector<int> ports;
+  events.for_each_of<Connect>([&](const Connect& c) { ports.push_back(c.port); });
+  EXPECT_EQ(ports, (std::vector<int>{0, 3, 6, 9}));
+
+  events.for_each_of<Connect>([](Connect& c) { c.port += 1; });
+  EXPECT_EQ(events[3].get<Connect>().port, 4);
+}
+
+TEST_F(EnumVecTest, FromEnum) {
+  std::vector<Event> source;
+  source.push_back(Send{"a"});
+  source.push_back(Connect{1});
+
+  EventVec events;
+  events.reserve(source.size());
+  for (const Event& event : source) {
+    events.push_back(event);
+  }
+  events.push_back(Event(Disconnect{}));
+
+  ASSERT_EQ(events.size(), 3u);
+  EXPECT_EQ(events[0].get<Send>().data, "a");
+  EXPECT_EQ(events[1].get<Connect>().port, 1);
+  EXPECT_TRUE(events[2].is<Disconnect>());
+
+  events.clear();
+  EXPECT_TRUE(events.empty());
+  EXPECT_EQ(events.count_of<Send>(), 0u);
+}
+
+TEST_F(EnumVecTest, FailedEmplaceLeavesVecUnchanged) {
+  EnumVec<Connect, Fragile> events;
+  for (int i = 0; i < 8; ++i) {
+    events.emplace_back<Connect>(Connect{i});
+  }
+  events.emplace_back<Fragile>(false);
+
+  EXPECT_THROW(events.emplace_back<Fragile>(true), std::runtime_error);
+  ASSERT_EQ(events.size(), 9u);
+  EXPECT_EQ(events.indices().size(), events.positions().size());
+  EXPECT_EQ(events.count_of<Fragile>(), 1u);
+  EXPECT_TRUE(events[8].is<Fragile>());
+
+  events.emplace_back<Connect>(Connect{8});
+  EXPECT_EQ(events[9].get<Connect>().port, 8);
+  EXPECT_EQ(events.positions()[9], 8u);
+}
@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2025 Dapeng Feng
+ * All rights reserved.
+ */
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <type_traits>
+
+#include "rustcxx_error.hpp"
+
+using namespace rust;  // NOLINT
+
+namespace {
+
+Result<int, StaticError> parse_digit(char c) {
+  if (c < '0' || c > '9') {
+    return Result<int, StaticError>::Err(StaticError("not a digit", 22));
+  }
+  return Result<int, StaticError>::Ok(c - '0');
+}
+
+Result<int> read_line(int line) {
+  if (line == 3) {
+    return Result<int>::Err("unexpected token");
+  }
+  return Result<int>::Ok(line);
+}
+
+Result<int, ContextError<std::string> > parse_config(int lines) {
+  int sum = 0;
+  for (int line = 1; line <= lines; ++line) {
+    Result<int, ContextError<std::string> > r =
+        read_line(line).context("parsing line %d", line);
+    if (r.is_err()) {
+      return r;
+    }
+    sum += r.unwrap();
+  }
+  return Result<int, ContextError<std::string> >::Ok(sum);
+}
+
+}  // namespace
+
+class ErrorTest : public ::testing::Test {
+ protected:
+  void SetUp() override {}
+  void TearDown() override {}
+};
+
+TEST_F(ErrorTest, StaticError) {
+  static_assert(std::is_trivially_copyable<StaticError>::value,
+                "StaticError must be trivially copyable");
+  static_assert(std::is_trivially_copyable<Result<int, StaticError> >::value,
+                "Result<int, StaticError> must be trivially copyable");
+
+  Result<int, StaticError> ok = parse_digit('7');
+  Result<int, StaticError> err = parse_digit('x');
+
+  EXPECT_EQ(ok.unwrap(), 7);
+  ASSERT_TRUE(err.is_err());
+  EXPECT_EQ(err.unwrap_err().code(), 22);
+  EXPECT_STREQ(err.unwrap_err().message(), "not a digit");
+  EXPECT_EQ(err.unwrap_err().to_string(), "not a digit");
+
+  char copy[] = "not a digit";
+  EXPECT_EQ(err.unwrap_err(), StaticError(copy, 22));
+  EXPECT_NE(err.unwrap_err(), StaticError("not a digit", 1));
+  EXPECT_STREQ(StaticError().message(), "");
+}
+
+TEST_F(ErrorTest, InlineErrorText) {
+  typedef InlineError<8> SmallError;
+  static_assert(std::is_trivially_copyable<SmallError>::value,
+                "InlineError must be trivially copyable");
+
+  SmallError error("connection reset", 104);
+
+  EXPECT_EQ(error.code(), 104);
+  EXPECT_EQ(error.location(), nullptr);
+  EXPECT_EQ(error.to_string(), "connect");
+
+  char out[4];
+  EXPECT_EQ(error.format_to(out, sizeof(out)), 7u);
+  EXPECT_STREQ(out, "con");
+  EXPECT_EQ(SmallError().to_string(), "");
+
+  EXPECT_EQ(error, SmallError("connect", 104));
+  EXPECT_NE(error, SmallError("connect", 54));
+  EXPECT_NE(SmallError("conn", 104), SmallError("con", 104));
+}
+
+TEST_F(ErrorTest, InlineErrorDeferredFormat) {
+  typedef InlineError<48> RpcError;
+  typedef Result<int, RpcError> RpcResult;
+  static_assert(std::is_trivially_copyable<RpcResult>::value,
+                "Result<int, InlineError<48>> must be trivially copyable");
+
+  const char* method = "GetUser";
+  RpcResult result = RpcResult::Err(RpcError::with_location(
+      404, RUSTCXX_ERROR_LOCATION(), "no method %s (id %d, %.1f ms)", method,
+      17, 2.5));
+
+  ASSERT_TRUE(result.is_err());
+  const RpcError& error = result.unwrap_err();
+  EXPECT_EQ(error.code(), 404);
+  EXPECT_EQ(error.to_string(), "no method GetUser (id 17, 2.5 ms)");
+  ASSERT_NE(error.location(), nullptr);
+  EXPECT_NE(std::string(error.location()->file).find("test_error.cpp"),
+            std::string::npos);
+  EXPECT_GT(error.location()->line, 0);
+
+  RpcResult copy = result;
+  EXPECT_EQ(copy.unwrap_err(), error);
+  EXPECT_NE(copy.unwrap_err(), RpcError::format(404, "no method %d", 18));
+  EXPECT_EQ(RpcError::format(1, "plain").to_string(), "plain");
+  EXPECT_EQ(RpcError::format(404, "no method %d", 18),
+            RpcError("no method 18", 404));
+  EXPECT_NE(RpcError("no method 1", 404),
+            RpcError::format(404, "no method %d", 18));
+}
+
+TEST_F(ErrorTest, ContextChain) {
+  const char* name = "config.toml";
+  Result<int, ContextError<std::string> > ok =
+      parse_config(2).context("loading %s", name);
+  EXPECT_EQ(ok.unwrap(), 3);
+
+  Result<int, ContextError<std::string> > err =
+      parse_config(5).context("loading %s (attempt %d)", name, 2);
+  ASSERT_TRUE(err.is_err());
+  EXPECT_EQ(err.unwrap_err().frames(), 2u);
+  EXPECT_EQ(err.unwrap_err().error(), "unexpected token");
+  EXPECT_EQ(err.unwrap_err().to_string(),
+            "loading config.toml (attempt 2): parsing line 3: "
+            "unexpected token");
+}
+
+TEST_F(ErrorTest, LazyContext) {
+  int calls = 0;
+  int* counter = &calls;
+  Result<int, ContextError<StaticError> > err =
+      Result<int, StaticError>::Err(StaticError("timeout", 110))
+          .with_context([counter] {
+            ++*counter;
+            return "retrying request";
+          });
+
+  for (int attempt = 0; attempt < 3; ++attempt) {
+    err = std::move(err).context("attempt %d", attempt);
+  }
+  EXPECT_EQ(calls, 0);
+  EXPECT_EQ(err.unwrap_err().error().code(), 110);
+
+  ContextError<StaticError> error = err.unwrap_err();
+  EXPECT_EQ(error.frames(), 4u);
+  EXPECT_EQ(error.to_string(),
+            "attempt 2: attempt 1: attempt 0: retrying request: timeout");
+  EXPECT_EQ(calls, 1);
+
+  error.push("dropped");
+  EXPECT_EQ(error.dropped(), 1u);
+  EXPECT_EQ(error.to_string().find("(1 more): attempt 2"), 0u);
+}
+
+TEST_F(ErrorTest, ContextCopiesStrings) {
+  static_assert(sizeof(ContextError<std::string>) ==
+                    sizeof(std::string) + sizeof(void*),
+                "frames live out of line");
+
+  Result<int, ContextError<std::string> > err = read_line(1).context("unused");
+  {
+    std::string path = "/etc/service.conf";
+    err = read_line(3).context("reading %s (%s, %d)", path.c_str(), path, 7);
+    path.assign(path.size(), 'x');
+  }
+  EXPECT_EQ(err.unwrap_err().to_string(),
+            "reading /etc/service.conf (/etc/service.conf, 7): "
+            "unexpected token");
+
+  const std::string long_name(200, 'a');
+  ContextError<std::string> copy = read_line(3).context("%s", long_name)
+                                       .unwrap_err();
+  EXPECT_EQ(copy.to_string(),
+            std::string(detail::context_frame_bytes - 1, 'a') +
+                ": unexpected token");
+  EXPECT_EQ(ContextError<std::string>(copy).to_string(), copy.to_string());
+}
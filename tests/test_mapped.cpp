@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2025 Dapeng Feng
+ * All rights reserved.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "rustcxx_mapped.hpp"
+
+using namespace rust;  // NOLINT
+
+namespace {
+
+ENUM_VARIANT2(Click, std::int32_t, x, std::int32_t, y);
+ENUM_VARIANT1(Scroll, double, delta);
+ENUM_VARIANT0(Blur);
+
+typedef EnumVec<Click, Scroll, Blur> Events;
+typedef MappedEnumSpan<Click, Scroll, Blur> MappedEvents;
+
+Events make_events() {
+  Events events;
+  events.push_back(Click(1, 2));
+  events.push_back(Scroll(0.5));
+  events.push_back(Blur());
+  events.push_back(Click(3, 4));
+  events.push_back(Scroll(-1.5));
+  return events;
+}
+
+// Image copied to storage aligned like a mapping
+struct AlignedImage {
+  explicit AlignedImage(const std::string& bytes)
+      : lines((bytes.size() + 63) / 64 + 1), size(bytes.size()) {
+    std::memcpy(data(), bytes.data(), bytes.size());
+  }
+
+  char* data() {
+    return reinterpret_cast<char*>(lines.data()) +
+           (64 - reinterpret_cast<std::uintptr_t>(lines.data()) % 64) % 64;
+  }
+
+  struct alignas(64) Line {
+    char bytes[64];
+  };
+  std::vector<Line> lines;
+  std::size_t size;
+};
+
+std::string image_of(const Events& events) {
+  std::ostringstream out;
+  const std::size_t written = write_mapped(events, out).unwrap();
+  EXPECT_EQ(written, out.str().size());
+  return out.str();
+}
+
+}  // namespace
+
+class MappedTest : public ::testing::Test {
+ protected:
+  void SetUp() override {}
+  void TearDown() override {}
+};
+
+TEST_F(MappedTest, ReadInPlace) {
+  AlignedImage image(image_of(make_events()));
+  MappedEvents events = MappedEvents::from_bytes(image.data(), image.size).unwrap();
+
+  ASSERT_EQ(events.size(), 5u);
+  EXPECT_EQ(events.count_of<Click>(), 2u);
+  EXPECT_EQ(events.index_at(2), 2u);
+  EXPECT_TRUE(events[1].is<Scroll>());
+  EXPECT_EQ(events[1].get_if<Click>(), nullptr);
+  EXPECT_EQ(events[3].get<Click>().y, 4);
+  EXPECT_GE(reinterpret_cast<const char*>(&events[3].get<Click>()),
+            image.data());
+
+  double total = 0;
+  for (std::size_t i = 0; i < events.size(); ++i) {
+    total += events[i].match([](const Click& c) { return double(c.x + c.y); },
+                             [](const Scroll& s) { return s.delta; },
+                             [](const Blur&) { return 100.0; });
+  }
+  EXPECT_DOUBLE_EQ(total, 109.0);
+
+  int clicks = 0;
+  events.for_each_of<Click>([&clicks](const Click& c) { clicks += c.x; });
+  EXPECT_EQ(clicks, 4);
+}
+
+TEST_F(MappedTest, RejectsBadImages) {
+  const std::string bytes = image_of(make_events());
+
+  AlignedImage truncated(bytes.substr(0, bytes.size() - 1));
+  EXPECT_EQ(MappedEvents::from_bytes(truncated.data(), truncated.size)
+                .unwrap_err(),
+            MapError::corrupt);
+
+  AlignedImage other(bytes);
+  EXPECT_EQ((MappedEnumSpan<Click, Blur, Scroll>::from_bytes(other.data(),
+                                                             other.size)
+                 .unwrap_err()),
+            MapError::type_mismatch);
+
+  std::string bad_tag = bytes;
+  // First tag, right after the 40-byte header and three column counts
+  bad_tag[40 + 3 * 8] = 7;
+  AlignedImage tagged(bad_tag);
+  EXPECT_EQ(MappedEvents::from_bytes(tagged.data(), tagged.size).unwrap_err(),
+            MapError::corrupt);
+
+  AlignedImage garbage(std::string(128, 'x'));
+  EXPECT_EQ(MappedEvents::from_bytes(garbage.data(), garbage.size).unwrap_err(),
+            MapError::bad_magic);
+}
+
+#if RUSTCXX_HAS_MMAP
+TEST_F(MappedTest, OpenFile) {
+  const std::string path = ::testing::TempDir() + "rustcxx_mapped_test.bin";
+  {
+    std::ofstream file(path.c_str(), std::ios::binary);
+    ASSERT_TRUE(write_mapped(make_events(), file).is_ok());
+  }
+  {
+    MappedEvents events = MappedEvents::open(path.c_str()).unwrap();
+    MappedEvents moved = std::move(events);
+    ASSERT_EQ(moved.size(), 5u);
+    EXPECT_DOUBLE_EQ(moved[4].get<Scroll>().delta, -1.5);
+  }
+  std::remove(path.c_str());
+  EXPECT_EQ(MappedEvents::open(path.c_str()).unwrap_err(), MapError::io);
+
+  { std::ofstream empty(path.c_str(), std::ios::binary); }
+  EXPECT_EQ(MappedEvents::open(path.c_str()).unwrap_err(), MapError::corrupt);
+  std::remove(path.c_str());
+}
+#endif
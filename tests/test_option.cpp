@@ -5,12 +5,56 @@
 
 #include <gtest/gtest.h>
 
+#include <memory>
 #include <string>
+#include <unordered_set>
+#include <utility>
 
-#include "rustcxx/rustcxx.hpp"
+#include "rustcxx.hpp"
 
 using namespace rust;  // NOLINT
 
+namespace {
+
+// Payload that counts how often it is copied or moved
+struct Tracked {
+  static int copies;
+  static int moves;
+
+  int value;
+
+  explicit Tracked(int v = 0) : value(v) {}
+  Tracked(const Tracked& other) : value(other.value) { ++copies; }
+  Tracked(Tracked&& other) noexcept : value(other.value) { ++moves; }
+
+  static void reset() { copies = moves = 0; }
+};
+
+int Tracked::copies = 0;
+int Tracked::moves = 0;
+
+// Handle whose all-ones id never names a node
+struct NodeHandle {
+  unsigned id;
+  explicit NodeHandle(unsigned i) : id(i) {}
+};
+
+ENUM_VARIANT(Leaf, int weight);  // NOLINT
+ENUM_VARIANT(Branch);
+
+}  // namespace
+
+namespace rust {
+
+template <>
+struct niche_traits<NodeHandle> {
+  static constexpr bool available = true;
+  static NodeHandle none() { return NodeHandle(~0u); }
+  static bool is_none(const NodeHandle& handle) { return handle.id == ~0u; }
+};
+
+}  // namespace rust
+
 class OptionTest : public ::testing::Test {
  protected:
   void SetUp() override {}
@@ -144,3 +188,168 @@ TEST_F(OptionTest, ChainedOperations) {
 
   EXPECT_TRUE(result3.is_none());
 }
+
+TEST_F(OptionTest, SomeForwarding) {
+  Tracked::reset();
+  auto option = Option<Tracked>::Some(Tracked(9));
+
+  EXPECT_EQ(option.unwrap().value, 9);
+  EXPECT_EQ(Tracked::copies, 0);
+  EXPECT_LE(Tracked::moves, 1);
+}
+
+TEST_F(OptionTest, EmplaceConstruction) {
+  Tracked::reset();
+  auto option = Option<Tracked>::emplace_some(13);
+
+  EXPECT_EQ(option.unwrap().value, 13);
+  EXPECT_EQ(Tracked::copies, 0);
+  EXPECT_EQ(Tracked::moves, 0);
+
+  auto text = Option<std::string>::emplace_some(2, 'a');
+
+  EXPECT_EQ(text.unwrap(), "aa");
+}
+
+TEST_F(OptionTest, MoveOnlyPayload) {
+  auto option =
+      Option<std::unique_ptr<int>>::Some(std::unique_ptr<int>(new int(8)));
+
+  ASSERT_TRUE(option.is_some());
+  EXPECT_EQ(*option.unwrap(), 8);
+}
+
+TEST_F(OptionTest, RvalueChainMovesPayload) {
+  Tracked::reset();
+  auto option = Option<Tracked>::emplace_some(2)
+                    .map([](Tracked&& t) {
+                      t.value += 1;
+                      return std::move(t);
+                    })
+                    .and_then([](Tracked&& t) {
+                      return Option<Tracked>::Some(std::move(t));
+                    });
+
+  EXPECT_EQ(option.unwrap().value, 3);
+  EXPECT_EQ(Tracked::copies, 0);
+}
+
+TEST_F(OptionTest, RvalueUnwrapMovesOut) {
+  Tracked::reset();
+  Tracked value = Option<Tracked>::emplace_some(5).unwrap();
+  Tracked fallback = Option<Tracked>::None().unwrap_or(Tracked(1));
+  Tracked present = Option<Tracked>::emplace_some(7).unwrap_or(Tracked(1));
+
+  EXPECT_EQ(value.value, 5);
+  EXPECT_EQ(fallback.value, 1);
+  EXPECT_EQ(present.value, 7);
+  EXPECT_EQ(Tracked::copies, 0);
+}
+
+TEST_F(OptionTest, ConstCombinators) {
+  const auto option = Option<int>::Some(4);
+
+  auto squared = option.map([](const int& x) { return x * x; });
+  auto halved = option.and_then(
+      [](const int& x) { return Option<int>::Some(x / 2); });
+  auto described = option.match([](const int& x) { return x; },
+                                []() { return -1; });
+
+  EXPECT_EQ(squared.unwrap(), 16);
+  EXPECT_EQ(halved.unwrap(), 2);
+  EXPECT_EQ(described, 4);
+}
+
+TEST_F(OptionTest, NullPointerNiche) {
+  static_assert(sizeof(Option<int*>) == sizeof(int*), "");
+  static_assert(sizeof(Option<std::unique_ptr<int>>) ==
+                    sizeof(std::unique_ptr<int>),
+                "");
+
+  int x = 3;
+  Option<int*> some = Option<int*>::Some(&x);
+  Option<int*> none = Option<int*>::None();
+
+  ASSERT_TRUE(some.is_some());
+  EXPECT_EQ(*some.unwrap(), 3);
+  EXPECT_TRUE(none.is_none());
+  EXPECT_TRUE(Option<int*>::Some(nullptr).is_none());
+
+  Option<std::unique_ptr<int>> owned =
+      Option<std::unique_ptr<int>>::Some(std::unique_ptr<int>(new int(9)));
+  Option<std::unique_ptr<int>> moved = std::move(owned);
+  ASSERT_TRUE(moved.is_some());
+  EXPECT_EQ(*std::move(moved).unwrap(), 9);
+  EXPECT_TRUE(Option<std::unique_ptr<int>>().is_none());
+}
+
+TEST_F(OptionTest, ReferenceOption) {
+  static_assert(sizeof(Option<int&>) == sizeof(int*), "");
+
+  int x = 1;
+  Option<int&> some = Option<int&>::Some(x);
+  ASSERT_TRUE(some.is_some());
+  some.unwrap() = 5;
+  EXPECT_EQ(x, 5);
+  EXPECT_EQ(&some.unwrap(), &x);
+
+  int fallback = 0;
+  EXPECT_EQ(&Option<int&>::None().unwrap_or(fallback), &fallback);
+  EXPECT_EQ(some.map([](int& v) { return v * 2; }).unwrap(), 10);
+}
+
+TEST_F(OptionTest, EnumNiche) {
+  using Tree = Enum<Leaf, Branch>;
+  static_assert(sizeof(Option<Tree>) == sizeof(Tree), "");
+
+  Option<Tree> none;
+  Option<Tree> leaf = Option<Tree>::Some(Leaf{4});
+  Option<Tree> branch = Option<Tree>::Some(Branch{});
+
+  EXPECT_TRUE(none.is_none());
+  ASSERT_TRUE(leaf.is_some());
+  EXPECT_EQ(leaf.unwrap().get<Leaf>().weight, 4);
+  EXPECT_TRUE(branch.unwrap().is<Branch>());
+
+  Option<Tree> copy = none;
+  EXPECT_TRUE(copy.is_none());
+  copy = leaf;
+  EXPECT_TRUE(copy.unwrap().is<Leaf>());
+  copy = std::move(none);
+  EXPECT_TRUE(copy.is_none());
+}
+
+TEST_F(OptionTest, UserNiche) {
+  static_assert(sizeof(Option<NodeHandle>) == sizeof(NodeHandle), "");
+
+  Option<NodeHandle> some = Option<NodeHandle>::Some(NodeHandle(7));
+  Option<NodeHandle> none;
+
+  ASSERT_TRUE(some.is_some());
+  EXPECT_EQ(some.unwrap().id, 7u);
+  EXPECT_TRUE(none.is_none());
+}
+
+TEST_F(OptionTest, UnwrapUnchecked) {
+  Option<std::string> some = Option<std::string>::Some("text");
+
+  if (some.is_some()) {
+    some.unwrap_unchecked() += "!";
+  }
+  EXPECT_EQ(some.unwrap_unchecked(), "text!");
+  EXPECT_EQ(std::move(some).unwrap_unchecked(), "text!");
+}
+
+TEST_F(OptionTest, EqualityAndHash) {
+  EXPECT_TRUE(Option<int>::Some(1) == Option<int>::Some(1));
+  EXPECT_TRUE(Option<int>::Some(1) != Option<int>::Some(2));
+  EXPECT_TRUE(Option<int>::None() == Option<int>::None());
+  EXPECT_TRUE(Option<int>::Some(0) != Option<int>::None());
+
+  std::unordered_set<Option<std::string> > seen;
+  seen.insert(Option<std::string>::Some("a"));
+  seen.insert(Option<std::string>::Some("a"));
+  seen.insert(Option<std::string>::None());
+  seen.insert(Option<std::string>::None());
+  EXPECT_EQ(seen.size(), 2u);
+}
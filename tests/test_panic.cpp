@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2025 Dapeng Feng
+ * All rights reserved.
+ */
+
+// Built with -fno-exceptions: failed unwraps go to the panic handler
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include "rustcxx.hpp"
+
+using namespace rust;  // NOLINT
+
+static_assert(RUSTCXX_CONFIG_NO_EXCEPTIONS,
+              "this test is meant to be built without exceptions");
+
+namespace {
+
+void exit_handler(const char* message) {
+  std::fputs(message, stderr);
+  std::exit(3);
+}
+
+}  // namespace
+
+class PanicTest : public ::testing::Test {
+ protected:
+  void SetUp() override {}
+  void TearDown() override { set_panic_handler(NULL); }
+};
+
+TEST_F(PanicTest, SuccessfulPathsDoNotPanic) {
+  Result<int> ok_result = Result<int>::Ok(1);
+  Option<int> some = Option<int>::Some(2);
+  Enum<int, std::string> number = 3;
+
+  EXPECT_EQ(ok_result.unwrap(), 1);
+  EXPECT_EQ(some.unwrap(), 2);
+  EXPECT_EQ(number.get<int>(), 3);
+}
+
+TEST_F(PanicTest, DefaultHandlerAborts) {
+  Result<int> err_result = Result<int>::Err("error");
+
+  EXPECT_DEATH(err_result.unwrap(), "Called unwrap\\(\\) on an Err Result");
+}
+
+TEST_F(PanicTest, CustomHandler) {
+  EXPECT_EQ(set_panic_handler(&exit_handler), &detail::default_panic_handler);
+
+  Option<int> none = Option<int>::None();
+  EXPECT_EXIT(none.unwrap(), ::testing::ExitedWithCode(3),
+              "Called unwrap\\(\\) on a None Option");
+
+  Enum<int, std::string> number = 3;
+  EXPECT_EXIT(number.get<std::string>(), ::testing::ExitedWithCode(3),
+              "bad variant access");
+}
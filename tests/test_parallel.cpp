@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2025 Dapeng Feng
+ * All rights reserved.
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "rustcxx_parallel.hpp"
+
+using namespace rust;  // NOLINT
+
+namespace {
+
+// Value without a default constructor
+struct Parsed {
+  explicit Parsed(int v) : value(v) {}
+  int value;
+};
+
+std::vector<int> iota(int n) {
+  std::vector<int> values;
+  for (int i = 0; i < n; ++i) {
+    values.push_back(i);
+  }
+  return values;
+}
+
+}  // namespace
+
+class ParallelTest : public ::testing::Test {
+ protected:
+  void SetUp() override {}
+  void TearDown() override {}
+};
+
+TEST_F(ParallelTest, MapsEveryElement) {
+  const std::vector<int> input = iota(10000);
+  ThreadPool pool(4);
+
+  Result<std::vector<int>> squares = par_try_map(
+      input, [](int v) { return Result<int>::Ok(v * 2); }, pool);
+
+  ASSERT_TRUE(squares.is_ok());
+  ASSERT_EQ(squares.unwrap().size(), input.size());
+  for (std::size_t i = 0; i < input.size(); ++i) {
+    ASSERT_EQ(squares.unwrap()[i], input[i] * 2);
+  }
+}
+
+TEST_F(ParallelTest, NonDefaultConstructibleOutput) {
+  const std::vector<int> input = iota(100);
+  ThreadPool pool(2);
+
+  Result<std::vector<Parsed>> parsed = par_try_map(
+      input, [](int v) { return Result<Parsed>::Ok(Parsed(v + 1)); }, pool);
+
+  ASSERT_TRUE(parsed.is_ok());
+  EXPECT_EQ(parsed.unwrap()[99].value, 100);
+}
+
+TEST_F(ParallelTest, FirstErrorByIndex) {
+  const std::vector<int> input = iota(20000);
+  ThreadPool pool(4);
+
+  for (int round = 0; round < 20; ++round) {
+    Result<std::vector<int>> result = par_try_map(
+        input,
+        [](int v) {
+          if (v % 997 == 996) {
+            return Result<int>::Err("bad " + std::to_string(v));
+          }
+          return Result<int>::Ok(v);
+        },
+        pool);
+
+    ASSERT_TRUE(result.is_err());
+    EXPECT_EQ(result.unwrap_err(), "bad 996");
+  }
+}
+
+TEST_F(ParallelTest, StopsEarly) {
+  const std::vector<int> input = iota(1000);
+  InlineExecutor executor;
+  int calls = 0;
+
+  Result<std::vector<int>> result = par_try_map(
+      input,
+      [&](int v) {
+        ++calls;
+        return v == 3 ? Result<int>::Err("stop") : Result<int>::Ok(v);
+      },
+      executor);
+
+  ASSERT_TRUE(result.is_err());
+  EXPECT_EQ(calls, 4);
+
+  std::atomic<int> pooled(0);
+  ThreadPool pool(4);
+  std::vector<int> big = iota(100000);
+  Result<std::vector<int>> cancelled = par_try_map(
+      big,
+      [&](int v) {
+        pooled.fetch_add(1);
+        return v == 0 ? Result<int>::Err("stop") : Result<int>::Ok(v);
+      },
+      pool);
+  ASSERT_TRUE(cancelled.is_err());
+  EXPECT_LT(pooled.load(), 100000);
+}
+
+TEST_F(ParallelTest, NestedCallsOnOnePool) {
+  const std::vector<int> input = iota(64);
+  ThreadPool pool(2);
+
+  // Every worker may be busy in an outer element while the inner calls'
+  // helpers are still queued
+  Result<std::vector<int>> sums = par_try_map(
+      input,
+      [&](int outer) -> Result<int> {
+        Result<std::vector<int>> inner = par_try_map(
+            input, [outer](int v) { return Result<int>::Ok(outer + v); },
+            pool);
+        int sum = 0;
+        for (int v : inner.unwrap()) {
+          sum += v;
+        }
+        return Result<int>::Ok(sum);
+      },
+      pool);
+
+  ASSERT_TRUE(sums.is_ok());
+  for (int outer = 0; outer < 64; ++outer) {
+    EXPECT_EQ(sums.unwrap()[static_cast<std::size_t>(outer)],
+              64 * outer + 63 * 64 / 2);
+  }
+}
+
+TEST_F(ParallelTest, EmptyInput) {
+  const std::vector<int> input;
+  ThreadPool pool(2);
+
+  Result<std::vector<int>> result =
+      par_try_map(input, [](int v) { return Result<int>::Ok(v); }, pool);
+
+  ASSERT_TRUE(result.is_ok());
+  EXPECT_TRUE(result.unwrap().empty());
+}
+
+TEST_F(ParallelTest, PropagatesExceptions) {
+  const std::vector<int> input = iota(1000);
+  ThreadPool pool(2);
+
+  EXPECT_THROW(par_try_map(
+                   input,
+                   [](int v) {
+                     if (v == 500) {
+                       throw std::runtime_error("parser crashed");
+                     }
+                     return Result<int>::Ok(v);
+                   },
+                   pool),
+               std::runtime_error);
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2025 Dapeng Feng
+ * All rights reserved.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "rustcxx_pmr.hpp"
+
+using namespace rust;  // NOLINT
+
+namespace {
+
+// Arena that counts what it hands out
+class CountingResource : public std::pmr::memory_resource {
+ public:
+  CountingResource() : allocations(0), upstream_(&buffer_) {}
+
+  std::size_t allocations;
+
+ private:
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+    ++allocations;
+    return upstream_.allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void* p, std::size_t bytes,
+                     std::size_t alignment) override {
+    upstream_.deallocate(p, bytes, alignment);
+  }
+
+  bool do_is_equal(
+      const std::pmr::memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+
+  std::pmr::monotonic_buffer_resource buffer_;
+  std::pmr::unsynchronized_pool_resource upstream_;
+};
+
+const char kLongMessage[] = "header checksum does not match the payload";
+
+}  // namespace
+
+class PmrTest : public ::testing::Test {
+ protected:
+  // Any allocation that escapes the arena throws std::bad_alloc
+  void SetUp() override {
+    previous_ = std::pmr::set_default_resource(std::pmr::null_memory_resource());
+  }
+
+  void TearDown() override { std::pmr::set_default_resource(previous_); }
+
+  CountingResource arena_;
+
+ private:
+  std::pmr::memory_resource* previous_;
+};
+
+TEST_F(PmrTest, ErrAllocatesFromResource) {
+  typedef Result<int, pmr::string> IntResult;
+
+  IntResult result = pmr::emplace_err<IntResult>(&arena_, kLongMessage);
+
+  ASSERT_TRUE(result.is_err());
+  EXPECT_EQ(result.unwrap_err(), kLongMessage);
+  EXPECT_EQ(result.unwrap_err().get_allocator().resource(), &arena_);
+  EXPECT_EQ(arena_.allocations, 1u);
+}
+
+TEST_F(PmrTest, MoveKeepsResource) {
+  typedef Result<int, pmr::string> IntResult;
+
+  IntResult first = pmr::emplace_err<IntResult>(&arena_, kLongMessage);
+  IntResult second = std::move(first);
+  pmr::string error = std::move(second).unwrap_err();
+
+  EXPECT_EQ(error, kLongMessage);
+  EXPECT_EQ(error.get_allocator().resource(), &arena_);
+  EXPECT_EQ(arena_.allocations, 1u);
+}
+
+TEST_F(PmrTest, CopyUsesDefaultResource) {
+  typedef Result<int, pmr::string> IntResult;
+
+  const IntResult first = pmr::emplace_err<IntResult>(&arena_, kLongMessage);
+  // The default resource is null_memory_resource in these tests
+  EXPECT_THROW(IntResult copy(first), std::bad_alloc);
+}
+
+TEST_F(PmrTest, OkAllocatesFromResource) {
+  typedef Result<std::pmr::vector<int>, pmr::string> VectorResult;
+
+  VectorResult result = pmr::emplace_ok<VectorResult>(&arena_, 64u, 7);
+
+  ASSERT_TRUE(result.is_ok());
+  EXPECT_EQ(result.unwrap().size(), 64u);
+  EXPECT_EQ(result.unwrap()[63], 7);
+  EXPECT_EQ(result.unwrap().get_allocator().resource(), &arena_);
+}
+
+TEST_F(PmrTest, EnumPayload) {
+  typedef Enum<int, pmr::string> Value;
+
+  Value value = pmr::make_enum<Value, pmr::string>(&arena_, kLongMessage);
+
+  ASSERT_TRUE(value.is<pmr::string>());
+  EXPECT_EQ(value.get<pmr::string>(), kLongMessage);
+  EXPECT_EQ(value.get<pmr::string>().get_allocator().resource(), &arena_);
+
+  pmr::string text = pmr::make<pmr::string>(&arena_, "short");
+  EXPECT_EQ(text.get_allocator().resource(), &arena_);
+}
@@ -5,12 +5,90 @@
 
 #include <gtest/gtest.h>
 
+#include <memory>
 #include <string>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
-#include "rustcxx/rustcxx.hpp"
+#include "rustcxx.hpp"
 
 using namespace rust;  // NOLINT
 
+namespace {
+
+// Payload that counts how often it is copied or moved
+struct Tracked {
+  static int copies;
+  static int moves;
+
+  int value;
+
+  explicit Tracked(int v = 0) : value(v) {}
+  Tracked(const Tracked& other) : value(other.value) { ++copies; }
+  Tracked(Tracked&& other) noexcept : value(other.value) { ++moves; }
+
+  static void reset() { copies = moves = 0; }
+};
+
+int Tracked::copies = 0;
+int Tracked::moves = 0;
+
+enum class IoError : unsigned char { closed };
+
+// Error of a higher layer; built from an IoError by a From specialization
+struct AppError {
+  std::string context;
+};
+
+Result<int, IoError> read_number(int raw) {
+  if (raw < 0) {
+    return Result<int, IoError>::Err(IoError::closed);
+  }
+  return Result<int, IoError>::Ok(raw);
+}
+
+}  // namespace
+
+namespace rust {
+
+template <>
+struct From<AppError, IoError> {
+  static AppError from(IoError) { return AppError{"connection closed"}; }
+};
+
+}  // namespace rust
+
+namespace {
+
+int after_try = 0;
+
+Result<int, AppError> doubled(int raw) {
+  RUSTCXX_TRY_ASSIGN(const int value, read_number(raw));
+  ++after_try;
+  return Result<int, AppError>::Ok(value * 2);
+}
+
+#if RUSTCXX_HAS_TRY_EXPRESSION
+Result<int, AppError> sum_of(int a, int b) {
+  return Result<int, AppError>::Ok(RUSTCXX_TRY(read_number(a)) +
+                                   RUSTCXX_TRY(read_number(b)));
+}
+
+Result<Tracked, Tracked> forward_tracked(Result<Tracked, Tracked>&& r) {
+  Tracked value = RUSTCXX_TRY(std::move(r));
+  return Result<Tracked, Tracked>::Ok(std::move(value));
+}
+
+Option<int> first_even(const Option<int>& o) {
+  const int value = RUSTCXX_TRY(o);
+  return value % 2 == 0 ? Option<int>::Some(value) : Option<int>::None();
+}
+#endif
+
+}  // namespace
+
 class ResultTest : public ::testing::Test {
  protected:
   void SetUp() override {}
@@ -130,3 +208,192 @@ TEST_F(ResultTest, UnwrapThrows) {
 
   EXPECT_THROW(ok_result.unwrap_err(), std::runtime_error);
 }
+
+TEST_F(ResultTest, OkErrForwarding) {
+  Tracked::reset();
+  Tracked payload(7);
+  auto ok_result = Result<Tracked, std::string>::Ok(std::move(payload));
+
+  EXPECT_EQ(ok_result.unwrap().value, 7);
+  EXPECT_EQ(Tracked::copies, 0);
+  EXPECT_LE(Tracked::moves, 1);
+
+  Tracked::reset();
+  auto err_result = Result<std::string, Tracked>::Err(Tracked(3));
+
+  EXPECT_EQ(err_result.unwrap_err().value, 3);
+  EXPECT_EQ(Tracked::copies, 0);
+  EXPECT_LE(Tracked::moves, 1);
+}
+
+TEST_F(ResultTest, EmplaceConstruction) {
+  Tracked::reset();
+  auto ok_result = Result<Tracked, std::string>::emplace_ok(11);
+
+  EXPECT_EQ(ok_result.unwrap().value, 11);
+  EXPECT_EQ(Tracked::copies, 0);
+  EXPECT_EQ(Tracked::moves, 0);
+
+  auto err_result = Result<int, std::string>::emplace_err(3, 'x');
+
+  EXPECT_EQ(err_result.unwrap_err(), "xxx");
+
+  auto vec_result = Result<std::vector<int>, std::string>::emplace_ok(4, 1);
+
+  EXPECT_EQ(vec_result.unwrap().size(), 4u);
+}
+
+TEST_F(ResultTest, MoveOnlyPayload) {
+  auto result = Result<std::unique_ptr<int>, std::string>::Ok(
+      std::unique_ptr<int>(new int(5)));
+
+  ASSERT_TRUE(result.is_ok());
+  EXPECT_EQ(*result.unwrap(), 5);
+}
+
+TEST_F(ResultTest, SameOkAndErrType) {
+  auto ok_result = Result<int, int>::Ok(1);
+  auto err_result = Result<int, int>::Err(2);
+
+  EXPECT_TRUE(ok_result.is_ok());
+  EXPECT_EQ(ok_result.unwrap(), 1);
+  EXPECT_TRUE(err_result.is_err());
+  EXPECT_EQ(err_result.unwrap_err(), 2);
+}
+
+TEST_F(ResultTest, RvalueChainMovesPayload) {
+  Tracked::reset();
+  auto result = Result<Tracked, std::string>::emplace_ok(1)
+                    .map([](Tracked&& t) {
+                      t.value += 1;
+                      return std::move(t);
+                    })
+                    .and_then([](Tracked&& t) {
+                      t.value *= 10;
+                      return Result<Tracked, std::string>::Ok(std::move(t));
+                    })
+                    .map_err([](std::string&& e) { return e + "!"; });
+
+  EXPECT_EQ(result.unwrap().value, 20);
+  EXPECT_EQ(Tracked::copies, 0);
+}
+
+TEST_F(ResultTest, RvalueUnwrapMovesOut) {
+  Tracked::reset();
+  Tracked value = Result<Tracked, std::string>::emplace_ok(4).unwrap();
+
+  EXPECT_EQ(value.value, 4);
+  EXPECT_EQ(Tracked::copies, 0);
+
+  Tracked::reset();
+  Tracked fallback =
+      Result<Tracked, std::string>::Err("bad").unwrap_or(Tracked(6));
+
+  EXPECT_EQ(fallback.value, 6);
+  EXPECT_EQ(Tracked::copies, 0);
+
+  std::string error = Result<int, std::string>::Err("moved").unwrap_err();
+
+  EXPECT_EQ(error, "moved");
+}
+
+TEST_F(ResultTest, ConstCombinators) {
+  const auto result = Result<int, std::string>::Ok(21);
+
+  auto doubled = result.map([](const int& x) { return x * 2; });
+  auto chained = result.and_then(
+      [](const int& x) { return Result<int, std::string>::Ok(x + 1); });
+  auto mapped = result.map_err([](const std::string& e) { return e.size(); });
+
+  EXPECT_EQ(doubled.unwrap(), 42);
+  EXPECT_EQ(chained.unwrap(), 22);
+  EXPECT_EQ(mapped.unwrap(), 21);
+}
+
+TEST_F(ResultTest, LvalueCombinatorsMutate) {
+  auto result = Result<int, std::string>::Ok(1);
+
+  result.map([](int& x) { return ++x; });
+
+  EXPECT_EQ(result.unwrap(), 2);
+}
+
+TEST_F(ResultTest, TriviallyCopyablePayloads) {
+  enum class ErrorCode { kNotFound, kDenied };
+  using Small = Result<int, ErrorCode>;
+
+  static_assert(std::is_trivially_copyable<Small>::value,
+                "trivial payloads keep the Result trivially copyable");
+  static_assert(std::is_trivially_destructible<Small>::value, "");
+  static_assert(!std::is_trivially_copyable<Result<int>>::value,
+                "a std::string error needs a real copy");
+
+  Small ok = Small::Ok(3);
+  Small err = Small::Err(ErrorCode::kDenied);
+  Small copy = ok;
+  EXPECT_EQ(copy.unwrap(), 3);
+  copy = err;
+  ASSERT_TRUE(copy.is_err());
+  EXPECT_EQ(copy.unwrap_err(), ErrorCode::kDenied);
+}
+
+TEST_F(ResultTest, UnwrapUnchecked) {
+  Result<int> ok_result = Result<int>::Ok(8);
+  Result<int> err_result = Result<int>::Err("bad");
+
+  if (ok_result.is_ok()) {
+    ok_result.unwrap_unchecked() += 1;
+  }
+  EXPECT_EQ(ok_result.unwrap_unchecked(), 9);
+  EXPECT_EQ(err_result.unwrap_err_unchecked(), "bad");
+  EXPECT_EQ(std::move(err_result).unwrap_err_unchecked(), "bad");
+}
+
+TEST_F(ResultTest, EqualityAndHash) {
+  typedef Result<int, int> R;
+  EXPECT_TRUE(R::Ok(1) == R::Ok(1));
+  EXPECT_TRUE(R::Ok(1) != R::Err(1));
+  EXPECT_TRUE(R::Err(2) == R::Err(2));
+
+  std::hash<R> hash;
+  EXPECT_NE(hash(R::Ok(1)), hash(R::Err(1)));
+
+  std::unordered_set<Result<std::string, int> > seen;
+  seen.insert(Result<std::string, int>::Ok("a"));
+  seen.insert(Result<std::string, int>::Ok("a"));
+  seen.insert(Result<std::string, int>::Err(1));
+  EXPECT_EQ(seen.size(), 2u);
+}
+
+TEST_F(ResultTest, TryAssignPropagatesErr) {
+  after_try = 0;
+  EXPECT_EQ(doubled(21).unwrap(), 42);
+  EXPECT_EQ(after_try, 1);
+
+  Result<int, AppError> err = doubled(-1);
+  EXPECT_EQ(err.unwrap_err().context, "connection closed");
+  EXPECT_EQ(after_try, 1) << "returns before the rest of the function";
+}
+
+#if RUSTCXX_HAS_TRY_EXPRESSION
+TEST_F(ResultTest, TryExpression) {
+  EXPECT_EQ(sum_of(1, 2).unwrap(), 3);
+  EXPECT_EQ(sum_of(1, -2).unwrap_err().context, "connection closed");
+
+  EXPECT_EQ(first_even(Option<int>::Some(4)).unwrap(), 4);
+  EXPECT_TRUE(first_even(Option<int>::None()).is_none());
+}
+
+TEST_F(ResultTest, TryMovesWithoutCopies) {
+  Tracked::reset();
+  EXPECT_EQ(forward_tracked(Result<Tracked, Tracked>::Ok(Tracked(5)))
+                .unwrap()
+                .value,
+            5);
+  EXPECT_EQ(forward_tracked(Result<Tracked, Tracked>::Err(Tracked(6)))
+                .unwrap_err()
+                .value,
+            6);
+  EXPECT_EQ(Tracked::copies, 0);
+}
+#endif
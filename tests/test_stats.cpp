@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2025 Dapeng Feng
+ * All rights reserved.
+ */
+
+// Built with RUSTCXX_CONFIG_STATS=1: the core counts its hot paths
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rustcxx.hpp"
+#include "rustcxx_enum_vec.hpp"
+
+using namespace rust;  // NOLINT
+
+static_assert(RUSTCXX_CONFIG_STATS,
+              "this test is meant to be built with statistics");
+
+namespace {
+
+ENUM_VARIANT0(Ping);
+ENUM_VARIANT(Data, int size);
+ENUM_VARIANT0(Close);
+
+typedef Enum<Ping, Data, Close> Frame;
+typedef Result<int, std::string> Parsed;
+
+Parsed parse(int raw) {
+  return raw < 0 ? Parsed::Err("negative") : Parsed::Ok(raw);
+}
+
+}  // namespace
+
+class StatsTest : public ::testing::Test {
+ protected:
+  void SetUp() override { stats::reset(); }
+  void TearDown() override {}
+};
+
+TEST_F(StatsTest, CountsOkAndErr) {
+  for (int raw = -2; raw < 8; ++raw) {
+    parse(raw);
+  }
+
+  const stats::TypeStats entry = stats::of<Parsed>();
+  EXPECT_EQ(entry.type.find("rust::Result<int"), 0u) << entry.type;
+  EXPECT_EQ(entry.ok, 8u);
+  EXPECT_EQ(entry.err, 2u);
+  EXPECT_DOUBLE_EQ(entry.err_rate(), 0.2);
+  EXPECT_TRUE(entry.matches.empty());
+
+  bool listed = false;
+  for (const stats::TypeStats& other : stats::snapshot()) {
+    listed = listed || (other.ok == 8u && other.err == 2u);
+  }
+  EXPECT_TRUE(listed) << "snapshot() lists every type used";
+}
+
+TEST_F(StatsTest, CountsFailedUnwraps) {
+  EXPECT_THROW(parse(-1).unwrap(), std::runtime_error);
+  EXPECT_THROW(parse(1).unwrap_err(), std::runtime_error);
+  EXPECT_EQ(parse(1).unwrap(), 1);
+  EXPECT_THROW(Option<int>::None().unwrap(), std::runtime_error);
+  Frame frame = Ping();
+  EXPECT_THROW(frame.get<Data>(), std::runtime_error);
+  EXPECT_THROW(frame.get<2>(), std::runtime_error);
+
+  EXPECT_EQ(stats::of<Parsed>().panics, 2u);
+  EXPECT_EQ(stats::of<Option<int> >().panics, 1u);
+  EXPECT_EQ(stats::of<Frame>().panics, 2u);
+}
+
+TEST_F(StatsTest, CountsMatchesPerAlternative) {
+  std::vector<Frame> frames;
+  frames.push_back(Data{1});
+  frames.push_back(Data{2});
+  frames.push_back(Close());
+  frames.push_back(Data{3});
+
+  int bytes = 0;
+  for (const Frame& frame : frames) {
+    bytes += frame.match([](const Ping&) { return 0; },
+                         [](const Data& d) { return d.size; },
+                         [](const Close&) { return 0; });
+  }
+  match(frames[2], [](const Close&) {}, [](const Ping&) {},
+        [](const Data&) {});
+  EXPECT_EQ(bytes, 6);
+
+  const stats::TypeStats entry = stats::of<Frame>();
+  EXPECT_EQ(entry.matches, (std::vector<std::uint64_t>{0, 3, 2}));
+  EXPECT_EQ(entry.alternatives,
+            (std::vector<std::string>{"Ping", "Data", "Close"}));
+}
+
+TEST_F(StatsTest, LibraryDispatchIsNotAMatch) {
+  const Frame frame = Data{4};
+  const std::size_t first = std::hash<Frame>()(frame);
+  EXPECT_EQ(std::hash<Frame>()(frame), first);
+  EnumVec<Ping, Data, Close> frames;
+  frames.push_back(frame);
+  frames.push_back(Frame(Close()));
+
+  for (const std::uint64_t count : stats::of<Frame>().matches) {
+    EXPECT_EQ(count, 0u);
+  }
+}
+
+TEST_F(StatsTest, ResetAndThreads) {
+  parse(1);
+  stats::reset();
+  EXPECT_EQ(stats::of<Parsed>().ok, 0u);
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([] {
+      for (int i = 0; i < 1000; ++i) {
+        parse(i % 10 == 0 ? -1 : i);
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  const stats::TypeStats entry = stats::of<Parsed>();
+  EXPECT_EQ(entry.ok, 3600u);
+  EXPECT_EQ(entry.err, 400u);
+}
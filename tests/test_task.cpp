@@ -0,0 +1,225 @@
+/*
+ * Copyright (c) 2025 Dapeng Feng
+ * All rights reserved.
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <coroutine>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "rustcxx_task.hpp"
+
+using namespace rust;  // NOLINT
+
+namespace {
+
+enum class IoError : unsigned char { closed, timeout };
+
+// Error of a higher layer, built from the I/O error that caused it
+struct RequestError {
+  RequestError(IoError io) : cause(io) {}  // NOLINT
+  IoError cause;
+};
+
+// Local that counts live instances, to see frames being destroyed
+struct Guard {
+  static int live;
+
+  Guard() { ++live; }
+  Guard(const Guard&) = delete;
+  ~Guard() { --live; }
+};
+
+int Guard::live = 0;
+
+Result<int, IoError> parse(int raw) {
+  if (raw < 0) {
+    return Result<int, IoError>::Err(IoError::closed);
+  }
+  return Result<int, IoError>::Ok(raw * 2);
+}
+
+Task<Result<int, IoError> > read_value(int raw, int* steps) {
+  Guard guard;
+  const int value = co_await parse(raw);
+  ++*steps;
+  co_return Result<int, IoError>::Ok(value + 1);
+}
+
+Task<Result<std::string, RequestError> > handle_request(int raw, int* steps) {
+  const int value = co_await co_await read_value(raw, steps);
+  ++*steps;
+  co_return Result<std::string, RequestError>::Ok(std::to_string(value));
+}
+
+// Hops back onto the executor hops times before answering, so that
+// several of these interleave
+template <typename Executor>
+Task<Result<int, IoError> > slow_value(Executor& executor, int value,
+                                       int hops, std::vector<int>* finished) {
+  for (int i = 0; i < hops; ++i) {
+    co_await executor.schedule();
+  }
+  finished->push_back(value);
+  if (value < 0) {
+    co_return Result<int, IoError>::Err(IoError::timeout);
+  }
+  co_return Result<int, IoError>::Ok(value);
+}
+
+// Resumes the awaiting coroutine from a new thread, like an I/O
+// completion arriving on a thread of its own
+struct ForeignResume {
+  std::thread* thread;
+
+  bool await_ready() const noexcept { return false; }
+
+  void await_suspend(std::coroutine_handle<> h) {
+    *thread = std::thread([h] { h.resume(); });
+  }
+
+  void await_resume() const noexcept {}
+};
+
+}  // namespace
+
+class TaskTest : public ::testing::Test {
+ protected:
+  void SetUp() override { Guard::live = 0; }
+  void TearDown() override { EXPECT_EQ(Guard::live, 0); }
+};
+
+TEST_F(TaskTest, QuestionMarkReturnsErrEarly) {
+  SingleThreadExecutor executor;
+  int steps = 0;
+
+  Result<std::string, RequestError> ok =
+      executor.block_on(handle_request(20, &steps));
+  EXPECT_EQ(ok.unwrap(), "41");
+  EXPECT_EQ(steps, 2);
+
+  steps = 0;
+  Result<std::string, RequestError> err =
+      executor.block_on(handle_request(-1, &steps));
+  EXPECT_EQ(err.unwrap_err().cause, IoError::closed);
+  EXPECT_EQ(steps, 0) << "nothing after the failed co_await runs";
+}
+
+TEST_F(TaskTest, LazyUntilAwaited) {
+  int steps = 0;
+  {
+    Task<Result<int, IoError> > task = read_value(1, &steps);
+    EXPECT_EQ(Guard::live, 0);
+  }
+  EXPECT_EQ(steps, 0);
+}
+
+TEST_F(TaskTest, WhenAllCollectsInOrder) {
+  SingleThreadExecutor executor;
+  std::vector<int> finished;
+  std::vector<Task<Result<int, IoError> > > tasks;
+  tasks.push_back(slow_value(executor, 1, 3, &finished));
+  tasks.push_back(slow_value(executor, 2, 1, &finished));
+  tasks.push_back(slow_value(executor, 3, 2, &finished));
+
+  auto all = [](std::vector<Task<Result<int, IoError> > > children)
+      -> Task<Result<std::vector<int>, IoError> > {
+    co_return co_await when_all(std::move(children));
+  };
+  std::vector<int> values = executor.block_on(all(std::move(tasks))).unwrap();
+  EXPECT_EQ(values, (std::vector<int>{1, 2, 3}));
+  EXPECT_EQ(finished, (std::vector<int>{2, 3, 1})) << "children interleave";
+  EXPECT_EQ(executor.run(), 0u);
+}
+
+TEST_F(TaskTest, WhenAllShortCircuitsOnFirstErr) {
+  std::vector<int> finished;
+  {
+    SingleThreadExecutor executor;
+    std::vector<Task<Result<int, IoError> > > tasks;
+    tasks.push_back(slow_value(executor, 1, 10, &finished));
+    tasks.push_back(slow_value(executor, -1, 1, &finished));
+    tasks.push_back(slow_value(executor, 3, 10, &finished));
+
+    auto all = [](std::vector<Task<Result<int, IoError> > > children)
+        -> Task<Result<int, IoError> > {
+      std::vector<int> values =
+          co_await co_await when_all(std::move(children));
+      co_return Result<int, IoError>::Ok(static_cast<int>(values.size()));
+    };
+    Result<int, IoError> result = executor.block_on(all(std::move(tasks)));
+    EXPECT_EQ(result.unwrap_err(), IoError::timeout);
+    EXPECT_EQ(finished, (std::vector<int>{-1})) << "resumed at the first Err";
+  }
+
+  // The other children finish while the executor is destroyed
+  EXPECT_EQ(finished.size(), 3u);
+}
+
+TEST_F(TaskTest, CompletesOnForeignThread) {
+  for (int round = 0; round < 50; ++round) {
+    std::thread completer;
+    auto task = [](std::thread* thread) -> Task<Result<int, IoError> > {
+      co_await ForeignResume{thread};
+      co_return Result<int, IoError>::Ok(7);
+    };
+
+    std::unique_ptr<SingleThreadExecutor> executor(new SingleThreadExecutor);
+    EXPECT_EQ(executor->block_on(task(&completer)).unwrap(), 7);
+    // The completing thread may still be leaving block_on's wakeup
+    executor.reset();
+    completer.join();
+  }
+}
+
+TEST_F(TaskTest, ExceptionsReachTheAwaiter) {
+  SingleThreadExecutor executor;
+  auto failing = []() -> Task<Result<int, IoError> > {
+    throw std::runtime_error("boom");
+    co_return Result<int, IoError>::Ok(0);
+  };
+  EXPECT_THROW(executor.block_on(failing()), std::runtime_error);
+}
+
+TEST_F(TaskTest, WorkStealingRunsEveryTask) {
+  WorkStealingExecutor executor(4);
+  EXPECT_EQ(executor.size(), 4u);
+  std::atomic<int> hops(0);
+
+  auto worker = [&executor, &hops](int value) -> Task<Result<int, IoError> > {
+    for (int i = 0; i < 20; ++i) {
+      co_await executor.schedule();
+      hops.fetch_add(1, std::memory_order_relaxed);
+    }
+    co_return Result<int, IoError>::Ok(value);
+  };
+  auto all = [&worker](int count) -> Task<Result<long, IoError> > {
+    std::vector<Task<Result<int, IoError> > > children;
+    for (int i = 0; i < count; ++i) {
+      children.push_back(worker(i));
+    }
+    long sum = 0;
+    for (int value : co_await co_await when_all(std::move(children))) {
+      sum += value;
+    }
+    co_return Result<long, IoError>::Ok(sum);
+  };
+
+  EXPECT_EQ(executor.block_on(all(200)).unwrap(), 199L * 200 / 2);
+  EXPECT_EQ(hops.load(), 200 * 20);
+}
+
+TEST_F(TaskTest, FramesAreReused) {
+  void* first = detail::frame_pool::allocate(200);
+  detail::frame_pool::deallocate(first, 200);
+  void* second = detail::frame_pool::allocate(220);
+  EXPECT_EQ(first, second) << "same size class comes from the free list";
+  detail::frame_pool::deallocate(second, 220);
+}
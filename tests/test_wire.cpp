@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2025 Dapeng Feng
+ * All rights reserved.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "rustcxx_wire.hpp"
+
+using namespace rust;  // NOLINT
+
+namespace {
+
+ENUM_VARIANT1(Connect, std::string, address);
+ENUM_VARIANT2(Send, std::uint32_t, id, std::string, data);
+ENUM_VARIANT0(Disconnect);
+ENUM_VARIANT2(Resize, std::uint16_t, width, std::uint16_t, height);
+
+using NetworkMessage = Enum<Connect, Send, Disconnect, Resize>;
+
+ENUM_VARIANT2(Toggle, std::uint8_t, id, bool, on);
+
+struct Pixel {
+  std::uint8_t r, g, b, a;
+};
+
+}  // namespace
+
+template <>
+struct rust::wire::raw_bytes<Pixel> : std::true_type {};
+
+class WireTest : public ::testing::Test {
+ protected:
+  void SetUp() override {}
+  void TearDown() override {}
+};
+
+TEST_F(WireTest, Layout) {
+  NetworkMessage message = Send(0x01020304u, "hi");
+  char buffer[32];
+  const std::size_t size = wire::encode(message, buffer, sizeof(buffer)).unwrap();
+  ASSERT_EQ(size, wire::encoded_size(message));
+
+  const unsigned char expected[] = {1, 4, 3, 2, 1, 2, 0, 0, 0, 'h', 'i'};
+  ASSERT_EQ(size, sizeof(expected));
+  EXPECT_EQ(std::string(buffer, size),
+            std::string(reinterpret_cast<const char*>(expected), size));
+
+  EXPECT_EQ(wire::encoded_size(NetworkMessage(Disconnect())), 1u);
+  EXPECT_TRUE(wire::encode(message, buffer, 4).is_err());
+}
+
+TEST_F(WireTest, DecodeReturnsViews) {
+  static_assert(
+      std::is_same<wire::view_of_t<Send>, wire::record<Send> >::value, "");
+  static_assert(std::is_same<wire::view_of_t<Resize>, Resize>::value,
+                "string-free structs decode to themselves");
+
+  std::string buffer;
+  wire::encode_append(NetworkMessage(Send(7, "payload")), buffer);
+  wire::encode_append(NetworkMessage(Resize(640, 480)), buffer);
+
+  std::string_view input(buffer);
+  auto first = wire::decode_prefix<NetworkMessage>(input).unwrap();
+  ASSERT_TRUE(first.is<wire::record<Send> >());
+  const std::string_view data = first.get<wire::record<Send> >().get<1>();
+  EXPECT_EQ(data, "payload");
+  EXPECT_GE(data.data(), buffer.data());
+  EXPECT_LT(data.data(), buffer.data() + buffer.size());
+
+  auto second = wire::decode<NetworkMessage>(input).unwrap();
+  EXPECT_TRUE(second.get<Resize>() == Resize(640, 480));
+
+  const NetworkMessage owned = wire::to_owned<NetworkMessage>(first);
+  EXPECT_EQ(owned, NetworkMessage(Send(7, "payload")));
+}
+
+TEST_F(WireTest, OptionAndResultRoundTrip) {
+  typedef Result<Option<std::string>, std::int32_t> Reply;
+  const Reply values[] = {Reply::Ok(Option<std::string>::Some("found")),
+                          Reply::Ok(Option<std::string>::None()),
+                          Reply::Err(-5)};
+  for (const Reply& value : values) {
+    std::string buffer;
+    wire::encode_append(value, buffer);
+    auto view = wire::decode<Reply>(buffer).unwrap();
+    EXPECT_EQ(wire::to_owned<Reply>(view), value);
+  }
+}
+
+TEST_F(WireTest, MalformedInput) {
+  std::string buffer;
+  wire::encode_append(NetworkMessage(Connect{"example.org"}), buffer);
+
+  EXPECT_EQ(wire::decode<NetworkMessage>(std::string_view(buffer.data(), 3))
+                .unwrap_err(),
+            wire::Error::truncated);
+  EXPECT_EQ(wire::decode<NetworkMessage>(buffer + "x").unwrap_err(),
+            wire::Error::trailing_bytes);
+  buffer[0] = 9;
+  EXPECT_EQ(wire::decode<NetworkMessage>(buffer).unwrap_err(),
+            wire::Error::bad_discriminant);
+}
+
+TEST_F(WireTest, Segments) {
+  const NetworkMessage message = Send(1, "large body");
+  char scratch[16];
+  wire::segment segments[4];
+  const std::size_t count =
+      wire::encode_segments(message, scratch, sizeof(scratch), segments, 4)
+          .unwrap();
+  ASSERT_EQ(count, 2u);
+  EXPECT_EQ(segments[1].iov_base,
+            static_cast<const void*>(message.get<Send>().data.data()));
+
+  std::string joined;
+  for (std::size_t i = 0; i < count; ++i) {
+    joined.append(static_cast<const char*>(segments[i].iov_base),
+                  segments[i].iov_len);
+  }
+  std::string contiguous;
+  wire::encode_append(message, contiguous);
+  EXPECT_EQ(joined, contiguous);
+
+  EXPECT_TRUE(
+      wire::encode_segments(message, scratch, sizeof(scratch), segments, 1)
+          .is_err());
+}
+
+TEST_F(WireTest, RejectsBadBools) {
+  std::string buffer;
+  ASSERT_EQ(wire::encode_append(Toggle(3, true), buffer).unwrap(), 2u);
+  EXPECT_TRUE(wire::decode<Toggle>(buffer).unwrap() == Toggle(3, true));
+
+  buffer[1] = 7;
+  EXPECT_EQ(wire::decode<Toggle>(buffer).unwrap_err(), wire::Error::bad_value);
+  EXPECT_EQ(wire::decode<bool>(std::string_view("\x02", 1)).unwrap_err(),
+            wire::Error::bad_value);
+}
+
+TEST_F(WireTest, RawBytesStructs) {
+  const Pixel pixel = {1, 2, 3, 255};
+  std::string buffer;
+  ASSERT_EQ(wire::encode_append(pixel, buffer).unwrap(), sizeof(Pixel));
+  const Pixel decoded = wire::decode<Pixel>(buffer).unwrap();
+  EXPECT_EQ(decoded.b, 3);
+  EXPECT_EQ(decoded.a, 255);
+}
+
+TEST_F(WireTest, RejectsOversizedStrings) {
+  if (sizeof(std::size_t) <= sizeof(std::uint32_t)) {
+    GTEST_SKIP() << "strings cannot exceed a 32-bit length here";
+  }
+  // Never read: the length is checked before any byte is written
+  const char byte = 0;
+  const std::string_view huge(&byte, std::size_t(1) << 32);
+  char out[16];
+  EXPECT_EQ(wire::encode(huge, out, sizeof(out)).unwrap_err(),
+            wire::Error::too_large);
+
+  std::string buffer = "kept";
+  EXPECT_EQ(wire::encode_append(Option<std::string_view>::Some(huge), buffer)
+                .unwrap_err(),
+            wire::Error::too_large);
+  EXPECT_EQ(buffer, "kept");
+}